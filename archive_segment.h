@@ -0,0 +1,444 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <memory>
+#include <algorithm>
+#include <filesystem>
+#include <cstring>
+#include <cstdint>
+#include "crc32c.h"
+#include "durable_io.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Cold tier for closed academic years. A year's attendance is compacted into
+// one immutable segment file, memory-mapped and queried in place: the
+// student directory is binary searched and a student's marks are read as
+// run-length runs straight from the mapping, so nothing is deserialized and
+// a report touches only the pages of the students it asks about. The pages
+// are clean file pages the OS can drop at any time, so resident memory does
+// not grow with the number of archived years.
+//
+// Layout (little-endian, every field 32 bits, so each array is aligned in
+// the mapping):
+//   header    ArchiveHeader
+//   days      int32 day number per date with any mark, ascending
+//   students  ArchiveStudent per student, sorted by uniqueId
+//   runs      (length << 2) | state, state 0 absent, 1 present, 2 no mark
+//   remarks   ArchiveRemark per remark, sorted by student then date
+//   strings   uniqueIds and remark texts
+// A student's runs start at its first marked date and cover consecutive
+// entries of the days table. The header's CRC-32C covers everything after
+// the header; verify checks it. Opening checks the header, the sizes and
+// that every directory, run and remark entry stays inside its table, so a
+// damaged segment is rejected rather than read out of bounds.
+
+const char ARCHIVE_MAGIC[4] = {'A', 'T', 'S', 'G'};
+const uint32_t ARCHIVE_VERSION = 1;
+const uint32_t ARCHIVE_ABSENT = 0, ARCHIVE_PRESENT = 1, ARCHIVE_NO_MARK = 2;
+
+struct ArchiveHeader {
+    char magic[4];
+    uint32_t version;
+    int32_t firstDay;  // the closed year's bounds, as day numbers
+    int32_t lastDay;
+    uint32_t dayCount;
+    uint32_t studentCount;
+    uint32_t runCount;
+    uint32_t remarkCount;
+    uint32_t stringBytes;
+    uint32_t bodyCrc;
+};
+
+struct ArchiveStudent {
+    uint32_t idOffset;
+    uint32_t idLength;
+    uint32_t firstDayIndex;
+    uint32_t firstRun;
+    uint32_t runCount;
+    uint32_t present;   // totals for the whole year
+    uint32_t recorded;
+};
+
+struct ArchiveRemark {
+    uint32_t student;
+    uint32_t dayIndex;
+    uint32_t textOffset;
+    uint32_t textLength;
+};
+
+static_assert(sizeof(ArchiveHeader) == 40 && sizeof(ArchiveStudent) == 28 && sizeof(ArchiveRemark) == 16,
+              "archive records are written as raw structs");
+
+// Writer input: one student's marks for the year, sorted by day
+struct ArchiveMark {
+    int32_t day;
+    bool present;
+    string remark;
+};
+
+struct ArchiveStudentMarks {
+    string uniqueId;
+    vector<ArchiveMark> marks;
+};
+
+// Read-only mapping of a whole file
+class MappedFile {
+private:
+    const char* bytes = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#endif
+
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { close(); }
+
+    bool open(const string& path, string& error) {
+        close();
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                           FILE_ATTRIBUTE_NORMAL, nullptr);
+        LARGE_INTEGER size;
+        if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+            error = "Could not open " + path;
+            close();
+            return false;
+        }
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        bytes = mapping ? (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        length = (size_t)size.QuadPart;
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        struct stat info;
+        if (fd < 0 || fstat(fd, &info) != 0 || info.st_size == 0) {
+            if (fd >= 0) ::close(fd);
+            error = "Could not open " + path;
+            return false;
+        }
+        void* mapped = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);  // the mapping keeps the file open
+        bytes = mapped == MAP_FAILED ? nullptr : (const char*)mapped;
+        length = (size_t)info.st_size;
+#endif
+        if (!bytes) {
+            error = "Could not map " + path;
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (bytes) UnmapViewOfFile(bytes);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+        mapping = nullptr;
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (bytes) munmap((void*)bytes, length);
+#endif
+        bytes = nullptr;
+        length = 0;
+    }
+
+    const char* data() const { return bytes; }
+    size_t size() const { return length; }
+};
+
+class ArchiveSegment {
+private:
+    MappedFile file;
+    const ArchiveHeader* header = nullptr;
+    const int32_t* days = nullptr;
+    const ArchiveStudent* students = nullptr;
+    const uint32_t* runs = nullptr;
+    const ArchiveRemark* remarks = nullptr;
+    const char* strings = nullptr;
+
+    // Every offset the readers follow, checked against the header's counts
+    bool entriesInBounds() const {
+        for (uint32_t i = 0; i < header->studentCount; i++) {
+            const ArchiveStudent& entry = students[i];
+            if ((uint64_t)entry.idOffset + entry.idLength > header->stringBytes ||
+                (uint64_t)entry.firstRun + entry.runCount > header->runCount ||
+                entry.firstDayIndex > header->dayCount) {
+                return false;
+            }
+            uint64_t covered = entry.firstDayIndex;
+            for (uint32_t r = 0; r < entry.runCount; r++) covered += runs[entry.firstRun + r] >> 2;
+            if (covered > header->dayCount) return false;
+        }
+        for (uint32_t i = 0; i < header->remarkCount; i++) {
+            const ArchiveRemark& remark = remarks[i];
+            if (remark.student >= header->studentCount || remark.dayIndex >= header->dayCount ||
+                (uint64_t)remark.textOffset + remark.textLength > header->stringBytes) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Index of day in the days table, or -1
+    long dayIndex(int day) const {
+        const int32_t* end = days + header->dayCount;
+        const int32_t* it = lower_bound(days, end, day);
+        return it != end && *it == day ? (long)(it - days) : -1;
+    }
+
+public:
+    // Maps the file and checks its header and section sizes
+    bool open(const string& path, string& error) {
+        if (!file.open(path, error)) return false;
+        header = (const ArchiveHeader*)file.data();
+        if (file.size() < sizeof(ArchiveHeader) || memcmp(header->magic, ARCHIVE_MAGIC, 4) != 0 ||
+            header->version != ARCHIVE_VERSION) {
+            error = path + " is not an archive segment";
+            file.close();
+            return false;
+        }
+        uint64_t expected = sizeof(ArchiveHeader) + 4ull * header->dayCount +
+                            (uint64_t)sizeof(ArchiveStudent) * header->studentCount + 4ull * header->runCount +
+                            (uint64_t)sizeof(ArchiveRemark) * header->remarkCount + header->stringBytes;
+        if (expected != file.size()) {
+            error = path + " is truncated or damaged";
+            file.close();
+            return false;
+        }
+        const char* at = file.data() + sizeof(ArchiveHeader);
+        days = (const int32_t*)at;
+        at += 4ull * header->dayCount;
+        students = (const ArchiveStudent*)at;
+        at += sizeof(ArchiveStudent) * (size_t)header->studentCount;
+        runs = (const uint32_t*)at;
+        at += 4ull * header->runCount;
+        remarks = (const ArchiveRemark*)at;
+        at += sizeof(ArchiveRemark) * (size_t)header->remarkCount;
+        strings = at;
+        if (!entriesInBounds()) {
+            error = path + " is damaged: an entry points outside its table";
+            file.close();
+            return false;
+        }
+        return true;
+    }
+
+    // Reads the whole segment and checks it against the header's CRC-32C
+    bool verify() const {
+        string_view body(file.data() + sizeof(ArchiveHeader), file.size() - sizeof(ArchiveHeader));
+        return crc32c(body) == header->bodyCrc;
+    }
+
+    int firstDay() const { return header->firstDay; }
+    int lastDay() const { return header->lastDay; }
+    size_t studentCount() const { return header->studentCount; }
+    size_t bytes() const { return file.size(); }
+    const ArchiveStudent& student(size_t index) const { return students[index]; }
+    string_view idOf(const ArchiveStudent& entry) const { return string_view(strings + entry.idOffset, entry.idLength); }
+
+    const ArchiveStudent* find(string_view uniqueId) const {
+        const ArchiveStudent* end = students + header->studentCount;
+        const ArchiveStudent* it = lower_bound(students, end, uniqueId, [this](const ArchiveStudent& entry, string_view id) {
+            return idOf(entry) < id;
+        });
+        return it != end && idOf(*it) == uniqueId ? it : nullptr;
+    }
+
+    // Calls visit(day, present) for each mark, oldest first
+    template <typename Visit>
+    void forEachMark(const ArchiveStudent& entry, Visit visit) const {
+        uint32_t index = entry.firstDayIndex;
+        for (uint32_t r = 0; r < entry.runCount; r++) {
+            uint32_t run = runs[entry.firstRun + r];
+            uint32_t length = run >> 2, state = run & 3;
+            if (state != ARCHIVE_NO_MARK) {
+                for (uint32_t i = 0; i < length; i++) visit(days[index + i], state == ARCHIVE_PRESENT);
+            }
+            index += length;
+        }
+    }
+
+    // Marks between two day numbers (inclusive); a whole-year range uses the stored totals
+    void count(const ArchiveStudent& entry, int fromDay, int toDay, uint32_t& present, uint32_t& recorded) const {
+        if (fromDay <= header->firstDay && toDay >= header->lastDay) {
+            present = entry.present;
+            recorded = entry.recorded;
+            return;
+        }
+        present = recorded = 0;
+        uint32_t index = entry.firstDayIndex;
+        for (uint32_t r = 0; r < entry.runCount && index < header->dayCount && days[index] <= toDay; r++) {
+            uint32_t run = runs[entry.firstRun + r];
+            uint32_t length = run >> 2, state = run & 3;
+            if (state != ARCHIVE_NO_MARK) {
+                const int32_t* first = lower_bound(days + index, days + index + length, fromDay);
+                const int32_t* last = upper_bound(first, days + index + length, toDay);
+                uint32_t inRange = (uint32_t)(last - first);
+                recorded += inRange;
+                if (state == ARCHIVE_PRESENT) present += inRange;
+            }
+            index += length;
+        }
+    }
+
+    // 1 present, 0 absent, -1 no mark that day
+    int statusOn(const ArchiveStudent& entry, int day) const {
+        long target = dayIndex(day);
+        if (target < (long)entry.firstDayIndex) return -1;
+        uint32_t index = entry.firstDayIndex;
+        for (uint32_t r = 0; r < entry.runCount; r++) {
+            uint32_t run = runs[entry.firstRun + r];
+            if (target < (long)(index + (run >> 2))) return (run & 3) == ARCHIVE_NO_MARK ? -1 : (int)(run & 3);
+            index += run >> 2;
+        }
+        return -1;
+    }
+
+    // Calls visit(day, text) for each remark of the student, oldest first
+    template <typename Visit>
+    void forEachRemark(const ArchiveStudent& entry, Visit visit) const {
+        uint32_t number = (uint32_t)(&entry - students);
+        const ArchiveRemark* end = remarks + header->remarkCount;
+        const ArchiveRemark* it = lower_bound(remarks, end, number,
+                                              [](const ArchiveRemark& remark, uint32_t s) { return remark.student < s; });
+        for (; it != end && it->student == number; ++it) {
+            visit(days[it->dayIndex], string_view(strings + it->textOffset, it->textLength));
+        }
+    }
+};
+
+// Writes a year's segment durably (temp file, sync, rename, directory sync).
+// students may be in any order; each one's marks must be sorted by day.
+inline bool writeArchiveSegment(const string& path, int firstDay, int lastDay, vector<ArchiveStudentMarks> students,
+                                string& error) {
+    sort(students.begin(), students.end(),
+         [](const ArchiveStudentMarks& a, const ArchiveStudentMarks& b) { return a.uniqueId < b.uniqueId; });
+
+    vector<int32_t> days;
+    for (const auto& student : students) {
+        for (const auto& mark : student.marks) days.push_back(mark.day);
+    }
+    sort(days.begin(), days.end());
+    days.erase(unique(days.begin(), days.end()), days.end());
+    auto indexOf = [&](int day) { return (uint32_t)(lower_bound(days.begin(), days.end(), day) - days.begin()); };
+
+    vector<ArchiveStudent> directory;
+    vector<uint32_t> runs;
+    vector<ArchiveRemark> remarks;
+    string strings;
+    unordered_map<string, uint32_t> remarkTexts;  // remarks repeat, so each text is stored once
+    for (const auto& student : students) {
+        ArchiveStudent entry = {(uint32_t)strings.size(), (uint32_t)student.uniqueId.size(), 0,
+                                (uint32_t)runs.size(), 0, 0, 0};
+        strings += student.uniqueId;
+        uint32_t next = student.marks.empty() ? 0 : indexOf(student.marks.front().day);
+        entry.firstDayIndex = next;
+        auto append = [&](uint32_t state, uint32_t length) {
+            if (runs.size() > entry.firstRun && (runs.back() & 3) == state) runs.back() += length << 2;
+            else runs.push_back(length << 2 | state);
+        };
+        for (const auto& mark : student.marks) {
+            uint32_t index = indexOf(mark.day);
+            if (index > next) append(ARCHIVE_NO_MARK, index - next);
+            append(mark.present ? ARCHIVE_PRESENT : ARCHIVE_ABSENT, 1);
+            next = index + 1;
+            entry.recorded++;
+            if (mark.present) entry.present++;
+            if (!mark.remark.empty()) {
+                auto text = remarkTexts.try_emplace(mark.remark, (uint32_t)strings.size());
+                if (text.second) strings += mark.remark;
+                remarks.push_back({(uint32_t)directory.size(), index, text.first->second, (uint32_t)mark.remark.size()});
+            }
+        }
+        entry.runCount = (uint32_t)runs.size() - entry.firstRun;
+        directory.push_back(entry);
+    }
+
+    string body;
+    body.append((const char*)days.data(), days.size() * sizeof(int32_t));
+    body.append((const char*)directory.data(), directory.size() * sizeof(ArchiveStudent));
+    body.append((const char*)runs.data(), runs.size() * sizeof(uint32_t));
+    body.append((const char*)remarks.data(), remarks.size() * sizeof(ArchiveRemark));
+    body += strings;
+
+    ArchiveHeader header;
+    memcpy(header.magic, ARCHIVE_MAGIC, 4);
+    header.version = ARCHIVE_VERSION;
+    header.firstDay = firstDay;
+    header.lastDay = lastDay;
+    header.dayCount = (uint32_t)days.size();
+    header.studentCount = (uint32_t)directory.size();
+    header.runCount = (uint32_t)runs.size();
+    header.remarkCount = (uint32_t)remarks.size();
+    header.stringBytes = (uint32_t)strings.size();
+    header.bodyCrc = crc32c(body);
+
+    string content((const char*)&header, sizeof(header));
+    content += body;
+    filesystem::path target(path);
+    error_code code;
+    if (target.has_parent_path()) filesystem::create_directories(target.parent_path(), code);
+    if (!writeDurableTemp(path, content, error) || !commitDurableTemp(path, error)) return false;
+    syncDirectory(target.parent_path().string());
+    return true;
+}
+
+// The archived years: one segment per academic year, named year_<start year>.seg,
+// mapped the first time a query needs it
+class ArchiveTier {
+private:
+    string root;
+    map<int, unique_ptr<ArchiveSegment>> opened;
+
+public:
+    explicit ArchiveTier(const string& archiveRoot) : root(archiveRoot) {}
+
+    const string& directory() const { return root; }
+    string pathFor(int year) const { return root + "/year_" + to_string(year) + ".seg"; }
+
+    // Start years with a segment on disk, ascending
+    vector<int> years() const {
+        vector<int> found;
+        error_code code;
+        for (const auto& entry : filesystem::directory_iterator(root, code)) {
+            string name = entry.path().filename().string();
+            if (name.starts_with("year_") && name.ends_with(".seg")) found.push_back(atoi(name.c_str() + 5));
+        }
+        sort(found.begin(), found.end());
+        return found;
+    }
+
+    // The year's segment, mapped on first use; nullptr (with error set) when
+    // it is missing or damaged
+    const ArchiveSegment* segment(int year, string& error) {
+        unique_ptr<ArchiveSegment>& segment = opened[year];
+        if (!segment) {
+            auto candidate = make_unique<ArchiveSegment>();
+            if (!candidate->open(pathFor(year), error)) {
+                opened.erase(year);
+                return nullptr;
+            }
+            segment = move(candidate);
+        }
+        return segment.get();
+    }
+
+    // Unmaps a segment, e.g. before its file is replaced
+    void close(int year) { opened.erase(year); }
+
+    size_t mappedCount() const { return opened.size(); }
+};
@@ -0,0 +1,244 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <memory_resource>
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+#include <cstdint>
+#include "string_pool.h"
+
+// Per-section bump allocator plus the flat containers Student keeps in it.
+// A loaded class-section takes a few large chunks instead of a heap block
+// per map node, and evicting the section frees every chunk at once.
+
+class SectionArena : public pmr::memory_resource {
+private:
+    static const size_t MIN_CHUNK = 4 * 1024;
+    static const size_t MAX_CHUNK = 1024 * 1024;
+
+    vector<pair<unique_ptr<char[]>, size_t>> chunks;
+    char* cursor = nullptr;
+    char* limit = nullptr;
+    char* lastBlock = nullptr;     // most recent allocation, which can be rolled back
+    size_t nextChunk;
+    size_t used = 0;
+    size_t reserved = 0;
+    size_t abandoned = 0;          // freed blocks that could not be reclaimed
+
+    void addChunk(size_t minimum) {
+        size_t size = max(nextChunk, minimum);
+        chunks.push_back({make_unique<char[]>(size), size});
+        cursor = chunks.back().first.get();
+        limit = cursor + size;
+        lastBlock = nullptr;
+        reserved += size;
+        nextChunk = min(nextChunk * 2, MAX_CHUNK);
+    }
+
+protected:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        size_t padding = (alignment - reinterpret_cast<uintptr_t>(cursor) % alignment) % alignment;
+        if (!cursor || padding + bytes > (size_t)(limit - cursor)) {
+            addChunk(bytes + alignment);
+            padding = (alignment - reinterpret_cast<uintptr_t>(cursor) % alignment) % alignment;
+        }
+        lastBlock = cursor + padding;
+        cursor = lastBlock + bytes;
+        used += padding + bytes;
+        return lastBlock;
+    }
+
+    void do_deallocate(void* pointer, size_t bytes, size_t) override {
+        if (pointer == lastBlock && lastBlock + bytes == cursor) {
+            cursor = lastBlock;
+            used -= bytes;
+            lastBlock = nullptr;
+        } else {
+            abandoned += bytes;
+        }
+    }
+
+    bool do_is_equal(const pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+public:
+    // sizeHint sizes the first chunk, e.g. from the size of the file being loaded
+    explicit SectionArena(size_t sizeHint = 0) : nextChunk(min(max(sizeHint, MIN_CHUNK), MAX_CHUNK)) {}
+
+    SectionArena(const SectionArena&) = delete;
+    SectionArena& operator=(const SectionArena&) = delete;
+
+    size_t usedBytes() const { return used; }
+    size_t reservedBytes() const { return reserved; }
+    size_t abandonedBytes() const { return abandoned; }
+    size_t chunkCount() const { return chunks.size(); }
+    const vector<pair<unique_ptr<char[]>, size_t>>& getChunks() const { return chunks; }
+};
+
+// Ten characters of an ISO date ("YYYY-MM-DD") stored inline; byte order
+// matches std::string ordering, so containers stay in date order
+struct DateKey {
+    static const size_t LENGTH = 10;
+    char text[LENGTH];
+
+    DateKey() { memset(text, 0, LENGTH); }
+    explicit DateKey(string_view date) {
+        memset(text, 0, LENGTH);
+        memcpy(text, date.data(), min(date.size(), LENGTH));
+    }
+
+    string str() const { return string(text, strnlen(text, LENGTH)); }
+    bool operator<(const DateKey& other) const { return memcmp(text, other.text, LENGTH) < 0; }
+    bool operator==(const DateKey& other) const { return memcmp(text, other.text, LENGTH) == 0; }
+};
+
+// Sorted vector keyed by date. Iterating yields {first: date string, second: value}
+// like the std::map it replaces.
+template <typename V>
+class FlatDateMap {
+public:
+    struct Entry {
+        DateKey key;
+        V value;
+    };
+
+    struct View {
+        string first;
+        const V& second;
+    };
+
+    class const_iterator {
+    private:
+        const Entry* at;
+
+    public:
+        explicit const_iterator(const Entry* entry) : at(entry) {}
+        View operator*() const { return {at->key.str(), at->value}; }
+        const_iterator& operator++() { ++at; return *this; }
+        bool operator==(const const_iterator& other) const { return at == other.at; }
+        bool operator!=(const const_iterator& other) const { return at != other.at; }
+    };
+
+private:
+    pmr::vector<Entry> entries;
+
+    typename pmr::vector<Entry>::iterator position(const DateKey& key) {
+        if (entries.empty() || entries.back().key < key) return entries.end();  // the common append
+        return lower_bound(entries.begin(), entries.end(), key,
+                           [](const Entry& entry, const DateKey& k) { return entry.key < k; });
+    }
+
+    template <typename T>
+    V makeValue(T&& value) {
+        if constexpr (is_same_v<V, pmr::string>) return V(string_view(value), entries.get_allocator());
+        else return V(std::forward<T>(value));
+    }
+
+public:
+    explicit FlatDateMap(pmr::memory_resource* resource = pmr::get_default_resource()) : entries(resource) {}
+
+    template <typename T>
+    void assign(string_view date, T&& value) {
+        DateKey key(date);
+        auto it = position(key);
+        if (it != entries.end() && it->key == key) it->value = makeValue(std::forward<T>(value));
+        else entries.insert(it, Entry{key, makeValue(std::forward<T>(value))});
+    }
+
+    const V* lookup(string_view date) const {
+        DateKey key(date);
+        auto it = lower_bound(entries.begin(), entries.end(), key,
+                              [](const Entry& entry, const DateKey& k) { return entry.key < k; });
+        return (it != entries.end() && it->key == key) ? &it->value : nullptr;
+    }
+
+    const V& at(string_view date) const {
+        const V* value = lookup(date);
+        if (!value) throw out_of_range("FlatDateMap::at");
+        return *value;
+    }
+
+    size_t count(string_view date) const { return lookup(date) ? 1 : 0; }
+
+    // Removes the entries dated first..last inclusive; returns how many
+    size_t eraseBetween(string_view first, string_view last) {
+        auto less = [](const Entry& entry, const DateKey& k) { return entry.key < k; };
+        auto from = lower_bound(entries.begin(), entries.end(), DateKey(first), less);
+        auto to = upper_bound(from, entries.end(), DateKey(last),
+                              [](const DateKey& k, const Entry& entry) { return k < entry.key; });
+        size_t removed = (size_t)(to - from);
+        entries.erase(from, to);
+        return removed;
+    }
+    size_t size() const { return entries.size(); }
+    bool empty() const { return entries.empty(); }
+    void reserve(size_t n) { entries.reserve(n); }
+    void clear() { entries.clear(); }
+
+    const_iterator begin() const { return const_iterator(entries.data()); }
+    const_iterator end() const { return const_iterator(entries.data() + entries.size()); }
+    const pmr::vector<Entry>& raw() const { return entries; }
+};
+
+// Small sorted map keyed by a StringPool id, ordered by the string itself so
+// iteration matches std::map<string, V>
+template <typename V>
+class FlatIdMap {
+public:
+    struct View {
+        const string& first;
+        const V& second;
+    };
+
+    class const_iterator {
+    private:
+        const pair<uint32_t, V>* at;
+
+    public:
+        explicit const_iterator(const pair<uint32_t, V>* entry) : at(entry) {}
+        View operator*() const { return {stringPool().get(at->first), at->second}; }
+        const_iterator& operator++() { ++at; return *this; }
+        bool operator==(const const_iterator& other) const { return at == other.at; }
+        bool operator!=(const const_iterator& other) const { return at != other.at; }
+    };
+
+private:
+    pmr::vector<pair<uint32_t, V>> entries;
+
+public:
+    explicit FlatIdMap(pmr::memory_resource* resource = pmr::get_default_resource()) : entries(resource) {}
+
+    void assign(const string& keyText, const V& value) {
+        uint32_t id = stringPool().intern(keyText);
+        auto it = lower_bound(entries.begin(), entries.end(), keyText,
+                              [](const pair<uint32_t, V>& entry, const string& k) {
+                                  return stringPool().get(entry.first) < k;
+                              });
+        if (it != entries.end() && it->first == id) it->second = value;
+        else entries.insert(it, {id, value});
+    }
+
+    const V* lookup(const string& keyText) const {
+        uint32_t id;
+        if (!stringPool().lookup(keyText, id)) return nullptr;
+        for (const auto& entry : entries) {
+            if (entry.first == id) return &entry.second;
+        }
+        return nullptr;
+    }
+
+    const V& at(const string& keyText) const {
+        const V* value = lookup(keyText);
+        if (!value) throw out_of_range("FlatIdMap::at");
+        return *value;
+    }
+
+    size_t size() const { return entries.size(); }
+    bool empty() const { return entries.empty(); }
+
+    const_iterator begin() const { return const_iterator(entries.data()); }
+    const_iterator end() const { return const_iterator(entries.data() + entries.size()); }
+    const pmr::vector<pair<uint32_t, V>>& raw() const { return entries; }
+};
@@ -0,0 +1,459 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <filesystem>
+#include <cstdlib>
+#include <cstdint>
+#include "crc32c.h"
+#include "durable_io.h"
+
+// Versioned attendance. Once history has started, every change to a live
+// mark is logged with a sequence number and the time it was made, so a
+// report can be rebuilt as it stood at any earlier moment, before later
+// corrections. Marks moved to the archive and ids changed at rollover are
+// logged too, since they change what the live reports show.
+//
+// A query needs each student's present and recorded counts as of a time.
+// Every HISTORY_SNAPSHOT_EVERY changes the counts of every student are
+// written to a snapshot and a new log is started, so a query reads the
+// newest snapshot at or before its time and replays at most one log.
+//
+// Under the history root:
+//   snapshot_<seq>.csv  "snapshot:<seq>,<time>", one "<uniqueId>,<present>,<recorded>"
+//                       line per student, then "crc:<hex>" of everything before it
+//   changes_<seq>.log   the changes after snapshot <seq>, one per line:
+//                       <seq>,<time>,M,<uniqueId>,<date>,<before>,<after>,<crc>
+//                       <seq>,<time>,A,<uniqueId>,<present>,<recorded>,,<crc>
+//                       <seq>,<time>,R,<old id>,<new id>,,,<crc>
+//   joined.log          <seq>,<time>,J,<uniqueId>,<present>,<recorded>,,<crc>
+// M sets or corrects a mark (1 present, 0 absent, -1 none), A moves marks
+// to the archive, R renames a student (an empty new id: left the school).
+// The crc is the CRC-32C of the line before its last comma; the loader
+// trims a torn tail left by a crash.
+//
+// Snapshot 0 holds the counts of the students loaded when history started;
+// nothing earlier can be queried. Sections are loaded lazily, so a student
+// of a section loaded later joins history then (J). Marks are only changed
+// in loaded sections, so the counts a student joins with are the counts it
+// had when history started, and a join applies to every query whatever its
+// time. Joins are kept in their own file so a query finds them without
+// reading every log.
+//
+// A snapshot that fails its CRC is skipped: the counts come from the newest
+// readable snapshot before it plus every log since. With no readable
+// snapshot, or a damaged line anywhere but the tail of the newest log or
+// the join file, history is marked damaged; it then stops logging and
+// answers no queries rather than build on counts it cannot trust.
+
+const uint64_t HISTORY_SNAPSHOT_EVERY = 4096;
+
+struct AttendanceCounts {
+    int present = 0;
+    int recorded = 0;
+
+    float percentage() const { return recorded > 0 ? (float)present / recorded * 100 : 0.0f; }
+};
+
+using AttendanceCountMap = unordered_map<string, AttendanceCounts>;  // uniqueId -> counts
+
+class AttendanceHistory {
+private:
+    struct Snapshot {
+        uint64_t sequence;
+        int64_t time;
+    };
+
+    struct Join {
+        uint64_t sequence;
+        string line;
+    };
+
+    string root;
+    bool opened = false;
+    vector<Snapshot> snapshots;  // oldest first
+    AttendanceCountMap current;  // as of the newest change
+    uint64_t nextSequence = 1;
+    int64_t lastTime = 0;
+    vector<Join> joins;          // every join, in sequence order
+    string pending;              // changes not yet appended to the log
+    size_t pendingCount = 0;
+    string pendingJoins;         // joins not yet appended to the join file
+    string damage;               // why history cannot be used; empty when it can
+
+    string snapshotPath(uint64_t sequence) const { return root + "/snapshot_" + to_string(sequence) + ".csv"; }
+    string logPath(uint64_t sequence) const { return root + "/changes_" + to_string(sequence) + ".log"; }
+    string joinPath() const { return root + "/joined.log"; }
+
+    static string readAll(const string& path) {
+        ifstream in(path, ios::binary);
+        if (!in.is_open()) return string();
+        return string(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+    }
+
+    // Parses one log line, checks its CRC and applies it to counts
+    static bool apply(AttendanceCountMap& counts, string_view line, uint64_t& sequence, int64_t& time,
+                      int64_t asOf = INT64_MAX) {
+        size_t last = line.rfind(',');
+        if (last == string_view::npos) return false;
+        string_view body = line.substr(0, last);
+        if (crc32cHex(crc32c(body)) != line.substr(last + 1)) return false;
+        vector<string> fields;
+        string field;
+        istringstream in{string(body)};
+        while (getline(in, field, ',')) fields.push_back(field);
+        while (fields.size() < 7) fields.push_back("");
+        if (fields[2].size() != 1) return false;
+
+        sequence = strtoull(fields[0].c_str(), nullptr, 10);
+        time = strtoll(fields[1].c_str(), nullptr, 10);
+        if (time > asOf) return true;
+        switch (fields[2][0]) {
+            case 'M': {
+                AttendanceCounts& entry = counts[fields[3]];
+                int before = atoi(fields[5].c_str()), after = atoi(fields[6].c_str());
+                if (before >= 0) entry.recorded--, entry.present -= before;
+                if (after >= 0) entry.recorded++, entry.present += after;
+                return true;
+            }
+            case 'A': {
+                AttendanceCounts& entry = counts[fields[3]];
+                entry.present -= atoi(fields[4].c_str());
+                entry.recorded -= atoi(fields[5].c_str());
+                return true;
+            }
+            case 'J': {
+                AttendanceCounts& entry = counts[fields[3]];
+                entry.present += atoi(fields[4].c_str());
+                entry.recorded += atoi(fields[5].c_str());
+                return true;
+            }
+            case 'R': {
+                auto found = counts.find(fields[3]);
+                if (found == counts.end()) return true;
+                AttendanceCounts moved = found->second;
+                counts.erase(found);
+                if (!fields[4].empty()) {
+                    AttendanceCounts& entry = counts[fields[4]];
+                    entry.present += moved.present;
+                    entry.recorded += moved.recorded;
+                }
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Reads a snapshot's counts; false when it is missing or fails its CRC
+    bool readSnapshot(uint64_t sequence, AttendanceCountMap& counts, string& error) const {
+        string content = readAll(snapshotPath(sequence));
+        size_t crcLine = content.rfind("crc:");
+        if (crcLine == string::npos || (crcLine > 0 && content[crcLine - 1] != '\n') ||
+            crc32cHex(crc32c(string_view(content).substr(0, crcLine))) != content.substr(crcLine + 4, 8)) {
+            error = "Attendance history snapshot is damaged: " + snapshotPath(sequence);
+            return false;
+        }
+        counts.clear();
+        istringstream lines(content.substr(0, crcLine));
+        string line;
+        getline(lines, line);  // header
+        while (getline(lines, line)) {
+            size_t first = line.find(','), second = line.find(',', first + 1);
+            if (first == string::npos || second == string::npos) continue;
+            AttendanceCounts& entry = counts[line.substr(0, first)];
+            entry.present = atoi(line.c_str() + first + 1);
+            entry.recorded = atoi(line.c_str() + second + 1);
+        }
+        return true;
+    }
+
+    bool writeSnapshot(uint64_t sequence, int64_t time, string& error) {
+        ostringstream out;
+        out << "snapshot:" << sequence << "," << time << "\n";
+        vector<const AttendanceCountMap::value_type*> rows;
+        for (const auto& entry : current) rows.push_back(&entry);
+        sort(rows.begin(), rows.end(), [](auto* a, auto* b) { return a->first < b->first; });
+        for (const auto* entry : rows) {
+            out << entry->first << "," << entry->second.present << "," << entry->second.recorded << "\n";
+        }
+        string content = out.str();
+        content += "crc:" + crc32cHex(crc32c(content)) + "\n";
+        string path = snapshotPath(sequence);
+        if (!writeDurableTemp(path, content, error) || !commitDurableTemp(path, error)) return false;
+        syncDirectory(root);
+        snapshots.push_back({sequence, time});
+        return true;
+    }
+
+    // Counts as of asOf, up to and including snapshot `last`: the newest
+    // readable snapshot at or before it, then the logs of every snapshot from
+    // there through `last`, with the joins the snapshot does not hold. Only
+    // the newest log may end in a torn line; logEnd is where the replay
+    // stopped in it, so open() can trim the tail.
+    bool replay(size_t last, int64_t asOf, AttendanceCountMap& counts, uint64_t& sequence, int64_t& time,
+                size_t& logEnd, string& error) const {
+        size_t base = last + 1;
+        while (base > 0 && !readSnapshot(snapshots[base - 1].sequence, counts, error)) base--;
+        if (base == 0) return false;
+        base--;
+        sequence = snapshots[base].sequence;
+        time = snapshots[base].time;
+
+        // A join goes in before the changes logged after it, which may rename
+        // the student it joined
+        auto join = upper_bound(joins.begin(), joins.end(), sequence, [](uint64_t value, const Join& entry) {
+            return value < entry.sequence;
+        });
+        auto applyJoins = [&](uint64_t before) {
+            for (; join != joins.end() && join->sequence < before; ++join) {
+                uint64_t joinSequence;
+                int64_t joinTime;
+                apply(counts, join->line, joinSequence, joinTime);
+            }
+        };
+
+        for (size_t i = base; i <= last; i++) {
+            string log = readAll(logPath(snapshots[i].sequence));
+            size_t pos = 0;
+            while (pos < log.size()) {
+                size_t end = log.find('\n', pos);
+                if (end == string::npos) break;
+                string_view line = string_view(log).substr(pos, end - pos);
+                applyJoins(strtoull(string(line.substr(0, line.find(','))).c_str(), nullptr, 10));
+                uint64_t lineSequence;
+                int64_t lineTime;
+                if (!apply(counts, line, lineSequence, lineTime, asOf)) break;
+                if (lineTime > asOf) {
+                    applyJoins(UINT64_MAX);
+                    return true;
+                }
+                sequence = lineSequence;
+                time = lineTime;
+                pos = end + 1;
+            }
+            if (pos != log.size() && i + 1 < snapshots.size()) {
+                error = "Attendance history log is damaged: " + logPath(snapshots[i].sequence);
+                return false;
+            }
+            logEnd = pos;
+        }
+        applyJoins(UINT64_MAX);
+        return true;
+    }
+
+    // Reads every join, trimming a torn last line; false when a line before
+    // the last is damaged
+    bool readJoins(string& error) {
+        string content = readAll(joinPath());
+        size_t pos = 0;
+        while (pos < content.size()) {
+            size_t end = content.find('\n', pos);
+            string_view line = string_view(content).substr(pos, end == string::npos ? string::npos : end - pos);
+            AttendanceCountMap scratch;
+            uint64_t sequence;
+            int64_t time;
+            if (end == string::npos || !apply(scratch, line, sequence, time)) break;
+            joins.push_back({sequence, string(line)});
+            pos = end + 1;
+        }
+        if (pos == content.size()) return true;
+        size_t end = content.find('\n', pos);
+        if (end != string::npos && end + 1 < content.size()) {
+            error = "Attendance history join file is damaged: " + joinPath();
+            return false;
+        }
+        error_code code;
+        filesystem::resize_file(joinPath(), pos, code);
+        return true;
+    }
+
+    // Finds the snapshots, then rebuilds the current counts from the newest
+    // readable one and the logs after it, trimming a torn last line
+    void open() {
+        if (opened) return;
+        opened = true;
+        error_code code;
+        for (const auto& entry : filesystem::directory_iterator(root, code)) {
+            string name = entry.path().filename().string();
+            if (!name.starts_with("snapshot_") || !name.ends_with(".csv")) continue;
+            ifstream in(entry.path().string());
+            string header;
+            getline(in, header);
+            if (!header.starts_with("snapshot:")) continue;
+            snapshots.push_back({strtoull(header.c_str() + 9, nullptr, 10),
+                                 strtoll(header.c_str() + header.find(',') + 1, nullptr, 10)});
+        }
+        sort(snapshots.begin(), snapshots.end(), [](const Snapshot& a, const Snapshot& b) {
+            return a.sequence < b.sequence;
+        });
+        if (snapshots.empty()) return;
+
+        string error;
+        uint64_t sequence;
+        size_t logEnd = 0;
+        if (!readJoins(error) ||
+            !replay(snapshots.size() - 1, INT64_MAX, current, sequence, lastTime, logEnd, error)) {
+            damage = error;
+            current.clear();
+            return;
+        }
+        nextSequence = max(sequence, snapshots.back().sequence) + 1;
+        if (!joins.empty()) nextSequence = max(nextSequence, joins.back().sequence + 1);
+        string newestLog = logPath(snapshots.back().sequence);
+        if (filesystem::exists(newestLog, code) && logEnd != filesystem::file_size(newestLog, code)) {
+            filesystem::resize_file(newestLog, logEnd, code);
+        }
+    }
+
+    void add(int64_t time, char kind, const string& a, const string& b, const string& c, const string& d) {
+        if (!damage.empty()) return;
+        time = max(time, lastTime);  // a clock stepping back must not reorder the log
+        string body = to_string(nextSequence++) + "," + to_string(time) + "," + kind + "," + a + "," + b + "," +
+                      c + "," + d;
+        uint64_t sequence;
+        int64_t ignored;
+        string line = body + "," + crc32cHex(crc32c(body));
+        apply(current, line, sequence, ignored);
+        if (kind == 'J') {
+            joins.push_back({sequence, line});
+            pendingJoins += line + "\n";
+        } else {
+            pending += line + "\n";
+        }
+        pendingCount++;
+        lastTime = time;
+    }
+
+public:
+    explicit AttendanceHistory(const string& historyRoot) : root(historyRoot) {}
+
+    // False until start() has written the first snapshot. Damaged history
+    // still counts as started, so it is never restarted over its own files.
+    bool started() {
+        open();
+        return !snapshots.empty();
+    }
+
+    // Why history is unusable, or empty when it is fine
+    const string& damaged() {
+        open();
+        return damage;
+    }
+
+    // Time of the first snapshot: the earliest moment a query can see
+    int64_t startTime() {
+        open();
+        return snapshots.empty() ? 0 : snapshots.front().time;
+    }
+
+    // Begins history from the current counts of the students loaded so far
+    bool start(AttendanceCountMap counts, int64_t time, string& error) {
+        open();
+        error_code code;
+        filesystem::create_directories(root, code);
+        current = move(counts);
+        lastTime = time;
+        return writeSnapshot(0, time, error);
+    }
+
+    // before/after: 1 present, 0 absent, -1 no mark
+    void recordMark(const string& uniqueId, const string& date, int before, int after, int64_t time) {
+        if (before != after) add(time, 'M', uniqueId, date, to_string(before), to_string(after));
+    }
+
+    void recordArchived(const string& uniqueId, int present, int recorded, int64_t time) {
+        if (recorded > 0) add(time, 'A', uniqueId, to_string(present), to_string(recorded), "");
+    }
+
+    void recordRename(const string& oldId, const string& newId, int64_t time) {
+        add(time, 'R', oldId, newId, "", "");
+    }
+
+    // A student history has not seen yet, with the counts it has now
+    void join(const string& uniqueId, int present, int recorded, int64_t time) {
+        if (recorded > 0 && !current.count(uniqueId)) {
+            add(time, 'J', uniqueId, to_string(present), to_string(recorded), "");
+        }
+    }
+
+    // Appends the pending changes and syncs them, then writes a snapshot
+    // once the log holds HISTORY_SNAPSHOT_EVERY changes
+    bool flush(string& error) {
+        if (pendingCount == 0 || !damage.empty()) return true;
+        // Joins first: a logged change to a student whose join was lost
+        // would count from zero
+        if (!pendingJoins.empty() && !appendDurable(joinPath(), pendingJoins, error)) return false;
+        pendingJoins.clear();
+        if (!pending.empty() && !appendDurable(logPath(snapshots.back().sequence), pending, error)) return false;
+        pending.clear();
+        pendingCount = 0;
+        uint64_t newest = nextSequence - 1;
+        if (newest - snapshots.back().sequence < HISTORY_SNAPSHOT_EVERY) return true;
+        return writeSnapshot(newest, lastTime, error);
+    }
+
+    // Counts of every student as of a time: the newest snapshot at or
+    // before it plus the changes logged after it up to that time
+    bool countsAsOf(int64_t asOf, AttendanceCountMap& counts, uint64_t& sequence, string& error) {
+        open();
+        if (!damage.empty()) {
+            error = damage;
+            return false;
+        }
+        auto after = upper_bound(snapshots.begin(), snapshots.end(), asOf, [](int64_t time, const Snapshot& snapshot) {
+            return time < snapshot.time;
+        });
+        if (after == snapshots.begin()) {
+            error = "Attendance history starts after that time";
+            return false;
+        }
+        int64_t time;
+        size_t logEnd;
+        return replay((size_t)(prev(after) - snapshots.begin()), asOf, counts, sequence, time, logEnd, error);
+    }
+
+    // The counts after every change so far
+    const AttendanceCountMap& latest() {
+        open();
+        return current;
+    }
+
+    // Checks every snapshot and log line against its CRC
+    void verify(vector<string>& problems, uint64_t& bytes) {
+        open();
+        auto verifyLog = [&](const string& path, AttendanceCountMap& counts) {
+            string log = readAll(path);
+            bytes += log.size();
+            istringstream lines(log);
+            string line;
+            size_t number = 0;
+            while (getline(lines, line)) {
+                number++;
+                uint64_t sequence;
+                int64_t time;
+                if (!apply(counts, line, sequence, time)) {
+                    problems.push_back("Attendance history line " + to_string(number) + " is damaged: " + path);
+                    break;
+                }
+            }
+        };
+        for (const Snapshot& snapshot : snapshots) {
+            AttendanceCountMap counts;
+            string error;
+            if (!readSnapshot(snapshot.sequence, counts, error)) problems.push_back(error);
+            verifyLog(logPath(snapshot.sequence), counts);
+        }
+        AttendanceCountMap joined;
+        verifyLog(joinPath(), joined);
+    }
+
+    size_t snapshotCount() {
+        open();
+        return snapshots.size();
+    }
+};
@@ -3,38 +3,106 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <set>
 #include <ctime>
 #include <iomanip> // for setprecision
 #include <algorithm>
 #include <sstream>
-#include <conio.h>
 #include <chrono>
 #include <regex>
 #include <cctype>
 #include <cmath>
 #include <thread>
-#include <windows.h> // For Windows console colors
+#ifdef _WIN32
+#include <conio.h>    // _getch
+#include <windows.h>  // For Windows console colors
+#else
+#include <dirent.h>   // opendir/readdir for loadAllSections
+#include <termios.h>  // unbuffered single-key input
+#include <unistd.h>
+#endif
 #include <numeric>
-#include <direct.h>  // for _mkdir on Windows
-#include <sys/stat.h>  // for mkdir on Unix
 #include <filesystem>
+#include <memory>
+#include <deque>
+#include <unordered_set>
+#include <charconv>
 
 using namespace std;
 
+#include "date_utils.h"
+#include "trace_spans.h"
+#include "columnar_export.h"
+#include "batch_render.h"
+#include "gradebook.h"
+#include "correlation_analytics.h"
+#include "early_warning.h"
+#include "metrics.h"
+#include "persistence_worker.h"
+#include "partition_tracker.h"
+#include "crc32c.h"
+#include "catalog.h"
+#include "archive_segment.h"
+#include "id_history.h"
+#include "attendance_history.h"
+#include "arena.h"
+#include "memory_accounting.h"
+#include "roster.h"
+#include "search_index.h"
+#include "fulltext_index.h"
+
+// Colors are Windows console attributes (bit 0 blue, 1 green, 2 red, 3
+// bright); other terminals get the matching ANSI escape
+#ifdef _WIN32
 void setColor(int color) {
     HANDLE hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
     SetConsoleTextAttribute(hConsole, color);
 }
 
+void setColorWithBackground(int textColor, int bgColor) {
+    HANDLE hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
+    SetConsoleTextAttribute(hConsole, (bgColor << 4) | textColor);
+}
+
 void resetColor() {
     setColor(7); // Default color (white)
 }
 
+// One key press, without waiting for Enter
+int readKey() {
+    return _getch();
+}
+#else
+int ansiColor(int color, int base) {
+    int rgb = (color & 4 ? 1 : 0) | (color & 2 ? 2 : 0) | (color & 1 ? 4 : 0);
+    return (color & 8 ? base + 60 : base) + rgb;
+}
+
+void setColor(int color) {
+    cout << "\033[" << ansiColor(color, 30) << "m";
+}
+
 void setColorWithBackground(int textColor, int bgColor) {
-    HANDLE hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
-    SetConsoleTextAttribute(hConsole, (bgColor << 4) | textColor);
+    cout << "\033[" << ansiColor(textColor, 30) << ";" << ansiColor(bgColor, 40) << "m";
+}
+
+void resetColor() {
+    cout << "\033[0m";
 }
 
+// One key press, without waiting for Enter
+int readKey() {
+    termios saved;
+    if (tcgetattr(STDIN_FILENO, &saved) != 0) return getchar();  // not a terminal
+    termios raw = saved;
+    raw.c_lflag &= ~(ICANON | ECHO);
+    tcsetattr(STDIN_FILENO, TCSANOW, &raw);
+    int key = getchar();
+    tcsetattr(STDIN_FILENO, TCSANOW, &saved);
+    return key;
+}
+#endif
+
 void printTitle(const string& title) {
     int width = 60;
     string border(width, '=');
@@ -73,67 +141,134 @@ public:
     }
 };
 
+// Variable-size data lives in the memory resource passed at construction,
+// normally the SectionArena of the student's class-section; values shared
+// across students are StringPool ids.
 class Student {
 private:
-    string uniqueId;  // Format: class_section_rollNo (e.g., "1A_1")
-    string rollNo;
-    string name;
-    string className;  // e.g., "1A", "2B", "3C"
-    string section;    // e.g., "A", "B", "C"
-    string contactNo;
-    map<string, bool> attendanceRecord;
-    map<string, string> remarks;
-    string email;
-    string gender;
-    string dateOfBirth;
-    vector<pair<string, string>> notifications;
-    map<string, float> subjectGrades;  // subject -> grade
+    pmr::string uniqueId;  // Format: class_section_rollNo (e.g., "1A_1")
+    pmr::string rollNo;
+    pmr::string name;
+    uint32_t classId;      // className, e.g. "1A", "2B", "3C"
+    uint32_t sectionId;    // section, e.g. "A", "B", "C"
+    pmr::string contactNo;
+    FlatDateMap<bool> attendanceRecord;
+    FlatDateMap<uint32_t> remarks;     // date -> interned remark
+    pmr::string email;
+    uint32_t genderId;
+    pmr::string dateOfBirth;
+    pmr::vector<pair<pmr::string, pmr::string>> notifications;
+    FlatIdMap<float> subjectGrades;  // subject -> grade
     int absenceWarningCount;
     bool isOnProbation;
     
     // School-specific fields
-    string parentName;
-    string parentEmail;
-    string parentPhone;
-    string bloodGroup;
-    string address;
-    string busRoute;
-    vector<string> extracurriculars;
-    map<string, string> behaviorNotes;
-    map<string, int> conductMarks;
+    pmr::string parentName;
+    pmr::string parentEmail;
+    pmr::string parentPhone;
+    pmr::string bloodGroup;
+    pmr::string address;
+    uint32_t busRouteId;
+    pmr::vector<pmr::string> extracurriculars;
+    FlatDateMap<pmr::string> behaviorNotes;
+    FlatIdMap<int> conductMarks;
+    AttendanceWindowState warningState;  // sliding-window counters for early warnings
 
 public:
-    Student(string roll, string n, string class_, string sect,
-           string contact, string mail, string gen, string dob) 
-        : rollNo(roll), name(n), className(class_), section(sect),
-          contactNo(contact), email(mail), gender(gen), 
-          dateOfBirth(dob), absenceWarningCount(0), isOnProbation(false) {
-        uniqueId = class_ + "_" + sect + "_" + roll;
-    }
-
-    string getRollNo() const { return rollNo; }
-    string getName() const { return name; }
-    string getClassName() const { return className; }
-    string getSection() const { return section; }
-    string getContactNo() const { return contactNo; }
-    string getEmail() const { return email; }
-    string getGender() const { return gender; }
-    string getDateOfBirth() const { return dateOfBirth; }
-    string getUniqueId() const { return uniqueId; }
+    Student(const string& roll, const string& n, const string& class_, const string& sect,
+            const string& contact, const string& mail, const string& gen, const string& dob,
+            pmr::memory_resource* arena = pmr::get_default_resource())
+        : uniqueId(class_ + "_" + sect + "_" + roll, arena), rollNo(roll, arena), name(n, arena),
+          classId(stringPool().intern(class_)), sectionId(stringPool().intern(sect)),
+          contactNo(contact, arena), attendanceRecord(arena), remarks(arena), email(mail, arena),
+          genderId(stringPool().intern(gen)), dateOfBirth(dob, arena), notifications(arena),
+          subjectGrades(arena), absenceWarningCount(0), isOnProbation(false),
+          parentName(arena), parentEmail(arena), parentPhone(arena), bloodGroup(arena), address(arena),
+          busRouteId(StringPool::EMPTY_ID), extracurriculars(arena), behaviorNotes(arena),
+          conductMarks(arena) {}
+
+    // Moves keep the source's arena. Copies go to the default heap, and
+    // assignment rebuilds the object so its containers never stay bound to
+    // the arena of the student that previously occupied the slot.
+    Student(Student&&) noexcept = default;
+    Student(const Student&) = default;
+    Student& operator=(Student&& other) noexcept {
+        if (this != &other) {
+            this->~Student();
+            new (this) Student(std::move(other));
+        }
+        return *this;
+    }
+    Student& operator=(const Student& other) {
+        if (this != &other) {
+            Student copy(other);
+            *this = std::move(copy);
+        }
+        return *this;
+    }
+
+    string getRollNo() const { return string(rollNo); }
+    string getName() const { return string(name); }
+    const string& getClassName() const { return stringPool().get(classId); }
+    const string& getSection() const { return stringPool().get(sectionId); }
+    string getContactNo() const { return string(contactNo); }
+    string getEmail() const { return string(email); }
+    const string& getGender() const { return stringPool().get(genderId); }
+    uint32_t getClassId() const { return classId; }
+    uint32_t getSectionId() const { return sectionId; }
+    string getDateOfBirth() const { return string(dateOfBirth); }
+    string getUniqueId() const { return string(uniqueId); }
+    pmr::memory_resource* getArena() const { return notifications.get_allocator().resource(); }
     
     void markAttendance(const string& date, bool present, const string& remark = "") {
-        attendanceRecord[date] = present;
+        attendanceRecord.assign(date, present);
         if (!remark.empty()) {
-            remarks[date] = remark;
+            remarks.assign(date, stringPool().intern(remark));
+        }
+    }
+
+    // Load path: the remark is already interned (StringPool::EMPTY_ID for none)
+    void markAttendance(string_view date, bool present, uint32_t remarkId) {
+        attendanceRecord.assign(date, present);
+        if (remarkId != StringPool::EMPTY_ID) {
+            remarks.assign(date, remarkId);
+        }
+    }
+
+    // Moves the student to another class at rollover; the uniqueId follows the class
+    void promoteTo(const string& className) {
+        classId = stringPool().intern(className);
+        uniqueId = className + "_" + getSection() + "_" + getRollNo();
+    }
+
+    // Undo/redo: sets a date back to present, absent or no mark (1, 0, -1) with its pooled remark
+    void setMark(string_view date, int state, uint32_t remarkId) {
+        if (state < 0) {
+            dropAttendanceBetween(date, date);
+            return;
         }
+        attendanceRecord.assign(date, state == 1);
+        if (remarkId != StringPool::EMPTY_ID) remarks.assign(date, remarkId);
+        else remarks.eraseBetween(date, date);
+    }
+
+    // Drops the marks and remarks dated first..last once they are archived; returns the marks dropped
+    size_t dropAttendanceBetween(string_view first, string_view last) {
+        remarks.eraseBetween(first, last);
+        return attendanceRecord.eraseBetween(first, last);
+    }
+
+    // Sizes the attendance storage up front when the record count is known (e.g. while loading)
+    void reserveAttendance(size_t records) {
+        attendanceRecord.reserve(records);
     }
 
     float getAttendancePercentage() const {
         if (attendanceRecord.empty()) return 0.0;
         
         int present = 0;
-        for (const auto& record : attendanceRecord) {
-            if (record.second) present++;
+        for (const auto& entry : attendanceRecord.raw()) {
+            if (entry.value) present++;
         }
         return (float)present / attendanceRecord.size() * 100;
     }
@@ -142,9 +277,8 @@ public:
         stringstream ss;
         for (const auto& record : attendanceRecord) {
             ss << record.first << ": " << (record.second ? "Present" : "Absent");
-            auto remark = remarks.find(record.first);
-            if (remark != remarks.end()) {
-                ss << " - " << remark->second;
+            if (const uint32_t* remark = remarks.lookup(record.first)) {
+                ss << " - " << stringPool().get(*remark);
             }
             ss << "\n";
         }
@@ -153,8 +287,8 @@ public:
 
     int getTotalPresent() const {
         int count = 0;
-        for (const auto& record : attendanceRecord) {
-            if (record.second) count++;
+        for (const auto& entry : attendanceRecord.raw()) {
+            if (entry.value) count++;
         }
         return count;
     }
@@ -164,17 +298,17 @@ public:
     }
 
     bool getAttendanceForDate(const string& date) const {
-        auto it = attendanceRecord.find(date);
-        return (it != attendanceRecord.end()) ? it->second : false;
+        const bool* present = attendanceRecord.lookup(date);
+        return present ? *present : false;
     }
 
-    const map<string, bool>& getAttendanceRecord() const {
+    const FlatDateMap<bool>& getAttendanceRecord() const {
         return attendanceRecord;
     }
 
     string getRemarkForDate(const string& date) const {
-        auto it = remarks.find(date);
-        return (it != remarks.end()) ? it->second : "";
+        const uint32_t* remark = remarks.lookup(date);
+        return remark ? stringPool().get(*remark) : "";
     }
 
     float getAttendancePercentageRange(const string& startDate, const string& endDate) const {
@@ -189,11 +323,15 @@ public:
     }
 
     void addNotification(const string& message) {
-        notifications.push_back({getCurrentDate(), message});
+        notifications.emplace_back(getCurrentDate(), message);
     }
 
     vector<pair<string, string>> getNotifications() const {
-        return notifications;
+        vector<pair<string, string>> copy;
+        for (const auto& notification : notifications) {
+            copy.push_back({string(notification.first), string(notification.second)});
+        }
+        return copy;
     }
 
     int getAttendanceStreak() const {
@@ -235,36 +373,76 @@ public:
     }
 
     void addSubjectGrade(const string& subject, float grade) {
-        subjectGrades[subject] = grade;
+        subjectGrades.assign(subject, grade);
     }
 
     void addBehaviorNote(const string& note) {
-        behaviorNotes[getCurrentDate()] = note;
+        behaviorNotes.assign(getCurrentDate(), note);
     }
 
     void updateConductMarks(const string& subject, int marks) {
-        conductMarks[subject] = marks;
+        conductMarks.assign(subject, marks);
     }
 
     void addExtracurricular(const string& activity) {
-        extracurriculars.push_back(activity);
+        extracurriculars.emplace_back(activity);
     }
 
     void setBusRoute(const string& route) {
-        busRoute = route;
+        busRouteId = stringPool().intern(route);
     }
 
-    const map<string, float>& getGrades() const { return subjectGrades; }
+    const FlatIdMap<float>& getGrades() const { return subjectGrades; }
     bool getIsOnProbation() const { return isOnProbation; }
-    string getParentName() const { return parentName; }
-    string getParentEmail() const { return parentEmail; }
-    string getParentPhone() const { return parentPhone; }
-    string getBloodGroup() const { return bloodGroup; }
-    string getAddress() const { return address; }
-    string getBusRoute() const { return busRoute; }
-    const vector<string>& getExtracurriculars() const { return extracurriculars; }
-    const map<string, string>& getBehaviorNotes() const { return behaviorNotes; }
-    const map<string, int>& getConductMarks() const { return conductMarks; }
+    int getAbsenceWarningCount() const { return absenceWarningCount; }
+    AttendanceWindowState& getWarningState() { return warningState; }
+
+    void recordAbsenceWarning(int count = 1) {
+        absenceWarningCount += count;
+    }
+
+    void setProbation(bool probation) {
+        isOnProbation = probation;
+    }
+    string getParentName() const { return string(parentName); }
+    string getParentEmail() const { return string(parentEmail); }
+    string getParentPhone() const { return string(parentPhone); }
+    string getBloodGroup() const { return string(bloodGroup); }
+    string getAddress() const { return string(address); }
+    const string& getBusRoute() const { return stringPool().get(busRouteId); }
+    const pmr::vector<pmr::string>& getExtracurriculars() const { return extracurriculars; }
+    const FlatDateMap<pmr::string>& getBehaviorNotes() const { return behaviorNotes; }
+    const FlatDateMap<uint32_t>& getRemarks() const { return remarks; }
+    const FlatIdMap<int>& getConductMarks() const { return conductMarks; }
+
+    // Charges this student's memory to the snapshot's categories and section;
+    // interned values are charged once, to the string pool
+    void accountMemory(MemorySnapshot& snapshot) const {
+        MemoryUsage& sectionUsage = snapshot.sections[getClassName() + "-" + getSection()];
+        sectionUsage.addInline(sizeof(Student));
+        auto charge = [&](const string& category, const auto& member) {
+            MemoryUsage usage;
+            accountHeap(usage, member);
+            snapshot.charge(category, usage);
+            sectionUsage.merge(usage);
+        };
+
+        MemoryUsage strings;
+        for (const pmr::string* field : {&uniqueId, &rollNo, &name, &contactNo, &email, &dateOfBirth,
+                                         &parentName, &parentEmail, &parentPhone, &bloodGroup, &address}) {
+            accountHeap(strings, *field);
+        }
+        snapshot.charge("student.strings", strings);
+        sectionUsage.merge(strings);
+
+        charge("student.attendanceRecord", attendanceRecord);
+        charge("student.remarks", remarks);
+        charge("student.subjectGrades", subjectGrades);
+        charge("student.behaviorNotes", behaviorNotes);
+        charge("student.conductMarks", conductMarks);
+        charge("student.notifications", notifications);
+        charge("student.extracurriculars", extracurriculars);
+    }
 
     // Add these helper functions inside the Student class
     int getConsecutiveAttendance() const {
@@ -552,10 +730,17 @@ public:
     string subject;
     string date;
     int maxMarks;
-    map<string, float> studentMarks;  // rollNo -> marks
+    map<string, float> studentMarks;  // uniqueId -> marks; roll numbers repeat across sections
     string examType;  // "Unit Test", "Mid Term", "Final"
 };
 
+inline void accountHeap(MemoryUsage& usage, const Exam& exam) {
+    accountHeap(usage, exam.subject);
+    accountHeap(usage, exam.date);
+    accountHeap(usage, exam.studentMarks);
+    accountHeap(usage, exam.examType);
+}
+
 class ClassTeacher {
 public:
     string name;
@@ -604,6 +789,13 @@ public:
     string feedback;
 };
 
+inline void accountHeap(MemoryUsage& usage, const ParentMeeting& meeting) {
+    for (const string* field : {&meeting.date, &meeting.time, &meeting.teacherName, &meeting.agenda,
+                                &meeting.feedback}) {
+        accountHeap(usage, *field);
+    }
+}
+
 struct Notification {
     string message;
     string date;
@@ -612,14 +804,68 @@ struct Notification {
     vector<string> recipients; // rollNo list
 };
 
+inline void accountHeap(MemoryUsage& usage, const Notification& notification) {
+    accountHeap(usage, notification.message);
+    accountHeap(usage, notification.date);
+    accountHeap(usage, notification.type);
+    accountHeap(usage, notification.recipients);
+}
+
+// One student's mark as a marking session changed it, with everything the
+// mark derived, so it can be reverted or reapplied without recomputing.
+struct MarkChange {
+    string uniqueId;
+    string className;
+    string section;
+    size_t row = 0;  // index in students when recorded; checked before use
+    string date;
+    int before = -1, after = -1;  // 1 present, 0 absent, -1 no mark
+    uint32_t beforeRemark = StringPool::EMPTY_ID, afterRemark = StringPool::EMPTY_ID;
+    RosterCounters rosterBefore, rosterAfter;
+    AttendanceWindowState windowBefore, windowAfter;
+    bool probationBefore = false, probationAfter = false;
+    vector<Notification> alerts;  // parent alerts the mark raised
+};
+
+// What one undo or redo step reverts or reapplies: a marking batch or a
+// single student's entry
+struct MarkAction {
+    string label;
+    vector<MarkChange> changes;
+};
+
 class AttendanceSystem {
 private:
+    friend struct AttendanceBenchmark;  // benchmarks/attendance_bench.cpp
+    friend struct SchoolDayReplay;      // benchmarks/school_day_replay.cpp
+
+    map<string, unique_ptr<SectionArena>> sectionArenas;  // "class-section" -> arena; must outlive students
+    map<string, unordered_map<uint32_t, uint32_t>> remarkDictionaries;  // "class-section" -> remark -> id in its file
     vector<Student> students;
+    AttendanceRoster roster;  // hot attendance columns, row i is students[i]
+    StudentSearchIndex searchIndex;  // every student loaded or added this session
+    FullTextIndex textIndex;         // remarks, behavior notes, teacher remarks, meeting feedback
+    BackupStore backups{"student_data/backups"};  // every saved version of the class files
+    PersistenceWorker persistence{&backups};      // writes queued class-section saves off the UI thread
+    PartitionTracker partitions;     // loaded and changed class-sections
+    SchoolCatalog catalog;           // per-section summaries, read at startup instead of the class files
+    ArchiveTier archive{"student_data/archive"};  // closed academic years, mapped on demand
+    set<int> indexedArchiveYears;    // archived years whose remarks are in textIndex
+    IdHistory idHistory{"student_data/id_history.csv"};  // uniqueIds before each rollover
+    AttendanceHistory history{"student_data/history"};   // every attendance change since history started
+    bool historyDamageReported = false;                  // damaged history is reported once per session
+    bool joinHistoryOnLoad = true;                       // loaded students history has not seen join it
+    bool allSectionsLoaded = false;  // every class file on disk is in memory
     const string ADMIN_PASSWORD = "admin123";
     bool isLoggedIn = false;
+    bool headless = false;  // set by benchmarks and harnesses to skip screen clears
     map<string, vector<string>> departmentCourses;
     vector<pair<string, string>> systemLogs;
     vector<Notification> notificationList;  // Now this will work
+    EarlyWarningEngine warningEngine;
+    deque<Notification> pendingParentNotifications;  // alerts raised while marking
+    vector<MarkAction> undoActions;  // this session's marking, newest last
+    vector<MarkAction> redoActions;  // undone steps, newest last; cleared by new marking
     
     string getCurrentDate() const {
         auto now = chrono::system_clock::now();
@@ -643,6 +889,9 @@ private:
 
     // Add these constants for folder organization
     const string BASE_DIR = "student_data";
+    static const size_t MAX_REMARK_IDS = 1 << 20;  // larger dictionary ids in a file are ignored
+    static const int ACADEMIC_YEAR_START_MONTH = 4;  // a year runs from April to March
+    static constexpr const char* ROLLOVER_FILE_SUFFIX = ".rollover";  // files staged by a rollover
     const map<string, pair<int, int>> SCHOOL_SECTIONS = {
         {"primary", {1, 3}},
         {"upper_primary", {4, 5}},
@@ -662,115 +911,208 @@ private:
         return "";
     }
 
-    // Helper method to create directory structure
-    void createDirectoryStructure() {
-        #ifdef _WIN32
-            CreateDirectoryA(BASE_DIR.c_str(), NULL);
-            for (const auto& section : SCHOOL_SECTIONS) {
-                string path = BASE_DIR + "/" + section.first;
-                CreateDirectoryA(path.c_str(), NULL);
-            }
-        #else
-            mkdir(BASE_DIR.c_str(), 0777);
-            for (const auto& section : SCHOOL_SECTIONS) {
-                string path = BASE_DIR + "/" + section.first;
-                mkdir(path.c_str(), 0777);
-            }
-        #endif
+    // Academic years are named by the calendar year they start in
+    static int academicYearOf(const string& date) {
+        int year = atoi(date.c_str()), month = date.size() >= 7 ? atoi(date.c_str() + 5) : 1;
+        return month >= ACADEMIC_YEAR_START_MONTH ? year : year - 1;
+    }
+
+    static string academicYearLabel(int year) {
+        char label[16];
+        snprintf(label, sizeof(label), "%d-%02d", year, (year + 1) % 100);
+        return label;
     }
 
-    // Modified save method to save class-wise data
+    static int academicYearFirstDay(int year) { return dayNumberFromCivil(year, ACADEMIC_YEAR_START_MONTH, 1); }
+    static int academicYearLastDay(int year) { return academicYearFirstDay(year + 1) - 1; }
+
+    // Writes every class-section changed since its last save, in parallel on
+    // the persistence writers, as one commit group, and waits for them.
+    // Unchanged sections cost nothing.
     void saveToFile() {
-        createDirectoryStructure();
-        
-        // Group students by class
-        map<string, vector<Student*>> classGroups;
-        for (auto& student : students) {
-            string className = student.getClassName();
-            classGroups[className].push_back(&student);
+        METRIC_STAGE(STAGE_SAVE);
+        TRACE_SPAN("saveToFile");
+        flushHistory();
+        persistence.beginGroup();
+        for (const PartitionState* partition : partitions.dirtyPartitions()) {
+            try {
+                queueClassSave(partition->className, partition->section);
+            } catch (...) {
+                showError("Error saving class " + partition->className + "-" + partition->section);
+            }
         }
+        queueCatalogSave();
+        persistence.endGroup();
+        persistence.flush();
+        reportPersistenceErrors();
+    }
 
-        // Save each class to its appropriate section folder
-        for (const auto& group : classGroups) {
-            try {
-                int classNum = stoi(group.first);
-                string sectionFolder = getSectionFolder(classNum);
-                if (sectionFolder.empty()) continue;
+    // A crash between writing a save's temp file and renaming it leaves the
+    // temp file behind; the class file itself still has the last committed save
+    void recoverInterruptedSaves() {
+        vector<string> removed = removeInterruptedWrites(BASE_DIR);
+        for (const string& path : removed) {
+            logAction("Discarded unfinished save: " + path);
+        }
+        if (!removed.empty()) {
+            showWarning(to_string(removed.size()) + " unfinished save(s) from an earlier crash were discarded");
+        }
+    }
 
-                string filename = BASE_DIR + "/" + sectionFolder + 
-                                "/class_" + group.first + ".csv";
-                
-                ofstream file(filename);
-                if (!file.is_open()) {
-                    showError("Could not open file: " + filename);
-                    continue;
-                }
+    string getCatalogPath() const { return BASE_DIR + "/catalog.txt"; }
 
-                // Write header
-                file << "Roll No,Name,Section,Contact,Email,Gender,DOB\n";
-
-                // Write student data
-                for (const Student* student : group.second) {
-                    file << student->getRollNo() << ","
-                         << student->getName() << ","
-                         << student->getSection() << ","
-                         << student->getContactNo() << ","
-                         << student->getEmail() << ","
-                         << student->getGender() << ","
-                         << student->getDateOfBirth() << "\n";
-                }
-                file.close();
-                
-            } catch (...) {
-                showError("Error saving class " + group.first);
+    // Queues the catalog for rewriting if an entry changed since it was last queued
+    void queueCatalogSave() {
+        if (!catalog.takeChanged()) return;
+        vector<PersistFile> files;
+        files.push_back({getCatalogPath(), catalog.render(), false});
+        persistence.enqueue("catalog", move(files));
+    }
+
+    // History starts the first time a change is about to be made, from the
+    // counts of the students loaded so far; students of sections loaded later
+    // join it as they load (indexNewStudent). From then on every change is
+    // logged. A failure is reported here; callers carry on without history.
+    bool ensureHistoryStarted() {
+        if (history.started()) {
+            if (!history.damaged().empty() && !historyDamageReported) {
+                showError("Attendance history is not being kept: " + history.damaged());
+                logAction("Attendance history damaged: " + history.damaged());
+                historyDamageReported = true;
             }
+            return true;
         }
+        AttendanceCountMap counts;
+        for (const auto& student : students) {
+            AttendanceCounts& entry = counts[student.getUniqueId()];
+            entry.present = student.getTotalPresent();
+            entry.recorded = (int)student.getAttendanceRecord().size();
+        }
+        string error;
+        if (history.start(move(counts), (int64_t)time(nullptr), error)) return true;
+        showError("Attendance history not started: " + error);
+        logAction("Attendance history not started: " + error);
+        return false;
     }
 
-    // Modified load method to load from all section folders
-    void loadFromFile() {
-        students.clear();
-        
+    // Makes the changes logged so far durable
+    void flushHistory() {
+        string error;
+        if (history.flush(error)) return;
+        showError(error);
+        logAction("Save failed: " + error);
+    }
+
+    // Loads every section folder not yet in memory: class_<N>_<S>.csv files
+    // first, then legacy class_<N>.csv files, whose students the next save
+    // migrates into the per-section layout. Backups and other files are
+    // skipped. Whole-school views call this; startup only reads the catalog.
+    void loadAllSections() {
+        if (allSectionsLoaded) return;
+        METRIC_STAGE(STAGE_LOAD);
+        TRACE_SPAN("loadAllSections");
+
+        vector<string> legacyFiles;
         for (const auto& section : SCHOOL_SECTIONS) {
             string sectionPath = BASE_DIR + "/" + section.first;
+            for (const string& filename : listClassFiles(sectionPath)) {
+                string className, sect;
+                if (!parseClassFileName(filename, className, sect)) continue;
+                if (sect.empty()) legacyFiles.push_back(sectionPath + "/" + filename);
+                else loadClassData(className, sect);
+            }
+        }
+        for (const string& filename : legacyFiles) {
+            loadClassFile(filename);
+        }
+        allSectionsLoaded = true;
+        queueCatalogSave();
+    }
+
+    // Loads every section of one class not yet in memory. A legacy class file
+    // mixes sections, so finding one falls back to loading everything.
+    void loadClassSections(const string& className) {
+        if (allSectionsLoaded) return;
+        string sectionPath = BASE_DIR + "/" + getSectionFolder(stoi(className));
+        for (const string& filename : listClassFiles(sectionPath)) {
+            string fileClass, sect;
+            if (!parseClassFileName(filename, fileClass, sect) || fileClass != className) continue;
+            if (sect.empty()) {
+                loadAllSections();
+                return;
+            }
+            loadClassData(fileClass, sect);
+        }
+    }
+
+    // Names of the .csv files in one section folder, sorted
+    vector<string> listClassFiles(const string& sectionPath) const {
+        vector<string> filenames;
+        #ifdef _WIN32
+            WIN32_FIND_DATAA findData;
+            string searchPath = sectionPath + "/*.csv";
+            HANDLE hFind = FindFirstFileA(searchPath.c_str(), &findData);
             
-            #ifdef _WIN32
-                WIN32_FIND_DATAA findData;
-                string searchPath = sectionPath + "/*.csv";
-                HANDLE hFind = FindFirstFileA(searchPath.c_str(), &findData);
-                
-                if (hFind != INVALID_HANDLE_VALUE) {
-                    do {
-                        string filename = sectionPath + "/" + findData.cFileName;
-                        loadClassFile(filename);
-                    } while (FindNextFileA(hFind, &findData));
-                    FindClose(hFind);
-                }
-            #else
-                DIR* dir = opendir(sectionPath.c_str());
-                if (dir != nullptr) {
-                    struct dirent* entry;
-                    while ((entry = readdir(dir)) != nullptr) {
-                        string filename = entry->d_name;
-                        if (filename.ends_with(".csv")) {
-                            loadClassFile(sectionPath + "/" + filename);
-                        }
+            if (hFind != INVALID_HANDLE_VALUE) {
+                do {
+                    filenames.push_back(findData.cFileName);
+                } while (FindNextFileA(hFind, &findData));
+                FindClose(hFind);
+            }
+        #else
+            DIR* dir = opendir(sectionPath.c_str());
+            if (dir != nullptr) {
+                struct dirent* entry;
+                while ((entry = readdir(dir)) != nullptr) {
+                    string filename = entry->d_name;
+                    if (filename.ends_with(".csv")) {
+                        filenames.push_back(filename);
                     }
-                    closedir(dir);
                 }
-            #endif
-        }
+                closedir(dir);
+            }
+        #endif
+        sort(filenames.begin(), filenames.end());
+        return filenames;
+    }
+
+    // class_<N>_<S>.csv gives class and section; a legacy class_<N>.csv leaves
+    // the section empty. Old _backup_<date> copies and anything else are rejected.
+    static bool parseClassFileName(const string& filename, string& className, string& section) {
+        if (!filename.starts_with("class_") || !filename.ends_with(".csv")) return false;
+        string stem = filename.substr(6, filename.length() - 10);
+        if (stem.find("_backup_") != string::npos) return false;
+        size_t split = stem.find('_');
+        className = stem.substr(0, split);
+        section = split == string::npos ? "" : stem.substr(split + 1);
+        if (className.empty() || !all_of(className.begin(), className.end(), ::isdigit)) return false;
+        return split == string::npos || !section.empty();
     }
 
-    // Helper method to load a single class file
+    // Reads a legacy class_<N>.csv (profiles only, section per row). Students
+    // the per-section files did not already provide are added and their
+    // sections marked dirty, so the next save writes them in the new layout.
     void loadClassFile(const string& filename) {
+        METRIC_STAGE(STAGE_LOAD);
+        TRACE_SPAN_DETAIL("loadClassFile", filesystem::path(filename).filename().string());
+        string className, fileSection;
+        if (!parseClassFileName(filesystem::path(filename).filename().string(), className, fileSection)) return;
         ifstream file(filename);
         if (!file.is_open()) return;
+        METRIC_ADD(COUNTER_FILES_LOADED, 1);
+
+        unordered_set<string> loaded;
+        for (const auto& student : students) {
+            if (student.getClassName() == className) loaded.insert(student.getUniqueId());
+        }
 
+        vector<uint32_t> remarkIds;
+        readClassFileHeader(file, remarkIds);
         string line;
-        getline(file, line); // Skip header
 
         while (getline(file, line)) {
+            METRIC_STAGE(STAGE_PARSE);
+            METRIC_ADD(COUNTER_ROWS_PARSED, 1);
             try {
                 stringstream ss(line);
                 string roll, name, section, contact, email, gender, dob;
@@ -782,15 +1124,14 @@ private:
                 getline(ss, email, ',');
                 getline(ss, gender, ',');
                 getline(ss, dob, ',');
-
-                // Extract class number from filename
-                string className = filename.substr(
-                    filename.find("class_") + 6,
-                    filename.find(".csv") - filename.find("class_") - 6
-                );
+                if (roll.empty() || section.empty()) continue;
+                if (!loaded.insert(className + "_" + section + "_" + roll).second) continue;
 
                 students.push_back(Student(roll, name, className, section,
-                                        contact, email, gender, dob));
+                                        contact, email, gender, dob, &arenaFor(className, section)));
+                indexNewStudent();
+                partitions.markLoaded(className, section);
+                partitions.markDirty(className, section);
             } catch (...) {
                 continue;
             }
@@ -799,6 +1140,7 @@ private:
     }
 
     void clearScreen() const {
+        if (headless) return;
         #ifdef _WIN32
             std::system("cls");
         #else
@@ -866,33 +1208,59 @@ private:
 
     int getTodayPresent() const {
         string today = getCurrentDate();
-        int count = 0;
-        for (const auto& student : students) {
-            if (student.getAttendanceForDate(today)) count++;
+        int day = dayNumberFromDate(today);
+        size_t unresolved = 0;
+        int count = (int)roster.countPresentOn(day, unresolved);
+        // Students with marks dated after today need their record checked
+        for (size_t row = 0; unresolved > 0 && row < roster.size(); row++) {
+            if (roster.lastDay(row) > day) {
+                if (students[row].getAttendanceForDate(today)) count++;
+                unresolved--;
+            }
         }
+        // Sections not loaded answer from their catalog summary; one whose
+        // recent window is entirely after today counts nobody present
+        forEachUnloadedEntry([&](const CatalogEntry& entry) {
+            uint32_t present = 0;
+            SchoolCatalog::presentOn(entry, today, present);
+            count += present;
+        });
         return count;
     }
 
-    float getOverallAttendance() const {
-        if (students.empty()) return 0.0f;
-        float total = 0;
-        for (const auto& student : students) {
-            total += student.getAttendancePercentage();
+    // Catalog entries of the sections not in memory; the dashboard adds their
+    // summaries to what the roster holds for loaded ones
+    template <typename Visit>
+    void forEachUnloadedEntry(Visit visit) const {
+        for (const auto& item : catalog.all()) {
+            if (!partitions.isLoaded(item.second.className, item.second.section)) visit(item.second);
         }
-        return total / students.size();
     }
 
-    string getBestClass() const {
-        map<string, pair<float, int>> deptStats;
-        for (const auto& student : students) {
-            auto& stat = deptStats[student.getClassName()];
-            stat.first += student.getAttendancePercentage();
-            stat.second++;
-        }
+    // Students in memory plus those of every section still on disk
+    size_t totalStudents() const {
+        size_t total = students.size();
+        forEachUnloadedEntry([&](const CatalogEntry& entry) { total += entry.students; });
+        return total;
+    }
+
+    float getOverallAttendance() const {
+        METRIC_STAGE(STAGE_AGGREGATE);
+        TRACE_SPAN("getOverallAttendance");
+        size_t count = totalStudents();
+        if (count == 0) return 0.0f;
+        double total = 0;
+        roster.scanPercentages([&](size_t, float percentage) { total += percentage; });
+        forEachUnloadedEntry([&](const CatalogEntry& entry) { total += entry.percentSum; });
+        return (float)(total / count);
+    }
 
+    string getBestClass() const {
+        METRIC_STAGE(STAGE_AGGREGATE);
+        TRACE_SPAN("getBestClass");
         string bestDept;
         float bestAvg = 0;
-        for (const auto& dept : deptStats) {
+        for (const auto& dept : classAttendanceStats()) {
             float avg = dept.second.first / dept.second.second;
             if (avg > bestAvg) {
                 bestAvg = avg;
@@ -902,6 +1270,28 @@ private:
         return bestDept;
     }
 
+    // Class name -> (sum of student percentages, students), in class name order
+    vector<pair<string, pair<float, int>>> classAttendanceStats() const {
+        vector<pair<float, int>> slotStats(roster.classCount());
+        roster.scanPercentages([&](size_t row, float percentage) {
+            auto& stat = slotStats[roster.classSlot(row)];
+            stat.first += percentage;
+            stat.second++;
+        });
+
+        map<string, pair<float, int>> byClass;
+        for (uint32_t slot = 0; slot < slotStats.size(); slot++) {
+            if (slotStats[slot].second > 0) byClass[roster.className(slot)] = slotStats[slot];
+        }
+        forEachUnloadedEntry([&](const CatalogEntry& entry) {
+            if (entry.students == 0) return;
+            auto& stat = byClass[entry.className];
+            stat.first += (float)entry.percentSum;
+            stat.second += (int)entry.students;
+        });
+        return vector<pair<string, pair<float, int>>>(byClass.begin(), byClass.end());
+    }
+
     int getTotalCourses() const {
         int total = 0;
         for (const auto& dept : departmentCourses) {
@@ -911,9 +1301,12 @@ private:
     }
 
     vector<pair<string, float>> getWeeklyAttendance() const {
+        METRIC_STAGE(STAGE_AGGREGATE);
+        TRACE_SPAN("getWeeklyAttendance");
         vector<pair<string, float>> weeklyData;
         
-        if (students.empty()) {
+        size_t schoolSize = totalStudents();
+        if (schoolSize == 0) {
             return weeklyData;
         }
 
@@ -931,12 +1324,17 @@ private:
                    << setfill('0') << setw(2) << ltm->tm_mday;
                 string date = ss.str();
                 
-                int present = 0, total = students.size();
+                int present = 0, total = (int)schoolSize;
                 for (const auto& student : students) {
                     if (student.getAttendanceForDate(date)) {
                         present++;
                     }
                 }
+                forEachUnloadedEntry([&](const CatalogEntry& entry) {
+                    uint32_t count = 0;
+                    SchoolCatalog::presentOn(entry, date, count);
+                    present += count;
+                });
                 
                 float percentage = total > 0 ? (float)present / total * 100 : 0.0f;
                 weeklyData.push_back({date, percentage});
@@ -974,24 +1372,16 @@ private:
     }
 
     vector<pair<string, float>> getDepartmentPerformance() const {
+        METRIC_STAGE(STAGE_AGGREGATE);
+        TRACE_SPAN("getDepartmentPerformance");
         vector<pair<string, float>> deptData;
-        map<string, pair<float, int>> deptStats;
 
-        if (students.empty()) {
+        if (totalStudents() == 0) {
             return deptData;
         }
 
-        for (const auto& student : students) {
-            const string& dept = student.getClassName();
-            if (!dept.empty()) {
-                auto& stat = deptStats[dept];
-                stat.first += student.getAttendancePercentage();
-                stat.second++;
-            }
-        }
-
-        for (const auto& dept : deptStats) {
-            if (dept.second.second > 0) {
+        for (const auto& dept : classAttendanceStats()) {
+            if (!dept.first.empty() && dept.second.second > 0) {
                 float avgAttendance = dept.second.first / dept.second.second;
                 deptData.push_back({dept.first, avgAttendance});
             }
@@ -1000,15 +1390,16 @@ private:
         return deptData;
     }
 
-    map<string, vector<Exam>> examRecords;  // class -> exams
+    map<string, vector<Exam>> examRecords;  // class -> exams; in memory only, class files hold no grades
+    Gradebook gradebook;                    // columnar copy of examRecords marks
     map<string, ClassTeacher> classTeachers;  // class -> teacher
     vector<string> schoolAnnouncements;
     map<string, vector<string>> parentMessages;  // rollNo -> messages
     map<string, vector<Subject>> classSubjects;        // class -> subjects
     map<string, vector<ExamSchedule>> examSchedules;   // class -> exams
     map<string, vector<Homework>> studentHomework;     // rollNo -> homework
-    map<string, vector<ParentMeeting>> parentMeetings; // rollNo -> meetings
-    map<string, vector<string>> teacherRemarks;        // rollNo -> remarks
+    map<string, vector<ParentMeeting>> parentMeetings; // uniqueId -> meetings
+    map<string, vector<string>> teacherRemarks;        // uniqueId -> remarks
 
     struct ChatMessage {
         string from;
@@ -1017,51 +1408,49 @@ private:
         string date;
         bool isRead;
         string type; // "text", "homework", "attendance", "announcement"
+
+        friend void accountHeap(MemoryUsage& usage, const ChatMessage& chat) {
+            for (const string* field : {&chat.from, &chat.to, &chat.message, &chat.date, &chat.type}) {
+                accountHeap(usage, *field);
+            }
+        }
     };
 
     vector<ChatMessage> chatMessages;
     map<string, vector<string>> subscriptions; // rollNo -> notification types
+    unique_ptr<MemorySnapshot> previousMemorySnapshot;  // baseline for the next memory report
+    int memorySnapshotCount = 0;
 
     // Add these helper functions inside the AttendanceSystem class
     float getOverallAttendance(const string& className, const string& section) const {
-        vector<const Student*> classStudents;
         float totalAttendance = 0;
+        size_t count = 0;
+        roster.scanSection(roster.findSection(className, section), [&](size_t, float attendance) {
+            totalAttendance += attendance;
+            count++;
+        });
         
-        for (const auto& student : students) {
-            if (student.getClassName() == className && student.getSection() == section) {
-                classStudents.push_back(&student);
-                totalAttendance += student.getAttendancePercentage();
-            }
-        }
-        
-        return classStudents.empty() ? 0 : totalAttendance / classStudents.size();
+        return count == 0 ? 0 : totalAttendance / count;
     }
 
     string getBestStudent(const string& className, const string& section) const {
-        const Student* bestStudent = nullptr;
+        size_t bestRow = SIZE_MAX;
         float highestAttendance = 0;
-        
-        for (const auto& student : students) {
-            if (student.getClassName() == className && student.getSection() == section) {
-                float attendance = student.getAttendancePercentage();
-                if (attendance > highestAttendance) {
-                    highestAttendance = attendance;
-                    bestStudent = &student;
-                }
+        roster.scanSection(roster.findSection(className, section), [&](size_t row, float attendance) {
+            if (attendance > highestAttendance) {
+                highestAttendance = attendance;
+                bestRow = row;
             }
-        }
+        });
         
-        return bestStudent ? bestStudent->getName() : "N/A";
+        return bestRow != SIZE_MAX ? students[bestRow].getName() : "N/A";
     }
 
     float getBestAttendance(const string& className, const string& section) const {
         float highestAttendance = 0;
-        
-        for (const auto& student : students) {
-            if (student.getClassName() == className && student.getSection() == section) {
-                highestAttendance = max(highestAttendance, student.getAttendancePercentage());
-            }
-        }
+        roster.scanSection(roster.findSection(className, section), [&](size_t, float attendance) {
+            highestAttendance = max(highestAttendance, attendance);
+        });
         
         return highestAttendance;
     }
@@ -1079,7 +1468,7 @@ private:
     }
 
     // Add these methods to AttendanceSystem class
-    string getClassFilePath(const string& className, const string& section) {
+    string getClassFilePath(const string& className, const string& section) const {
         int classNum = stoi(className);
         string sectionFolder;
         
@@ -1093,27 +1482,97 @@ private:
                className + "_" + section + ".csv";
     }
 
+    // Renders a class-section and its stats on this thread and hands the
+    // files to the persistence worker, which replaces them atomically and
+    // records the class file in the backup store. Returns without waiting.
+    // The section's catalog entry is updated here; the caller queues the
+    // catalog itself once it has queued its sections.
+    void queueClassSave(const string& className, const string& section) {
+        METRIC_STAGE(STAGE_SAVE);
+        TRACE_SPAN_DETAIL("queueClassSave", className + "-" + section);
+        string filepath = getClassFilePath(className, section);
+        string content = renderClassFile(className, section);
+        catalog.update(summarizeSection(className, section, crc32c(content)), true);
+        vector<PersistFile> files;
+        files.push_back({filepath, move(content), true});
+        files.push_back({getStatsFilePath(className, section), renderAttendanceStats(className, section), false});
+        partitions.markSaving(className, section);
+        persistence.enqueue(PartitionTracker::keyFor(className, section), move(files));
+        reportPersistenceErrors();
+    }
+
+    // Saves one section and the catalog through the persistence worker and
+    // returns once they are queued; persistence.waitFor(key) or flush() is
+    // the barrier for a caller that needs them on disk
     void saveClassData(const string& className, const string& section) {
-        // Create backup before saving
-        if (filesystem::exists(getClassFilePath(className, section))) {
-            createBackup(className, section);
+        TRACE_SPAN_DETAIL("saveClassData", className + "-" + section);
+        queueClassSave(className, section);
+        queueCatalogSave();
+    }
+
+    // Catalog entry for a loaded section: its size, date range, attendance
+    // percentages and the present count on each of its last recorded dates
+    CatalogEntry summarizeSection(const string& className, const string& section, uint32_t checksum) const {
+        CatalogEntry entry;
+        entry.className = className;
+        entry.section = section;
+        entry.path = getClassFilePath(className, section);
+        entry.checksum = checksum;
+
+        // A student's mark on one of the section's last N dates is among
+        // their own last N marks, so those are all that needs scanning
+        map<string, uint32_t> recent;
+        for (const auto& student : students) {
+            if (student.getClassName() != className || student.getSection() != section) continue;
+            entry.students++;
+            entry.percentSum += student.getAttendancePercentage();
+            const auto& records = student.getAttendanceRecord().raw();
+            if (records.empty()) continue;
+            string first = records.front().key.str(), last = records.back().key.str();
+            if (entry.firstDate.empty() || first < entry.firstDate) entry.firstDate = first;
+            if (last > entry.lastDate) entry.lastDate = last;
+            size_t from = records.size() > CATALOG_RECENT_DATES ? records.size() - CATALOG_RECENT_DATES : 0;
+            for (size_t i = from; i < records.size(); i++) recent[records[i].key.str()] += records[i].value ? 1 : 0;
+        }
+        auto it = recent.size() > CATALOG_RECENT_DATES ? prev(recent.end(), CATALOG_RECENT_DATES) : recent.begin();
+        entry.recent.assign(it, recent.end());
+        return entry;
+    }
+
+    void reportPersistenceErrors() {
+        for (const PersistError& error : persistence.takeErrors()) {
+            partitions.markFailed(error.key);
+            showError(error.message);
+            logAction("Save failed: " + error.message);
         }
+    }
 
-        string filepath = getClassFilePath(className, section);
-        
-        // Ensure directory exists
-        filesystem::path dir = filesystem::path(filepath).parent_path();
-        filesystem::create_directories(dir);
+    // Class file in format v2 (see readClassFileHeader)
+    string renderClassFile(const string& className, const string& section) {
+        ostringstream file;
 
-        ofstream file(filepath);
-        if (!file.is_open()) {
-            showError("Could not open file: " + filepath);
-            return;
+        // Remark dictionary: a remark keeps the id its file already gave it, so
+        // rows that did not change keep their bytes; new remarks take fresh ids
+        unordered_map<uint32_t, uint32_t>& remarkIds = remarkDictionaries[className + "-" + section];
+        uint32_t nextId = 1;
+        for (const auto& entry : remarkIds) nextId = max(nextId, entry.second + 1);
+        map<uint32_t, uint32_t> dictionary;  // id -> remark, only the remarks still in use
+        for (const auto& student : students) {
+            if (student.getClassName() == className && student.getSection() == section) {
+                for (const auto& remark : student.getRemarks().raw()) {
+                    auto [entry, added] = remarkIds.emplace(remark.value, nextId);
+                    if (added) nextId++;
+                    dictionary.emplace(entry->second, remark.value);
+                }
+            }
         }
 
-        // Write header with version and metadata
-        file << "version:1.0,date:" << getCurrentDate() << "\n";
-        file << "Roll No,Name,Section,Contact,Email,Gender,DOB,AttendanceData,Remarks\n";
+        // Write header with version, metadata and the dictionary
+        file << "version:2.0,date:" << getCurrentDate() << ",remarks:" << dictionary.size() << "\n";
+        for (const auto& entry : dictionary) {
+            file << "remark:" << entry.first << ":" << stringPool().get(entry.second) << "\n";
+        }
+        file << "Roll No,Name,Section,Contact,Email,Gender,DOB,AttendanceData\n";
 
         for (const auto& student : students) {
             if (student.getClassName() == className && 
@@ -1128,36 +1587,65 @@ private:
                    << student.getGender() << ","
                    << student.getDateOfBirth() << ",";
 
-                // Enhanced attendance format with remarks
+                // date:status[:remark id]; remarks only exist on recorded dates
                 string attendanceStr;
-                for (const auto& record : student.getAttendanceRecord()) {
-                    string remark = student.getRemarkForDate(record.first);
-                    attendanceStr += record.first + ":" + 
-                                   (record.second ? "1" : "0") + 
-                                   (remark.empty() ? "" : ":" + remark) + ";";
+                const auto& remarks = student.getRemarks().raw();
+                auto remark = remarks.begin();
+                for (const auto& record : student.getAttendanceRecord().raw()) {
+                    attendanceStr.append(record.key.text, strnlen(record.key.text, DateKey::LENGTH));
+                    attendanceStr += record.value ? ":1" : ":0";
+                    while (remark != remarks.end() && remark->key < record.key) ++remark;
+                    if (remark != remarks.end() && remark->key == record.key) {
+                        attendanceStr += ":" + to_string(remarkIds[remark->value]);
+                    }
+                    attendanceStr += ';';
                 }
                 ss << attendanceStr << "\n";
 
                 // Validate before writing
                 if (validateFileData(ss.str())) {
                     file << ss.str();
+                    METRIC_ADD(COUNTER_ROWS_WRITTEN, 1);
                 } else {
+                    METRIC_ADD(COUNTER_ROWS_REJECTED, 1);
                     showWarning("Invalid data found for student: " + student.getName());
                 }
             }
         }
-        file.close();
-        
-        // Generate attendance statistics file
-        generateAttendanceStats(className, section);
+        return file.str();
     }
 
-    void generateAttendanceStats(const string& className, const string& section) {
+    // ISO-8601 week label, e.g. "2024-W23"; a week belongs to the year of its Thursday
+    string getWeekNumber(const string& date) const {
+        int day = dayNumberFromDate(date);
+        if (day == INVALID_DAY) return "unknown";
+
+        int thursday = day - (weekdayFromDayNumber(day) + 6) % 7 + 3;
+        int year, month, dayOfMonth;
+        civilFromDayNumber(thursday, year, month, dayOfMonth);
+        int week = (thursday - dayNumberFromCivil(year, 1, 1)) / 7 + 1;
+
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "%04d-W%02d", year, week);
+        return string(buffer);
+    }
+
+    string getStatsFilePath(const string& className, const string& section) {
         string statsFile = getClassFilePath(className, section);
-        statsFile = statsFile.substr(0, statsFile.length() - 4) + "_stats.txt";
-        
-        ofstream file(statsFile);
+        return statsFile.substr(0, statsFile.length() - 4) + "_stats.txt";
+    }
+
+    void generateAttendanceStats(const string& className, const string& section) {
+        string stats = renderAttendanceStats(className, section);
+        ofstream file(getStatsFilePath(className, section));
         if (!file.is_open()) return;
+        file << stats;
+    }
+
+    string renderAttendanceStats(const string& className, const string& section) {
+        METRIC_STAGE(STAGE_AGGREGATE);
+        TRACE_SPAN_DETAIL("generateAttendanceStats", className + "-" + section);
+        ostringstream file;
 
         vector<Student*> classStudents;
         for (auto& student : students) {
@@ -1218,21 +1706,77 @@ private:
             file << trend.first << ": " << trend.second << "%\n";
         }
 
-        file.close();
+        return file.str();
+    }
+
+    // Reads a class file's preamble and leaves the stream at the first student row.
+    //   v1: "version:1.0,date:...", then the column header
+    //   v2: "version:2.0,date:...,remarks:N", then one "remark:<id>:<text>" line
+    //       per dictionary entry, then the column header
+    // remarkIds maps dictionary ids to interned remarks (id 0 is "no remark").
+    // Returns the format version; files with no version line count as v1.
+    int readClassFileHeader(istream& file, vector<uint32_t>& remarkIds) {
+        remarkIds.assign(1, StringPool::EMPTY_ID);
+        int version = 1;
+        string line;
+        streampos rowStart = file.tellg();
+        while (getline(file, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (line.starts_with("version:")) {
+                version = max(1, atoi(line.c_str() + 8));
+            } else if (line.starts_with("remark:")) {
+                size_t colon = line.find(':', 7);
+                if (colon == string::npos) continue;
+                size_t id = strtoul(line.c_str() + 7, nullptr, 10);
+                if (id == 0 || id > MAX_REMARK_IDS) continue;
+                if (id >= remarkIds.size()) remarkIds.resize(id + 1, StringPool::EMPTY_ID);
+                remarkIds[id] = stringPool().intern(string_view(line).substr(colon + 1));
+            } else if (line.starts_with("Roll No,")) {
+                return version;
+            } else {
+                file.clear();
+                file.seekg(rowStart);  // no column header: this line is already a student
+                return version;
+            }
+            rowStart = file.tellg();
+        }
+        return version;
     }
 
     void loadClassData(const string& className, const string& section) {
+        METRIC_STAGE(STAGE_LOAD);
+        // Once read, memory is authoritative and a reload would duplicate every student
+        if (partitions.isLoaded(className, section)) return;
+        TRACE_SPAN_DETAIL("loadClassData", className + "-" + section);
+        persistence.waitFor(PartitionTracker::keyFor(className, section));  // read back our own pending save
         string filepath = getClassFilePath(className, section);
-        ifstream file(filepath);
+        partitions.markLoaded(className, section);
+        ifstream in(filepath, ios::binary);
         
-        if (!file.is_open()) {
+        if (!in.is_open()) {
             return; // File doesn't exist yet
         }
+        METRIC_ADD(COUNTER_FILES_LOADED, 1);
+        string content((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+        in.close();
+        uint32_t checksum = crc32c(content);
+        istringstream file(move(content));
 
+        // Packed records take about as much room as their CSV text
+        SectionArena& arena = arenaFor(className, section, file.view().size());
+
+        vector<uint32_t> remarkIds;
+        int version = readClassFileHeader(file, remarkIds);
+        unordered_map<uint32_t, uint32_t>& dictionary = remarkDictionaries[className + "-" + section];
+        dictionary.clear();
+        for (uint32_t id = 1; id < remarkIds.size(); id++) {
+            if (remarkIds[id] != StringPool::EMPTY_ID) dictionary.emplace(remarkIds[id], id);
+        }
         string line;
-        getline(file, line); // Skip header
 
         while (getline(file, line)) {
+            METRIC_STAGE(STAGE_PARSE);
+            METRIC_ADD(COUNTER_ROWS_PARSED, 1);
             stringstream ss(line);
             string roll, name, sect, contact, email, gender, dob, attendanceData;
             
@@ -1246,42 +1790,116 @@ private:
             getline(ss, attendanceData);
 
             // Create student
-            Student student(roll, name, className, sect, contact, email, gender, dob);
+            Student student(roll, name, className, sect, contact, email, gender, dob, &arena);
 
             // Load attendance data
-            stringstream attSS(attendanceData);
-            string record;
-            while (getline(attSS, record, ';')) {
+            string_view records(attendanceData);
+            student.reserveAttendance(std::count(records.begin(), records.end(), ';'));
+            while (!records.empty()) {
+                size_t end = records.find(';');
+                string_view record = records.substr(0, end);
+                records = end == string_view::npos ? string_view() : records.substr(end + 1);
                 if (record.empty()) continue;
                 size_t pos = record.find(':');
-                if (pos != string::npos) {
-                    string date = record.substr(0, pos);
-                    bool present = (record.substr(pos + 1) == "1");
-                    student.markAttendance(date, present);
+                if (pos != string_view::npos) {
+                    // date:status, then an optional remark: a dictionary id in v2, inline text in v1
+                    string_view status = record.substr(pos + 1);
+                    string_view remark;
+                    size_t remarkPos = status.find(':');
+                    if (remarkPos != string_view::npos) {
+                        remark = status.substr(remarkPos + 1);
+                        status = status.substr(0, remarkPos);
+                    }
+                    uint32_t remarkId = StringPool::EMPTY_ID;
+                    if (!remark.empty()) {
+                        if (version >= 2) {
+                            size_t id = 0;
+                            from_chars(remark.data(), remark.data() + remark.size(), id);
+                            if (id < remarkIds.size()) remarkId = remarkIds[id];
+                        } else {
+                            remarkId = stringPool().intern(remark);
+                        }
+                    }
+                    student.markAttendance(record.substr(0, pos), status == "1", remarkId);
                 }
             }
+            METRIC_ADD(COUNTER_RECORDS_PARSED, student.getAttendanceRecord().size());
+
+            // Prime the early-warning windows without notifying anyone
+            student.recordAbsenceWarning(
+                warningEngine.rebuild(student.getWarningState(), student.getAttendanceRecord()));
+            student.setProbation(warningEngine.onProbation(student.getWarningState()));
 
             // Add to students vector
-            students.push_back(student);
+            students.push_back(std::move(student));
+            indexNewStudent();
+        }
+
+        // A file written or changed behind the catalog's back refreshes its entry
+        const CatalogEntry* entry = catalog.find(className, section);
+        if (entry && entry->checksum != checksum) logAction("Class file changed outside the app: " + filepath);
+        if (!entry || entry->checksum != checksum) {
+            catalog.update(summarizeSection(className, section, checksum), entry != nullptr);
         }
-        file.close();
     }
 
-    void createBackup(const string& className, const string& section) {
-        string sourceFile = getClassFilePath(className, section);
-        string backupFile = sourceFile.substr(0, sourceFile.length() - 4) + 
-                           "_backup_" + getCurrentDate() + ".csv";
-        
-        ifstream src(sourceFile, ios::binary);
-        ofstream dst(backupFile, ios::binary);
-        
-        if (src && dst) {
-            dst << src.rdbuf();
-            showSuccess("Backup created: " + backupFile);
+    // Adds the roster row and search entry for the student just appended to students
+    void indexNewStudent() {
+        const Student& student = students.back();
+        roster.append(student.getClassId(), student.getSectionId(), student.getAttendanceRecord());
+        searchIndex.add(student.getUniqueId(), student.getClassName(), student.getSection(), student.getRollNo(),
+                        student.getName(), student.getParentName(),
+                        student.getContactNo() + " " + student.getParentPhone());
+
+        // A reloaded section re-offers the same text, which the index skips
+        string owner = student.getUniqueId();
+        for (const auto& remark : student.getRemarks().raw()) {
+            indexText(owner, TEXT_REMARK, remark.key.str(), stringPool().get(remark.value), true);
+        }
+        for (const auto& note : student.getBehaviorNotes().raw()) {
+            indexText(owner, TEXT_BEHAVIOR, note.key.str(), string(note.value), true);
+        }
+
+        if (joinHistoryOnLoad && history.started()) {
+            history.join(owner, student.getTotalPresent(), (int)student.getAttendanceRecord().size(), time(nullptr));
+        }
+    }
+
+    void indexText(const string& owner, TextSource source, const string& date, const string& text, bool replaces) {
+        textIndex.add(owner, source, dayNumberFromDate(date), text, replaces);
+    }
+
+    // Adds the remarks of archived years not indexed yet, filed under the ids
+    // the students had that year. A remark still in memory is not added twice.
+    void indexArchivedRemarks() {
+        for (int year : archive.years()) {
+            if (indexedArchiveYears.count(year)) continue;
+            string error;
+            const ArchiveSegment* segment = archive.segment(year, error);
+            if (!segment) {
+                showError(error);
+                continue;
+            }
+            for (size_t i = 0; i < segment->studentCount(); i++) {
+                const ArchiveStudent& entry = segment->student(i);
+                string owner(segment->idOf(entry));
+                segment->forEachRemark(entry, [&](int day, string_view text) {
+                    textIndex.add(owner, TEXT_REMARK, day, string(text), true);
+                });
+            }
+            indexedArchiveYears.insert(year);
         }
     }
 
+    SectionArena& arenaFor(const string& className, const string& section, size_t sizeHint = 0) {
+        unique_ptr<SectionArena>& arena = sectionArenas[className + "-" + section];
+        if (!arena) arena = make_unique<SectionArena>(sizeHint);
+        return *arena;
+    }
+
     bool validateFileData(const string& line) {
+        METRIC_STAGE(STAGE_VALIDATE);
+        TRACE_SPAN("validateFileData");
         stringstream ss(line);
         string roll, name, sect, contact, email, gender, dob, attendanceData;
         
@@ -1343,14 +1961,51 @@ private:
     }
 
 public:
+    // Startup reads only the catalog; sections load on first access. Without
+    // a usable catalog every class file is read once and the catalog built.
     AttendanceSystem() {
-        loadFromFile();
+        recoverInterruptedSaves();
+        resumeRollover();
+        if (!catalog.load(getCatalogPath())) loadAllSections();
     }
 
     ~AttendanceSystem() {
         saveToFile();
     }
 
+    // Drops a class-section from memory and frees its arena in one step.
+    // Its students' search documents and remark and behavior-note text are
+    // retired until the section is loaded again. Unsaved changes to those
+    // students are lost; returns how many were dropped.
+    size_t evictSection(const string& className, const string& section) {
+        size_t before = students.size();
+        students.erase(remove_if(students.begin(), students.end(), [&](const Student& student) {
+            if (student.getClassName() != className || student.getSection() != section) return false;
+            string owner = student.getUniqueId();
+            searchIndex.retire(owner);
+            for (const auto& remark : student.getRemarks().raw()) {
+                textIndex.retire(owner, TEXT_REMARK, dayNumberFromDate(remark.key.str()));
+            }
+            for (const auto& note : student.getBehaviorNotes().raw()) {
+                textIndex.retire(owner, TEXT_BEHAVIOR, dayNumberFromDate(note.key.str()));
+            }
+            return true;
+        }), students.end());
+        uint32_t slot = roster.findSection(className, section);
+        if (slot != AttendanceRoster::NO_SLOT) roster.removeSection(slot);
+        partitions.forget(className, section);
+        allSectionsLoaded = false;
+
+        auto arena = sectionArenas.find(className + "-" + section);
+        if (arena != sectionArenas.end()) {
+            bool shared = any_of(students.begin(), students.end(), [&](const Student& student) {
+                return student.getArena() == arena->second.get();
+            });
+            if (!shared) sectionArenas.erase(arena);
+        }
+        return before - students.size();
+    }
+
     bool login(const string& password) {
         isLoggedIn = (password == ADMIN_PASSWORD);
         return isLoggedIn;
@@ -1369,6 +2024,9 @@ public:
         cout << "Enter Section: ";
         getline(cin, sect);
 
+        // The section may still be on disk only; load it so the check below sees its students
+        if (!class_.empty() && all_of(class_.begin(), class_.end(), ::isdigit)) loadClassData(class_, sect);
+
         // Check if roll number exists in the same class and section
         string uniqueId = class_ + "_" + sect + "_" + roll;
         if (any_of(students.begin(), students.end(),
@@ -1408,19 +2066,318 @@ public:
             return;
         }
 
-        students.push_back(Student(roll, name, class_, sect, contact, email, gender, dob));
+        students.push_back(Student(roll, name, class_, sect, contact, email, gender, dob,
+                                   &arenaFor(class_, sect)));
+        indexNewStudent();
+        partitions.markDirty(class_, sect);
         logAction("Added new student: " + name + " to class " + class_ + "-" + sect);
         showSuccess("Student added successfully!");
     }
 
-    void markAttendance() {
-        if (students.empty()) {
-            showError("No students registered yet!");
-            return;
+    // Every attendance mark goes through here so the early-warning rules see it.
+    // Rules are evaluated against the student's sliding-window counters; only
+    // a correction of an older date replays that student's record. With
+    // change set, the mark and what it derived are captured for undo.
+    void recordAttendanceMark(Student& student, const string& date, bool present, const string& remark = "",
+                              MarkChange* change = nullptr) {
+        const FlatDateMap<bool>& record = student.getAttendanceRecord();
+        bool newest = record.empty() || record.raw().back().key < DateKey(date);
+        const bool* previous = record.lookup(date);
+        int before = previous ? *previous : -1;
+        size_t row = &student - students.data();
+        size_t alertsBefore = pendingParentNotifications.size();
+        if (change) {
+            const uint32_t* remarkId = student.getRemarks().lookup(date);
+            *change = MarkChange();
+            change->uniqueId = student.getUniqueId();
+            change->className = student.getClassName();
+            change->section = student.getSection();
+            change->row = row;
+            change->date = date;
+            change->before = before;
+            change->after = present;
+            change->beforeRemark = remarkId ? *remarkId : StringPool::EMPTY_ID;
+            if (row < roster.size()) change->rosterBefore = roster.counters(row);
+            change->windowBefore = student.getWarningState();
+            change->probationBefore = student.getIsOnProbation();
+        }
+        student.markAttendance(date, present, remark);
+        if (history.started()) history.recordMark(student.getUniqueId(), date, before, present, time(nullptr));
+
+        if (row < roster.size()) {
+            if (newest) roster.recordNewest(row, date, present);
+            else roster.refresh(row, record);
+        }
+        if (!remark.empty()) indexText(student.getUniqueId(), TEXT_REMARK, date, remark, true);
+        partitions.markDirty(student.getClassName(), student.getSection());
+
+        vector<int> fired;
+        AttendanceWindowState& window = student.getWarningState();
+        if (!warningEngine.observe(window, dayNumberFromDate(date), present, fired)) {
+            warningEngine.rebuild(window, student.getAttendanceRecord());
+        }
+
+        for (int rule : fired) {
+            student.recordAbsenceWarning();
+            pendingParentNotifications.push_back({
+                "Attendance alert for " + student.getName() + ": " +
+                    warningEngine.getRules()[rule].description,
+                date,
+                "urgent",
+                false,
+                {student.getRollNo()}
+            });
         }
+        student.setProbation(warningEngine.onProbation(window));
 
-        clearScreen();
-        printTitle("Mark Attendance");
+        if (change) {
+            const uint32_t* remarkId = student.getRemarks().lookup(date);
+            change->afterRemark = remarkId ? *remarkId : StringPool::EMPTY_ID;
+            if (row < roster.size()) change->rosterAfter = roster.counters(row);
+            change->windowAfter = window;
+            change->probationAfter = student.getIsOnProbation();
+            change->alerts.assign(pendingParentNotifications.begin() + alertsBefore, pendingParentNotifications.end());
+        }
+    }
+
+    // Hands queued early-warning alerts to the parent notification list
+    size_t dispatchParentNotifications() {
+        size_t count = pendingParentNotifications.size();
+        while (!pendingParentNotifications.empty()) {
+            Notification& notification = pendingParentNotifications.front();
+            parentMessages[notification.recipients.front()].push_back(notification.message);
+            logAction("Sent attendance alert to parent of " + notification.recipients.front());
+            notificationList.push_back(move(notification));
+            pendingParentNotifications.pop_front();
+        }
+        return count;
+    }
+
+    // A change's student, reloading its section if it was evicted since
+    Student* studentForChange(MarkChange& change) {
+        if (change.row < students.size() && students[change.row].getUniqueId() == change.uniqueId) {
+            return &students[change.row];
+        }
+        loadClassData(change.className, change.section);
+        for (size_t row = 0; row < students.size(); row++) {
+            if (students[row].getUniqueId() == change.uniqueId) {
+                change.row = row;
+                return &students[row];
+            }
+        }
+        return nullptr;
+    }
+
+    // Reverts a change or, with redo set, reapplies it. The roster counters
+    // and warning window captured with the change are put back when nothing
+    // has touched the student since; otherwise that student alone is
+    // recomputed. Alerts the mark raised are withdrawn or sent again. False,
+    // with nothing changed, when the mark was changed again since.
+    bool applyMarkChange(MarkChange& change, bool redo) {
+        Student* student = studentForChange(change);
+        if (!student || isClosedDate(change.date)) return false;
+        int from = redo ? change.before : change.after, to = redo ? change.after : change.before;
+        const bool* current = student->getAttendanceRecord().lookup(change.date);
+        if ((current ? (int)*current : -1) != from) return false;
+
+        size_t row = change.row;
+        AttendanceWindowState& window = student->getWarningState();
+        bool untouched = row < roster.size() && roster.counters(row) == (redo ? change.rosterBefore : change.rosterAfter) &&
+                         window == (redo ? change.windowBefore : change.windowAfter);
+        uint32_t remarkId = redo ? change.afterRemark : change.beforeRemark;
+        student->setMark(change.date, to, remarkId);
+        if (history.started()) history.recordMark(change.uniqueId, change.date, from, to, time(nullptr));
+        if (untouched) {
+            roster.restore(row, redo ? change.rosterAfter : change.rosterBefore);
+            window = redo ? change.windowAfter : change.windowBefore;
+        } else {
+            if (row < roster.size()) roster.refresh(row, student->getAttendanceRecord());
+            warningEngine.rebuild(window, student->getAttendanceRecord());
+        }
+        student->setProbation(warningEngine.onProbation(window));
+
+        if (remarkId != StringPool::EMPTY_ID) {
+            indexText(change.uniqueId, TEXT_REMARK, change.date, stringPool().get(remarkId), true);
+        } else {
+            textIndex.retire(change.uniqueId, TEXT_REMARK, dayNumberFromDate(change.date));
+        }
+
+        for (const Notification& alert : change.alerts) {
+            const string& rollNo = alert.recipients.front();
+            if (redo) {
+                parentMessages[rollNo].push_back(alert.message);
+                notificationList.push_back(alert);
+                student->recordAbsenceWarning();
+                logAction("Sent attendance alert to parent of " + rollNo);
+                continue;
+            }
+            vector<string>& messages = parentMessages[rollNo];
+            auto message = find(messages.rbegin(), messages.rend(), alert.message);
+            if (message != messages.rend()) messages.erase(next(message).base());
+            auto sent = find_if(notificationList.rbegin(), notificationList.rend(), [&](const Notification& n) {
+                return n.message == alert.message && n.date == alert.date;
+            });
+            if (sent != notificationList.rend()) notificationList.erase(next(sent).base());
+            student->recordAbsenceWarning(-1);
+            logAction("Withdrew attendance alert to parent of " + rollNo);
+        }
+        partitions.markDirty(change.className, change.section);
+        return true;
+    }
+
+    // Reverts an action's changes, newest first, or reapplies them in order,
+    // then saves the sections they touched. Changes that could not be applied
+    // are dropped from the action; returns how many were.
+    size_t applyMarkAction(MarkAction& action, bool redo) {
+        METRIC_STAGE(STAGE_SAVE);
+        TRACE_SPAN_DETAIL(redo ? "redoMarking" : "undoMarking", action.label);
+        vector<MarkChange> applied;
+        set<pair<string, string>> sections;
+        size_t count = action.changes.size();
+        for (size_t i = 0; i < count; i++) {
+            MarkChange& change = action.changes[redo ? i : count - 1 - i];
+            if (!applyMarkChange(change, redo)) continue;
+            sections.insert({change.className, change.section});
+            applied.push_back(move(change));
+        }
+        if (!redo) reverse(applied.begin(), applied.end());
+        action.changes = move(applied);
+
+        for (const auto& section : sections) queueClassSave(section.first, section.second);
+        queueCatalogSave();
+        flushHistory();
+        return count - action.changes.size();
+    }
+
+    void reportMarkStep(const string& verb, const MarkAction& action, size_t skipped) {
+        logAction(verb + " " + action.label + ": " + to_string(action.changes.size()) + " entries");
+        if (!action.changes.empty()) {
+            showSuccess(verb + " " + action.label + " (" + to_string(action.changes.size()) + " entries)");
+        }
+        if (skipped > 0) {
+            showWarning(to_string(skipped) + " entries were marked again since and were left as they are");
+        }
+    }
+
+    // Reverts this session's latest marking step
+    bool undoMarking() {
+        if (undoActions.empty()) {
+            showError("Nothing to undo");
+            return false;
+        }
+        MarkAction action = move(undoActions.back());
+        undoActions.pop_back();
+        size_t skipped = applyMarkAction(action, false);
+        reportMarkStep("Undid", action, skipped);
+        if (action.changes.empty()) return false;
+        redoActions.push_back(move(action));
+        return true;
+    }
+
+    // Reapplies the step undone last
+    bool redoMarking() {
+        if (redoActions.empty()) {
+            showError("Nothing to redo");
+            return false;
+        }
+        MarkAction action = move(redoActions.back());
+        redoActions.pop_back();
+        size_t skipped = applyMarkAction(action, true);
+        reportMarkStep("Redid", action, skipped);
+        if (action.changes.empty()) return false;
+        undoActions.push_back(move(action));
+        return true;
+    }
+
+    // Reverts one student's entry from their latest marking this session,
+    // leaving the rest of that batch in place
+    bool undoStudentEntry(const string& className, const string& section, const string& rollNo) {
+        string uniqueId = className + "_" + section + "_" + rollNo;
+        for (size_t i = undoActions.size(); i-- > 0;) {
+            vector<MarkChange>& changes = undoActions[i].changes;
+            auto found = find_if(changes.begin(), changes.end(), [&](const MarkChange& change) {
+                return change.uniqueId == uniqueId;
+            });
+            if (found == changes.end()) continue;
+            MarkAction single{"roll " + rollNo + " of " + undoActions[i].label, {}};
+            single.changes.push_back(move(*found));
+            changes.erase(found);
+            if (changes.empty()) undoActions.erase(undoActions.begin() + i);
+
+            size_t skipped = applyMarkAction(single, false);
+            reportMarkStep("Undid", single, skipped);
+            if (single.changes.empty()) return false;
+            redoActions.push_back(move(single));
+            return true;
+        }
+        showError("No marking of roll " + rollNo + " in class " + className + "-" + section + " to undo");
+        return false;
+    }
+
+    using MarkDecision = function<bool(const Student& student, string& remark)>;
+
+    // Non-interactive core of markAttendance, also driven by the load harness:
+    // asks decide() for every student of the section in roster order, records
+    // the marks, sends early-warning alerts and saves the section. Returns the
+    // number of students marked (0 when the section has no students or the
+    // date is in a closed year).
+    size_t markSectionAttendance(const string& className, const string& section,
+                                 const string& date, const MarkDecision& decide) {
+        if (isClosedDate(date)) return 0;
+        ensureHistoryStarted();  // marks are still taken when history cannot start
+
+        // Load class data first
+        loadClassData(className, section);
+
+        // Filter students by class and section
+        vector<Student*> classStudents;
+        for (auto& student : students) {
+            if (student.getClassName() == className && student.getSection() == section) {
+                classStudents.push_back(&student);
+            }
+        }
+
+        if (classStudents.empty()) {
+            return 0;
+        }
+
+        MarkAction batch{"Class " + className + "-" + section + " on " + date, {}};
+        for (auto* student : classStudents) {
+            string remark;
+            bool present = decide(*student, remark);
+            MarkChange change;
+            recordAttendanceMark(*student, date, present, remark, &change);
+            if (change.before != change.after || change.beforeRemark != change.afterRemark || !change.alerts.empty()) {
+                batch.changes.push_back(move(change));
+            }
+            logAction("Marked " + string(present ? "present" : "absent") + 
+                     " for " + student->getName());
+        }
+        if (!batch.changes.empty()) {
+            undoActions.push_back(move(batch));
+            redoActions.clear();
+        }
+
+        size_t alerts = dispatchParentNotifications();
+        if (alerts > 0) {
+            showWarning(to_string(alerts) + " attendance alert(s) sent to parents");
+        }
+
+        // Saved in the background; the next load of this section waits for it
+        queueClassSave(className, section);
+        queueCatalogSave();
+        flushHistory();
+        return classStudents.size();
+    }
+
+    void markAttendance() {
+        if (totalStudents() == 0) {
+            showError("No students registered yet!");
+            return;
+        }
+
+        clearScreen();
+        printTitle("Mark Attendance");
 
         // Get class and section first
         string className, section;
@@ -1458,57 +2415,47 @@ public:
         } else if (!validateDate(date)) {
             showError("Invalid date format! Use YYYY-MM-DD");
             return;
+        } else if (isClosedDate(date)) {
+            showError("The " + academicYearLabel(academicYearOf(date)) + " academic year is closed");
+            return;
         }
 
-        // Load class data first
-        loadClassData(className, section);
+        bool headerShown = false;
+        size_t marked = markSectionAttendance(className, section, date,
+            [&](const Student& student, string& remark) {
+                if (!headerShown) {
+                    clearScreen();
+                    cout << "\nMarking attendance for Class " << className << "-" << section 
+                         << " Date: " << date << endl;
+                    cout << setfill('=') << setw(50) << "=" << endl;
+                    headerShown = true;
+                }
 
-        // Filter students by class and section
-        vector<Student*> classStudents;
-        for (auto& student : students) {
-            if (student.getClassName() == className && student.getSection() == section) {
-                classStudents.push_back(&student);
-            }
-        }
+                char present;
+                cout << "\nRoll No: " << student.getRollNo()
+                     << "\nName: " << student.getName();
+                     
+                do {
+                    cout << "\nPresent? (y/n): ";
+                    present = tolower(readKey());
+                    cout << present << endl;
+                } while (present != 'y' && present != 'n');
+                
+                cout << "Enter remark (optional): ";
+                getline(cin, remark);
+                return present == 'y';
+            });
 
-        if (classStudents.empty()) {
+        if (marked == 0) {
             showError("No students found in class " + className + "-" + section);
             return;
         }
 
-        clearScreen();
-        cout << "\nMarking attendance for Class " << className << "-" << section 
-             << " Date: " << date << endl;
-        cout << setfill('=') << setw(50) << "=" << endl;
-
-        for (auto* student : classStudents) {
-            char present;
-            string remark;
-            
-            cout << "\nRoll No: " << student->getRollNo()
-                 << "\nName: " << student->getName();
-                 
-            do {
-                cout << "\nPresent? (y/n): ";
-                present = tolower(_getch());
-                cout << present << endl;
-            } while (present != 'y' && present != 'n');
-            
-            cout << "Enter remark (optional): ";
-            getline(cin, remark);
-            
-            student->markAttendance(date, (present == 'y'), remark);
-            logAction("Marked " + string(present == 'y' ? "present" : "absent") + 
-                     " for " + student->getName());
-        }
-
-        // Save after marking attendance
-        saveClassData(className, section);
         showSuccess("Attendance marked and saved successfully!");
     }
 
     void viewAttendance() {
-        if (students.empty()) {
+        if (totalStudents() == 0) {
             showError("No students registered yet!");
             return;
         }
@@ -1561,11 +2508,11 @@ public:
         }
 
         cout << "\nPress any key to continue...";
-        _getch();
+        readKey();
     }
 
     void searchStudent() {
-        if (students.empty()) {
+        if (totalStudents() == 0) {
             showError("No students registered yet!");
             return;
         }
@@ -1573,6 +2520,22 @@ public:
         clearScreen();
         printTitle("Search Student");
 
+        cout << "1. Whole School (name, parent, contact or roll no)\n";
+        cout << "2. One Class and Section\n";
+        cout << "3. Remarks and Notes (whole school)\n\n";
+
+        int scope;
+        cout << "Enter choice: ";
+        cin >> scope;
+        if (scope == 1) {
+            searchSchool();
+            return;
+        }
+        if (scope == 3) {
+            searchNotes();
+            return;
+        }
+
         // Get class and section first
         string className, section;
         cout << "Enter Class (1-12): ";
@@ -1612,29 +2575,7 @@ public:
                 student.getSection() == section &&
                 (student.getRollNo() == search || 
                  student.getName().find(search) != string::npos)) {
-                
-                clearScreen();
-                cout << "\nStudent Details:\n";
-                cout << setfill('=') << setw(50) << "=" << endl;
-                cout << "Roll No: " << student.getRollNo() << endl;
-                cout << "Name: " << student.getName() << endl;
-                cout << "Class: " << student.getClassName() << endl;
-                cout << "Section: " << student.getSection() << endl;
-                cout << "Contact: " << student.getContactNo() << endl;
-                cout << "Email: " << student.getEmail() << endl;
-                cout << "Gender: " << student.getGender() << endl;
-                cout << "Date of Birth: " << student.getDateOfBirth() << endl;
-                
-                cout << "\nAttendance Summary:\n";
-                cout << setfill('-') << setw(50) << "-" << endl;
-                cout << "Total Present: " << student.getTotalPresent() << endl;
-                cout << "Total Absent: " << student.getTotalAbsent() << endl;
-                cout << "Attendance Percentage: " << fixed << setprecision(2) 
-                     << student.getAttendancePercentage() << "%" << endl;
-                
-                cout << "\nAttendance History:\n";
-                cout << setfill('-') << setw(50) << "-" << endl;
-                cout << student.getAttendanceDetails();
+                showStudentDetails(student);
                 found = true;
                 break;
             }
@@ -1645,7 +2586,137 @@ public:
         }
     }
 
+    // Typo-tolerant lookup across every student indexed this session
+    void searchSchool() {
+        loadAllSections();
+        string query;
+        cout << "Enter name, parent name, contact or roll no: ";
+        cin.ignore();
+        getline(cin, query);
+
+        vector<SearchHit> hits;
+        {
+            TRACE_SPAN("searchSchool");
+            hits = searchIndex.search(query, 10);
+        }
+        if (hits.empty()) {
+            showError("No students match \"" + query + "\"");
+            return;
+        }
+
+        cout << "\n" << left << setw(4) << "#" << setw(25) << "Name" << setw(10) << "Class"
+             << setw(10) << "Roll No" << "Matched" << endl;
+        cout << setfill('-') << setw(65) << "-" << setfill(' ') << endl;
+        for (size_t i = 0; i < hits.size(); i++) {
+            const SearchDocument& doc = searchIndex.document(hits[i].doc);
+            string matched = SEARCH_FIELD_NAMES[hits[i].field];
+            if (hits[i].distance > 0) matched += " (" + to_string(hits[i].distance) + " typo" +
+                                                 (hits[i].distance > 1 ? "s)" : ")");
+            cout << left << setw(4) << i + 1 << setw(25) << doc.name << setw(10)
+                 << doc.className + "-" + doc.section << setw(10) << doc.rollNo << matched << endl;
+        }
+        cout << right;
+
+        size_t pick;
+        cout << "\nEnter result number for details (0 to go back): ";
+        if (!(cin >> pick) || pick < 1 || pick > hits.size()) {
+            cin.clear();
+            return;
+        }
+
+        // The section may have been evicted since it was indexed
+        const SearchDocument& doc = searchIndex.document(hits[pick - 1].doc);
+        const Student* student = findStudentByUniqueId(doc.uniqueId);
+        if (!student) {
+            loadClassData(doc.className, doc.section);
+            student = findStudentByUniqueId(doc.uniqueId);
+        }
+        if (!student) {
+            showError("Records for " + doc.name + " are not loaded");
+            return;
+        }
+        showStudentDetails(*student);
+    }
+
+    // Words in remarks, behavior notes, teacher remarks and meeting feedback,
+    // optionally limited to a date range
+    void searchNotes() {
+        loadAllSections();
+        indexArchivedRemarks();
+        string words, from, to;
+        cout << "Enter words to find: ";
+        cin.ignore();
+        getline(cin, words);
+        cout << "From date (YYYY-MM-DD, blank for any): ";
+        getline(cin, from);
+        cout << "To date (YYYY-MM-DD, blank for any): ";
+        getline(cin, to);
+        if ((!from.empty() && !validateDate(from)) || (!to.empty() && !validateDate(to))) {
+            showError("Invalid date format! Use YYYY-MM-DD");
+            return;
+        }
+
+        vector<uint32_t> matches;
+        {
+            TRACE_SPAN("searchNotes");
+            matches = textIndex.query(words, from.empty() ? INT_MIN : dayNumberFromDate(from),
+                                      to.empty() ? INT_MAX : dayNumberFromDate(to));
+        }
+        if (matches.empty()) {
+            showError("No remarks or notes match \"" + words + "\"");
+            return;
+        }
+
+        const size_t shown = min(matches.size(), (size_t)50);
+        cout << "\n" << matches.size() << " match(es)"
+             << (shown < matches.size() ? ", showing the first " + to_string(shown) : "") << "\n\n";
+        cout << left << setw(12) << "Date" << setw(25) << "Student" << setw(18) << "Source" << "Text" << endl;
+        cout << setfill('-') << setw(80) << "-" << setfill(' ') << endl;
+        for (size_t i = 0; i < shown; i++) {
+            const TextOccurrence& match = textIndex.occurrence(matches[i]);
+            const string& owner = stringPool().get(match.ownerId);
+            const Student* student = findStudentByUniqueId(owner);
+            cout << left << setw(12) << (match.day == INVALID_DAY ? "-" : dateFromDayNumber(match.day))
+                 << setw(25) << (student ? student->getName() : owner)
+                 << setw(18) << TEXT_SOURCE_NAMES[match.source] << stringPool().get(match.textId) << endl;
+        }
+        cout << right;
+    }
+
+    const Student* findStudentByUniqueId(const string& uniqueId) const {
+        for (const auto& student : students) {
+            if (student.getUniqueId() == uniqueId) return &student;
+        }
+        return nullptr;
+    }
+
+    void showStudentDetails(const Student& student) {
+        clearScreen();
+        cout << "\nStudent Details:\n";
+        cout << setfill('=') << setw(50) << "=" << endl;
+        cout << "Roll No: " << student.getRollNo() << endl;
+        cout << "Name: " << student.getName() << endl;
+        cout << "Class: " << student.getClassName() << endl;
+        cout << "Section: " << student.getSection() << endl;
+        cout << "Contact: " << student.getContactNo() << endl;
+        cout << "Email: " << student.getEmail() << endl;
+        cout << "Gender: " << student.getGender() << endl;
+        cout << "Date of Birth: " << student.getDateOfBirth() << endl;
+        
+        cout << "\nAttendance Summary:\n";
+        cout << setfill('-') << setw(50) << "-" << endl;
+        cout << "Total Present: " << student.getTotalPresent() << endl;
+        cout << "Total Absent: " << student.getTotalAbsent() << endl;
+        cout << "Attendance Percentage: " << fixed << setprecision(2) 
+             << student.getAttendancePercentage() << "%" << endl;
+        
+        cout << "\nAttendance History:\n";
+        cout << setfill('-') << setw(50) << "-" << endl;
+        cout << student.getAttendanceDetails();
+    }
+
     void generateReport() {
+        loadAllSections();
         if (students.empty()) {
             cout << "No students registered yet!\n";
             return;
@@ -1686,23 +2757,26 @@ public:
     }
 
     void showDashboard() const {
+        METRIC_STAGE(STAGE_RENDER);
+        TRACE_SPAN("showDashboard");
         clearScreen();
         UIHelper::drawBox("Dashboard", 80);
         
+        size_t schoolSize = totalStudents();
         vector<vector<string>> stats = {
             {"Metric", "Value", "Status"},
-            {"Total Students", to_string(students.size()), ""},
+            {"Total Students", to_string(schoolSize), ""},
             {"Present Today", to_string(getTodayPresent()), ""},
             {"Overall Attendance", 
-                students.empty() ? "N/A" : to_string(getOverallAttendance()) + "%", ""},
+                schoolSize == 0 ? "N/A" : to_string(getOverallAttendance()) + "%", ""},
             {"Best Class", 
-                students.empty() ? "N/A" : getBestClass(), ""},
+                schoolSize == 0 ? "N/A" : getBestClass(), ""},
             {"Active Courses", to_string(getTotalCourses()), ""}
         };
         vector<int> colWidths = {20, 15, 15};
         UIHelper::drawTable(stats, colWidths);
 
-        if (!students.empty()) {
+        if (schoolSize > 0) {
             cout << "\nWeekly Attendance Trend:\n";
             vector<pair<string, float>> weeklyData = getWeeklyAttendance();
             if (!weeklyData.empty()) {
@@ -1730,8 +2804,12 @@ public:
         }
     }
 
+    void logout() {
+        isLoggedIn = false;
+    }
+
     void showMenu() const {
-        if (!loggedIn) {
+        if (!isLoggedIn) {
             cout << "\n=== Smart Attendance System ===\n\n";
             cout << "1. Login\n";
             cout << "2. Exit\n";
@@ -1747,11 +2825,16 @@ public:
             cout << "8. System Logs\n";
             cout << "9. Logout\n";
             cout << "10. Exit\n";
+            cout << "11. Backups\n";
+            cout << "12. Verify Data\n";
+            cout << "13. Archive a Closed Year\n";
+            cout << "14. Close Academic Year (rollover)\n";
+            cout << "15. Undo/Redo Marking\n";
         }
     }
 
     void generateReports() {
-        if (students.empty()) {
+        if (totalStudents() == 0) {
             showError("No students registered yet!");
             return;
         }
@@ -1765,12 +2848,29 @@ public:
         cout << "4. Progress Cards\n";
         cout << "5. Monthly Analysis\n";
         cout << "6. Detailed Statistics\n";
+        cout << "7. Attendance vs Performance (whole school)\n";
+        cout << "8. Memory Usage (whole school)\n";
+        cout << "9. Year-by-Year History\n";
+        cout << "10. Attendance As Of a Date\n";
         cout << "0. Back\n\n";
         
         int choice;
         cout << "Enter choice: ";
         cin >> choice;
 
+        if (choice == 7) {
+            generateCorrelationReport();
+            return;
+        }
+        if (choice == 8) {
+            generateMemoryReport();
+            return;
+        }
+        if (choice == 4) {
+            generateProgressCardBatch();
+            return;
+        }
+
         // Get class and section first
         auto [className, section] = getClassAndSection();
         if (className.empty() || section.empty()) {
@@ -1787,15 +2887,27 @@ public:
             case 3:
                 generateBehaviorReport(className, section);
                 break;
-            case 4:
-                generateProgressCards(className, section);
-                break;
             case 5:
                 generateMonthlyAnalysis(className, section);
                 break;
             case 6:
                 generateDetailedStatistics(className, section);
                 break;
+            case 9:
+                generateYearHistory(className, section);
+                break;
+            case 10: {
+                string text;
+                int64_t asOf;
+                cout << "As of (YYYY-MM-DD or YYYY-MM-DD HH:MM:SS): ";
+                getline(cin, text);
+                if (!parseAsOf(text, asOf)) {
+                    showError("Invalid date format! Use YYYY-MM-DD");
+                    return;
+                }
+                generateAsOfReport(className, section, asOf);
+                break;
+            }
             case 0:
                 return;
             default:
@@ -1803,7 +2915,34 @@ public:
         }
     }
 
+    // Report menu entries, built from the individual generators below
+    void generateAttendanceReport(const string& className, const string& section) {
+        generateHTMLReport(className, section);
+        generateCSVReport(className, section);
+    }
+
+    // The class-teacher report already covers every section of the class
+    void generatePerformanceReport(const string& className, const string& /*section*/) {
+        generateClassTeacherReport(className);
+    }
+
+    void generateBehaviorReport(const string& className, const string& section) {
+        generateClassSummary(className, section);
+    }
+
+    void generateMonthlyAnalysis(const string& className, const string& section) {
+        generateMonthlyReport(className, section);
+        generateTrendAnalysis(className, section);
+    }
+
+    void generateDetailedStatistics(const string& className, const string& section) {
+        generateDetailedReport(className, section);
+    }
+
     void generateHTMLReport(const string& className, const string& section) {
+        METRIC_STAGE(STAGE_RENDER);
+        TRACE_SPAN_DETAIL("generateHTMLReport", className + "-" + section);
+        METRIC_ADD(COUNTER_REPORTS_RENDERED, 1);
         clearScreen();
         UIHelper::drawBox("Attendance Report - Class " + className + "-" + section, 80);
 
@@ -1963,6 +3102,9 @@ public:
     }
 
     void generateDetailedReport(const string& className, const string& section) {
+        METRIC_STAGE(STAGE_RENDER);
+        TRACE_SPAN_DETAIL("generateDetailedReport", className + "-" + section);
+        METRIC_ADD(COUNTER_REPORTS_RENDERED, 1);
         clearScreen();
         UIHelper::drawBox("Detailed Report - Class " + className + "-" + section, 80);
 
@@ -2001,15 +3143,15 @@ public:
             }
 
             file << "\nPerformance Distribution:\n";
-            int excellent = 0, good = 0, average = 0, needsImprovement = 0;
+            int excellent = 0, good = 0, average = 0, needsImprovement = 0, ungraded = 0;
+            const ClassGradebook* classBook = gradebook.findClass(className);
+            vector<float> averages = classBook ? classBook->studentAverages() : vector<float>();
             for (const auto& student : classStudents) {
-                float avg = 0;
-                for (const auto& grade : student->getGrades()) {
-                    avg += grade.second;
-                }
-                avg /= student->getGrades().size();
+                long position = classBook ? classBook->findPosition(student->getUniqueId()) : -1;
+                float avg = position < 0 ? NAN : averages[position];
                 
-                if (avg >= 90) excellent++;
+                if (isnan(avg)) ungraded++;
+                else if (avg >= 90) excellent++;
                 else if (avg >= 75) good++;
                 else if (avg >= 60) average++;
                 else needsImprovement++;
@@ -2017,7 +3159,10 @@ public:
             file << "Excellent (>90%): " << excellent << " students\n";
             file << "Good (75-90%): " << good << " students\n";
             file << "Average (60-75%): " << average << " students\n";
-            file << "Needs Improvement (<60%): " << needsImprovement << " students\n\n";
+            file << "Needs Improvement (<60%): " << needsImprovement << " students\n";
+            file << "No Marks Recorded: " << ungraded << " students\n\n";
+
+            writeCorrelationSection(file, computeAttendancePerformance(className), "class/" + className);
 
             // Add more sections for behavior notes, extracurricular activities, etc.
             file << "\nClass Teacher's Remarks:\n";
@@ -2028,11 +3173,11 @@ public:
                     file << note.first << ": " << note.second << "\n";
                 }
                 file << "\nParent-Teacher Interactions:\n";
-                for (const auto& meeting : parentMeetings[student->getRollNo()]) {
+                for (const auto& meeting : parentMeetings[student->getUniqueId()]) {
                     file << meeting.date << " - " << meeting.teacherName << ": " << meeting.agenda << "\n";
                 }
                 file << "\nClass Teacher's Remarks:\n";
-                for (const auto& remark : teacherRemarks[student->getRollNo()]) {
+                for (const auto& remark : teacherRemarks[student->getUniqueId()]) {
                     file << remark << "\n";
                 }
                 file << "\n\n";
@@ -2046,6 +3191,9 @@ public:
     }
 
     void generateCSVReport(const string& className, const string& section) {
+        METRIC_STAGE(STAGE_RENDER);
+        TRACE_SPAN_DETAIL("generateCSVReport", className + "-" + section);
+        METRIC_ADD(COUNTER_REPORTS_RENDERED, 1);
         string filename = "attendance_report_" + className + "_" + section + ".csv";
         ofstream file(filename);
         
@@ -2073,6 +3221,9 @@ public:
     }
 
     void generateClassSummary(const string& className, const string& section) {
+        METRIC_STAGE(STAGE_RENDER);
+        TRACE_SPAN_DETAIL("generateClassSummary", className + "-" + section);
+        METRIC_ADD(COUNTER_REPORTS_RENDERED, 1);
         clearScreen();
         UIHelper::drawBox("Class Summary - " + className + "-" + section, 80);
 
@@ -2110,11 +3261,11 @@ public:
                     file << "<p>" << note.first << ": " << note.second << "</p>";
                 }
                 file << "<p>Parent-Teacher Interactions:</p>";
-                for (const auto& meeting : parentMeetings[student->getRollNo()]) {
+                for (const auto& meeting : parentMeetings[student->getUniqueId()]) {
                     file << "<p>" << meeting.date << " - " << meeting.teacherName << ": " << meeting.agenda << "</p>";
                 }
                 file << "<p>Class Teacher's Remarks:</p>";
-                for (const auto& remark : teacherRemarks[student->getRollNo()]) {
+                for (const auto& remark : teacherRemarks[student->getUniqueId()]) {
                     file << "<p>" << remark << "</p>";
                 }
                 file << "<hr>";
@@ -2128,6 +3279,9 @@ public:
     }
 
     void generateMonthlyReport(const string& className, const string& section) {
+        METRIC_STAGE(STAGE_RENDER);
+        TRACE_SPAN_DETAIL("generateMonthlyReport", className + "-" + section);
+        METRIC_ADD(COUNTER_REPORTS_RENDERED, 1);
         ofstream file("monthly_report_" + className + "_" + section + ".txt");
         map<string, map<string, int>> monthlyStats; // month -> {present, total}
         
@@ -2152,7 +3306,180 @@ public:
         showSuccess("Monthly report generated successfully!");
     }
 
+    // Attendance per academic year for each student of a section: closed
+    // years straight from their mapped segments, the rest from live marks.
+    // A live mark in an archived year (a later correction) replaces the
+    // archived one for that date.
+    void generateYearHistory(const string& className, const string& section) {
+        METRIC_STAGE(STAGE_RENDER);
+        TRACE_SPAN_DETAIL("generateYearHistory", className + "-" + section);
+        METRIC_ADD(COUNTER_REPORTS_RENDERED, 1);
+        map<int, const ArchiveSegment*> segments;
+        for (int year : archive.years()) {
+            string error;
+            segments[year] = archive.segment(year, error);
+            if (!segments[year]) showWarning("Archive for " + academicYearLabel(year) + " skipped: " + error);
+        }
+
+        ofstream file("year_history_" + className + "_" + section + ".txt");
+        file << "Year-by-Year Attendance: Class " << className << "-" << section << "\n";
+        file << "Generated on: " << getCurrentDate() << "\n";
+        for (const auto& student : students) {
+            if (student.getClassName() != className || student.getSection() != section) continue;
+            string uniqueId = student.getUniqueId();
+
+            map<int, pair<int, int>> years;  // start year -> (present, recorded)
+            map<int, const ArchiveStudent*> archived;
+            for (const auto& segment : segments) {
+                // Segments are keyed by the id the student had that year
+                const ArchiveStudent* entry =
+                    segment.second ? segment.second->find(idHistory.idInYear(uniqueId, segment.first)) : nullptr;
+                if (!entry) continue;
+                uint32_t present = 0, recorded = 0;
+                segment.second->count(*entry, INT_MIN, INT_MAX, present, recorded);
+                years[segment.first] = {(int)present, (int)recorded};
+                archived[segment.first] = entry;
+            }
+            for (const auto& record : student.getAttendanceRecord().raw()) {
+                string date = record.key.str();
+                int year = academicYearOf(date);
+                auto& totals = years[year];
+                auto entry = archived.find(year);
+                int before = entry == archived.end() ? -1
+                                                     : segments[year]->statusOn(*entry->second, dayNumberFromDate(date));
+                if (before < 0) totals.second++;
+                totals.first += (record.value ? 1 : 0) - max(before, 0);
+            }
+
+            file << "\n" << student.getName() << " (Roll No: " << student.getRollNo() << ")\n";
+            for (const auto& year : years) {
+                float percentage = year.second.second > 0 ? (float)year.second.first / year.second.second * 100 : 0;
+                file << "  " << academicYearLabel(year.first) << (segments.count(year.first) ? " (archived)" : "")
+                     << ": " << year.second.first << "/" << year.second.second << " days, " << fixed
+                     << setprecision(2) << percentage << "%\n";
+            }
+        }
+        file.close();
+        showSuccess("Year-by-year history generated successfully!");
+    }
+
+    // "YYYY-MM-DD" (the end of that day) or "YYYY-MM-DD HH:MM:SS", local time
+    bool parseAsOf(const string& text, int64_t& asOf) const {
+        if (!validateDate(text.substr(0, 10))) return false;
+        if (text.size() == 10) {
+            asOf = endOfDay(text);
+            return true;
+        }
+        tm moment = {};
+        istringstream in(text);
+        in >> get_time(&moment, "%Y-%m-%d %H:%M:%S");
+        if (in.fail()) return false;
+        moment.tm_isdst = -1;
+        asOf = (int64_t)mktime(&moment);
+        return true;
+    }
+
+    // A section's attendance as it stood at asOf, beside today's figures,
+    // with rollups for every section and the school, also then and now. The
+    // students are those in the section at that time, so a later rollover
+    // does not move them.
+    void generateAsOfReport(const string& className, const string& section, int64_t asOf) {
+        METRIC_STAGE(STAGE_RENDER);
+        TRACE_SPAN_DETAIL("generateAsOfReport", className + "-" + section);
+        METRIC_ADD(COUNTER_REPORTS_RENDERED, 1);
+        if (!ensureHistoryStarted()) return;
+        flushHistory();
+        AttendanceCountMap then;
+        uint64_t sequence;
+        string error;
+        if (!history.countsAsOf(asOf, then, sequence, error)) {
+            if (history.damaged().empty()) error += " (" + formatTimestamp(history.startTime()) + ")";
+            showError(error);
+            return;
+        }
+        const AttendanceCountMap& now = history.latest();
+        loadClassData(className, section);
+        unordered_map<string, string> names;
+        for (const auto& student : students) names[student.getUniqueId()] = student.getName();
+
+        string prefix = className + "_" + section + "_";
+        vector<const AttendanceCountMap::value_type*> rows;
+        AttendanceCounts sectionThen, schoolThen;
+        for (const auto& entry : then) {
+            schoolThen.present += entry.second.present;
+            schoolThen.recorded += entry.second.recorded;
+            if (!entry.first.starts_with(prefix)) continue;
+            rows.push_back(&entry);
+            sectionThen.present += entry.second.present;
+            sectionThen.recorded += entry.second.recorded;
+        }
+        sort(rows.begin(), rows.end(), [](auto* a, auto* b) {  // by roll number, numerically
+            return a->first.size() != b->first.size() ? a->first.size() < b->first.size() : a->first < b->first;
+        });
+
+        ofstream file("attendance_as_of_" + className + "_" + section + ".txt");
+        file << "Attendance As Of " << formatTimestamp(asOf) << ": Class " << className << "-" << section << "\n";
+        file << "Generated on: " << getCurrentDate() << " (history change " << sequence << ")\n\n";
+        file << left << setw(8) << "Roll" << setw(25) << "Name" << setw(10) << "Present" << setw(8) << "Days"
+             << setw(10) << "As of %" << "Now %\n";
+        file << fixed << setprecision(2);
+        for (const auto* row : rows) {
+            auto name = names.find(row->first);
+            auto current = now.find(row->first);
+            file << left << setw(8) << row->first.substr(prefix.size())
+                 << setw(25) << (name == names.end() ? "-" : name->second) << setw(10) << row->second.present
+                 << setw(8) << row->second.recorded << setw(10) << row->second.percentage();
+            if (current == now.end()) file << "-\n";
+            else file << current->second.percentage() << "\n";
+        }
+        file << "\nSection: " << sectionThen.present << "/" << sectionThen.recorded << " days, "
+             << sectionThen.percentage() << "%\n";
+        file << "School: " << schoolThen.present << "/" << schoolThen.recorded << " days, "
+             << schoolThen.percentage() << "%\n";
+
+        // Per-section rollups, keyed by the class and section in each uniqueId
+        map<pair<string, string>, pair<AttendanceCounts, AttendanceCounts>> sections;  // -> {then, now}
+        AttendanceCounts schoolNow;
+        auto addTo = [&](const AttendanceCountMap& counts, bool isNow) {
+            for (const auto& entry : counts) {
+                size_t first = entry.first.find('_');
+                size_t second = entry.first.find('_', first + 1);
+                if (second == string::npos) continue;
+                auto& totals = sections[{entry.first.substr(0, first), entry.first.substr(first + 1, second - first - 1)}];
+                AttendanceCounts& target = isNow ? totals.second : totals.first;
+                target.present += entry.second.present;
+                target.recorded += entry.second.recorded;
+                if (isNow) schoolNow.present += entry.second.present, schoolNow.recorded += entry.second.recorded;
+            }
+        };
+        addTo(then, false);
+        addTo(now, true);
+        vector<const decltype(sections)::value_type*> order;
+        for (const auto& entry : sections) order.push_back(&entry);
+        sort(order.begin(), order.end(), [](auto* a, auto* b) {  // by class number, then section
+            const string &x = a->first.first, &y = b->first.first;
+            return x.size() != y.size() ? x.size() < y.size() : a->first < b->first;
+        });
+        file << "\nSection Rollups\n";
+        file << left << setw(12) << "Section" << setw(14) << "Days then" << setw(10) << "As of %"
+             << setw(14) << "Days now" << "Now %\n";
+        for (const auto* entry : order) {
+            const AttendanceCounts& rollupThen = entry->second.first;
+            const AttendanceCounts& rollupNow = entry->second.second;
+            file << left << setw(12) << (entry->first.first + "-" + entry->first.second)
+                 << setw(14) << rollupThen.recorded << setw(10) << rollupThen.percentage()
+                 << setw(14) << rollupNow.recorded << rollupNow.percentage() << "\n";
+        }
+        file << "School now: " << schoolNow.present << "/" << schoolNow.recorded << " days, "
+             << schoolNow.percentage() << "%\n";
+        file.close();
+        showSuccess("As-of report generated successfully!");
+    }
+
     void generateTrendAnalysis(const string& className, const string& section) {
+        METRIC_STAGE(STAGE_RENDER);
+        TRACE_SPAN_DETAIL("generateTrendAnalysis", className + "-" + section);
+        METRIC_ADD(COUNTER_REPORTS_RENDERED, 1);
         ofstream file("trend_analysis_" + className + "_" + section + ".txt");
         vector<pair<string, float>> trends;
         
@@ -2203,7 +3530,7 @@ public:
     }
 
     void showStatistics() {
-        if (students.empty()) {
+        if (totalStudents() == 0) {
             showError("No students registered yet!");
             return;
         }
@@ -2272,7 +3599,7 @@ public:
                 bestStudent = student->getName();
             }
             
-            highestStreak = max(highestStreak, student->getAttendanceStreak());
+            highestStreak = max(highestStreak, (int)roster.longestRun(student - students.data()));
         }
 
         float averageAttendance = totalAttendance / classStudents.size();
@@ -2300,7 +3627,7 @@ public:
         cout << "Poor (<60%): " << poor << " students\n";
 
         cout << "\nPress any key to continue...";
-        _getch();
+        readKey();
     }
 
     void generateProgressReport(const string& rollNo) {
@@ -2380,23 +3707,44 @@ public:
     }
 
     void addBehaviorNote(const string& rollNo, const string& note) {
+        loadAllSections();  // roll numbers repeat across sections; search them all
         auto it = find_if(students.begin(), students.end(),
             [&rollNo](const Student& s) { return s.getRollNo() == rollNo; });
         
         if (it != students.end()) {
             it->addBehaviorNote(note);
+            indexText(it->getUniqueId(), TEXT_BEHAVIOR, it->getCurrentDate(), note, true);
+            partitions.markDirty(it->getClassName(), it->getSection());
             showSuccess("Behavior note added successfully!");
         } else {
             showError("Student not found!");
         }
     }
 
+    // Teacher remarks and meetings are keyed by uniqueId, since roll numbers
+    // repeat across the sections of a class
+    void addTeacherRemark(const string& className, const string& section, const string& rollNo,
+                          const string& remark) {
+        string uniqueId = className + "_" + section + "_" + rollNo;
+        teacherRemarks[uniqueId].push_back(remark);
+        indexText(uniqueId, TEXT_TEACHER, getCurrentDate(), remark, false);
+    }
+
+    void addParentMeeting(const string& className, const string& section, const string& rollNo,
+                          const ParentMeeting& meeting) {
+        string uniqueId = className + "_" + section + "_" + rollNo;
+        parentMeetings[uniqueId].push_back(meeting);
+        indexText(uniqueId, TEXT_MEETING, meeting.date, meeting.feedback, false);
+    }
+
     void updateBusRoute(const string& rollNo, const string& route) {
+        loadAllSections();
         auto it = find_if(students.begin(), students.end(),
             [&rollNo](const Student& s) { return s.getRollNo() == rollNo; });
         
         if (it != students.end()) {
             it->setBusRoute(route);
+            partitions.markDirty(it->getClassName(), it->getSection());
             showSuccess("Bus route updated successfully!");
         } else {
             showError("Student not found!");
@@ -2405,18 +3753,28 @@ public:
 
     void addExam(const string& className, const Exam& exam) {
         examRecords[className].push_back(exam);
+
+        ClassGradebook& classBook = gradebook.forClass(className);
+        size_t column = classBook.addExam(exam.subject, exam.examType, exam.date, (float)exam.maxMarks);
+        for (const auto& mark : exam.studentMarks) {
+            classBook.setMark(column, mark.first, mark.second);
+        }
         logAction("Added new exam for " + className + ": " + exam.subject);
     }
 
-    void recordExamMarks(const string& className, const string& subject, 
+    void recordExamMarks(const string& className, const string& section, const string& subject,
                         const string& rollNo, float marks) {
-        for (auto& exam : examRecords[className]) {
-            if (exam.subject == subject) {
-                exam.studentMarks[rollNo] = marks;
-                break;
-            }
+        // Gradebook columns are kept in the same order as examRecords[className]
+        ClassGradebook& classBook = gradebook.forClass(className);
+        long column = classBook.findExam(subject);
+        if (column < 0) {
+            showError("No " + subject + " exam found for class " + className);
+            return;
         }
-        logAction("Recorded marks for " + rollNo + " in " + subject);
+        string uniqueId = className + "_" + section + "_" + rollNo;
+        examRecords[className][column].studentMarks[uniqueId] = marks;
+        classBook.setMark(column, uniqueId, marks);
+        logAction("Recorded marks for " + uniqueId + " in " + subject);
     }
 
     void assignClassTeacher(const string& className, const ClassTeacher& teacher) {
@@ -2434,159 +3792,482 @@ public:
         logAction("Sent message to parent of " + rollNo);
     }
 
-    void generateProgressCard(const string& rollNo) {
+    // Shared by the single and batch progress card paths. Only reads shared
+    // state, so several render workers can call it at once.
+    void renderProgressCard(string& out, const Student& student, const ExamPivot& pivot) const {
+        auto formatNumber = [](float value) {
+            char buffer[32];
+            snprintf(buffer, sizeof(buffer), "%g", value);
+            return string(buffer);
+        };
+
+        out += "<html><head>\n"
+               "<style>\n"
+               "body { font-family: Arial; margin: 40px; }\n"
+               "table { border-collapse: collapse; width: 100%; margin: 20px 0; }\n"
+               "th, td { border: 1px solid #ddd; padding: 8px; text-align: left; }\n"
+               "th { background-color: #4CAF50; color: white; }\n"
+               ".header { text-align: center; margin-bottom: 30px; }\n"
+               ".school-name { font-size: 24px; font-weight: bold; }\n"
+               ".warning { color: red; }\n"
+               "</style>\n"
+               "<script src='https://cdn.jsdelivr.net/npm/chart.js'></script>\n"
+               "</head><body>\n"
+               "<div class='header'>\n"
+               "<div class='school-name'>School Name</div>\n"
+               "<div>Progress Report Card</div>\n"
+               "<div>Academic Year 2024-25</div>\n"
+               "</div>\n";
+
+        out += "<h2>Student Information</h2>\n<table>\n";
+        out += "<tr><th>Roll No</th><td>" + student.getRollNo() + "</td></tr>\n";
+        out += "<tr><th>Name</th><td>" + student.getName() + "</td></tr>\n";
+        out += "<tr><th>Class</th><td>" + student.getClassName() + "</td></tr>\n";
+        out += "<tr><th>Section</th><td>" + student.getSection() + "</td></tr>\n";
+        out += "</table>\n";
+
+        out += "<h2>Academic Performance</h2>\n<table>\n<tr><th>Subject</th>";
+        for (const auto& examType : pivot.getExamTypes()) {
+            out += "<th>" + examType + "</th>";
+        }
+        out += "</tr>\n";
+
+        size_t row = pivot.rowFor(student.getUniqueId());
+        for (size_t subject = 0; subject < pivot.getSubjects().size(); subject++) {
+            out += "<tr><td>" + pivot.getSubjects()[subject] + "</td>";
+            for (size_t type = 0; type < pivot.getExamTypes().size(); type++) {
+                float marks = pivot.mark(row, subject, type);
+                out += "<td>" + (isnan(marks) ? string("N/A") : formatNumber(marks)) + "</td>";
+            }
+            out += "</tr>\n";
+        }
+        out += "</table>\n";
+
+        char percentage[32];
+        snprintf(percentage, sizeof(percentage), "%.2f", student.getAttendancePercentage());
+        out += "<h2>Attendance Record</h2>\n<table>\n";
+        out += "<tr><th>Total Days</th><td>" +
+               to_string(student.getTotalPresent() + student.getTotalAbsent()) + "</td></tr>\n";
+        out += "<tr><th>Days Present</th><td>" + to_string(student.getTotalPresent()) + "</td></tr>\n";
+        out += "<tr><th>Days Absent</th><td>" + to_string(student.getTotalAbsent()) + "</td></tr>\n";
+        out += "<tr><th>Attendance Percentage</th><td>" + string(percentage) + "%</td></tr>\n";
+        out += "</table>\n";
+
+        out += "<h2>Class Teacher's Remarks</h2>\n"
+               "<div style='border: 1px solid #ddd; padding: 10px; min-height: 100px;'>\n";
+        auto remarks = teacherRemarks.find(student.getUniqueId());
+        if (remarks != teacherRemarks.end()) {
+            for (const auto& remark : remarks->second) {
+                out += "<p>" + remark + "</p>\n";
+            }
+        }
+        out += "</div>\n";
+
+        out += "<h2>Parent-Teacher Interactions</h2>\n<table>\n"
+               "<tr><th>Date</th><th>Teacher</th><th>Discussion Points</th><th>Outcome</th></tr>\n";
+        auto meetings = parentMeetings.find(student.getUniqueId());
+        if (meetings != parentMeetings.end()) {
+            for (const auto& meeting : meetings->second) {
+                out += "<tr><td>" + meeting.date + "</td>"
+                       "<td>" + meeting.teacherName + "</td>"
+                       "<td>" + meeting.agenda + "</td>"
+                       "<td>" + meeting.feedback + "</td></tr>\n";
+            }
+        }
+        out += "</table>\n";
+
+        out += "</body></html>";
+    }
+
+    ExamPivot buildExamPivot(const string& className) const {
+        ExamPivot pivot;
+        auto exams = examRecords.find(className);
+        if (exams != examRecords.end()) {
+            pivot.build(exams->second);
+        }
+        return pivot;
+    }
+
+    void generateProgressCard(const string& className, const string& section, const string& rollNo) {
+        loadClassData(className, section);
+        string uniqueId = className + "_" + section + "_" + rollNo;
         auto it = find_if(students.begin(), students.end(),
-            [&rollNo](const Student& s) { return s.getRollNo() == rollNo; });
+            [&uniqueId](const Student& s) { return s.getUniqueId() == uniqueId; });
         
         if (it == students.end()) {
             showError("Student not found!");
             return;
         }
 
-        ofstream file(rollNo + "_progress_card.html");
-        file << "<html><head>\n"
-             << "<style>\n"
-             << "body { font-family: Arial; margin: 40px; }\n"
-             << "table { border-collapse: collapse; width: 100%; margin: 20px 0; }\n"
-             << "th, td { border: 1px solid #ddd; padding: 8px; text-align: left; }\n"
-             << "th { background-color: #4CAF50; color: white; }\n"
-             << ".header { text-align: center; margin-bottom: 30px; }\n"
-             << ".school-name { font-size: 24px; font-weight: bold; }\n"
-             << ".warning { color: red; }\n"
-             << "</style>\n"
-             << "<script src='https://cdn.jsdelivr.net/npm/chart.js'></script>\n"
-             << "</head><body>\n"
-             << "<div class='header'>\n"
-             << "<div class='school-name'>School Name</div>\n"
-             << "<div>Progress Report Card</div>\n"
-             << "<div>Academic Year 2024-25</div>\n"
-             << "</div>\n";
+        string card;
+        renderProgressCard(card, *it, buildExamPivot(className));
 
-        file << "<h2>Student Information</h2>\n"
-             << "<table>\n"
-             << "<tr><th>Roll No</th><td>" << it->getRollNo() << "</td></tr>\n"
-             << "<tr><th>Name</th><td>" << it->getName() << "</td></tr>\n"
-             << "<tr><th>Class</th><td>" << it->getClassName() << "</td></tr>\n"
-             << "<tr><th>Section</th><td>" << it->getSection() << "</td></tr>\n"
-             << "</table>\n";
+        ofstream file(uniqueId + "_progress_card.html");
+        file << card;
+        file.close();
 
-        file << "<h2>Academic Performance</h2>\n"
-             << "<table>\n"
-             << "<tr><th>Subject</th><th>Unit Test</th><th>Mid Term</th><th>Final</th></tr>\n";
-        
-        for (const auto& exam : examRecords[it->getClassName()]) {
-            file << "<tr><td>" << exam.subject << "</td><td>";
-            
-            // Unit Test marks
-            if (exam.studentMarks.find(it->getRollNo()) != exam.studentMarks.end()) {
-                file << exam.studentMarks.at(it->getRollNo());
-            } else {
-                file << "N/A";
+        showSuccess("Progress card generated successfully!");
+    }
+
+    // Menu entry for progress cards: one section, every section of a class,
+    // or the whole school, optionally bundled into one archive
+    void generateProgressCardBatch() {
+        clearScreen();
+        printTitle("Progress Cards");
+        cout << "1. One section\n";
+        cout << "2. Whole class\n";
+        cout << "3. Whole school\n";
+        int scope;
+        cout << "Enter choice: ";
+        cin >> scope;
+
+        string className, section;
+        if (scope == 1) {
+            tie(className, section) = getClassAndSection();
+            if (className.empty() || section.empty()) return;
+        } else if (scope == 2) {
+            cout << "Enter Class (1-12): ";
+            cin.ignore();
+            getline(cin, className);
+            int classNum = atoi(className.c_str());
+            if (classNum < 1 || classNum > 12 || to_string(classNum) != className) {
+                showError("Invalid class! Must be between 1 and 12");
+                return;
             }
-            
-            file << "</td><td>";
-            
-            // Mid Term marks
-            if (exam.examType == "Mid Term" && 
-                exam.studentMarks.find(it->getRollNo()) != exam.studentMarks.end()) {
-                file << exam.studentMarks.at(it->getRollNo());
-            } else {
-                file << "N/A";
+            loadClassSections(className);
+        } else if (scope == 3) {
+            loadAllSections();
+        } else {
+            showError("Invalid choice!");
+            return;
+        }
+
+        cout << "Bundle cards into one archive? (y/n): ";
+        char bundle = tolower(readKey());
+        cout << bundle << endl;
+        generateProgressCards(className, section, bundle == 'y');
+    }
+
+    // Batch mode: every card of a section (empty section = whole class, empty
+    // class = whole school). Files are named by uniqueId so roll numbers that
+    // repeat across sections never overwrite each other.
+    void generateProgressCards(const string& className, const string& section, bool bundle = false) {
+        METRIC_STAGE(STAGE_RENDER);
+        TRACE_SPAN_DETAIL("generateProgressCards", className + "-" + section);
+        vector<const Student*> cardStudents;
+        for (const auto& student : students) {
+            if ((className.empty() || student.getClassName() == className) &&
+                (section.empty() || student.getSection() == section)) {
+                cardStudents.push_back(&student);
             }
-            
-            file << "</td><td>";
-            
-            // Final marks
-            if (exam.examType == "Final" && 
-                exam.studentMarks.find(it->getRollNo()) != exam.studentMarks.end()) {
-                file << exam.studentMarks.at(it->getRollNo());
-            } else {
-                file << "N/A";
+        }
+
+        if (cardStudents.empty()) {
+            showError("No students found for progress cards!");
+            return;
+        }
+
+        // Pivot each class's exams once, before any worker starts
+        map<string, ExamPivot> pivots;
+        for (const auto* student : cardStudents) {
+            if (pivots.find(student->getClassName()) == pivots.end()) {
+                pivots.emplace(student->getClassName(), buildExamPivot(student->getClassName()));
             }
-            
-            file << "</td></tr>\n";
         }
-        file << "</table>\n";
 
-        file << "<h2>Attendance Record</h2>\n"
-             << "<table>\n"
-             << "<tr><th>Total Days</th><td>" 
-             << it->getTotalPresent() + it->getTotalAbsent() << "</td></tr>\n"
-             << "<tr><th>Days Present</th><td>" << it->getTotalPresent() << "</td></tr>\n"
-             << "<tr><th>Days Absent</th><td>" << it->getTotalAbsent() << "</td></tr>\n"
-             << "<tr><th>Attendance Percentage</th><td>" 
-             << fixed << setprecision(2) << it->getAttendancePercentage() << "%</td></tr>\n"
-             << "</table>\n";
+        const string outputDir = "progress_cards";
+        filesystem::create_directories(outputDir);
 
-        file << "<h2>Class Teacher's Remarks</h2>\n"
-             << "<div style='border: 1px solid #ddd; padding: 10px; min-height: 100px;'>\n";
-        for (const auto& remark : teacherRemarks[rollNo]) {
-            file << "<p>" << remark << "</p>\n";
+        string scope = className.empty() ? "school" : className + (section.empty() ? "" : "_" + section);
+        string archivePath = outputDir + "/progress_cards_" + scope + "_" + getCurrentDate() + ".tar";
+        unique_ptr<TarWriter> archive;
+        if (bundle) {
+            archive = make_unique<TarWriter>(archivePath);
+            if (!archive->isOpen()) {
+                showError("Could not create archive: " + archivePath);
+                return;
+            }
         }
-        file << "</div>\n";
 
-        file << "<h2>Parent-Teacher Interactions</h2>\n"
-             << "<table>\n"
-             << "<tr><th>Date</th><th>Teacher</th><th>Discussion Points</th><th>Outcome</th></tr>\n";
-        for (const auto& meeting : parentMeetings[rollNo]) {
-            file << "<tr><td>" << meeting.date << "</td>"
-                 << "<td>" << meeting.teacherName << "</td>"
-                 << "<td>" << meeting.agenda << "</td>"
-                 << "<td>" << meeting.feedback << "</td></tr>\n";
+        size_t bundleFailures = 0;
+        size_t written = renderDocumentsInParallel(cardStudents.size(),
+            [&](size_t i, string& buffer) {
+                const Student* student = cardStudents[i];
+                renderProgressCard(buffer, *student, pivots.at(student->getClassName()));
+                string name = student->getUniqueId() + "_progress_card.html";
+                return bundle ? name : outputDir + "/" + name;
+            },
+            archive.get(), &bundleFailures);
+
+        if (archive && (!archive->close() || bundleFailures > 0)) {
+            showError("Failed to write " + to_string(bundleFailures) + " progress cards to archive: " + archivePath);
+            logAction("Progress card archive " + archivePath + " is incomplete");
+            return;
         }
-        file << "</table>\n";
 
-        file << "</body></html>";
+        logAction("Generated " + to_string(written) + " progress cards for " + scope);
+        showSuccess(to_string(written) + " progress cards generated" +
+                    (bundle ? " in " + archivePath : " in " + outputDir + "/"));
+    }
+
+    // Subject::passingMarks for the class, or -1 to fall back to DEFAULT_PASS_FRACTION
+    float getPassingMarks(const string& className, const string& subject) const {
+        auto subjects = classSubjects.find(className);
+        if (subjects != classSubjects.end()) {
+            for (const auto& entry : subjects->second) {
+                if (entry.name == subject) return (float)entry.passingMarks;
+            }
+        }
+        return -1;
+    }
+
+    // Joins each student's attendance rate with their gradebook averages. Every
+    // class-section is scanned as its own partition; keys are "school",
+    // "subject/<name>", "class/<N>" and "class/<N>/<subject>".
+    CorrelationResults computeAttendancePerformance(const string& classFilter = "") const {
+        METRIC_STAGE(STAGE_AGGREGATE);
+        TRACE_SPAN("computeAttendancePerformance");
+        map<pair<string, string>, vector<const Student*>> partitions;
+        for (const auto& student : students) {
+            if (classFilter.empty() || student.getClassName() == classFilter) {
+                partitions[{student.getClassName(), student.getSection()}].push_back(&student);
+            }
+        }
+
+        // Gradebook averages are computed once per class before the workers start
+        struct ClassScores {
+            const ClassGradebook* book = nullptr;
+            vector<float> overall;
+            map<string, vector<float>> bySubject;
+        };
+        map<string, ClassScores> scores;
+        for (const auto& partition : partitions) {
+            const string& className = partition.first.first;
+            if (scores.count(className)) continue;
+            ClassScores& entry = scores[className];
+            entry.book = gradebook.findClass(className);
+            if (!entry.book) continue;
+            entry.overall = entry.book->studentAverages();
+            for (const auto& exam : entry.book->getExams()) {
+                if (!entry.bySubject.count(exam.subject)) {
+                    entry.bySubject[exam.subject] = entry.book->studentAverages(exam.subject);
+                }
+            }
+        }
+
+        vector<const vector<const Student*>*> work;
+        for (const auto& partition : partitions) work.push_back(&partition.second);
+
+        return runCorrelationJob(work.size(), [&](size_t i, const CorrelationEmit& emit) {
+            for (const Student* student : *work[i]) {
+                if (student->getAttendanceRecord().empty()) continue;
+                const ClassScores& classScores = scores.at(student->getClassName());
+                if (!classScores.book) continue;
+                long position = classScores.book->findPosition(student->getUniqueId());
+                if (position < 0 || isnan(classScores.overall[position])) continue;
+
+                double attendance = student->getAttendancePercentage();
+                string classKey = "class/" + student->getClassName();
+                emit("school", attendance, classScores.overall[position]);
+                emit(classKey, attendance, classScores.overall[position]);
+                for (const auto& subject : classScores.bySubject) {
+                    float score = subject.second[position];
+                    if (isnan(score)) continue;
+                    emit(classKey + "/" + subject.first, attendance, score);
+                    emit("subject/" + subject.first, attendance, score);
+                }
+            }
+        });
+    }
+
+    void generateCorrelationReport() {
+        METRIC_STAGE(STAGE_RENDER);
+        TRACE_SPAN("generateCorrelationReport");
+        loadAllSections();
+        METRIC_ADD(COUNTER_REPORTS_RENDERED, 1);
+        auto started = chrono::steady_clock::now();
+        CorrelationResults results = computeAttendancePerformance();
+        auto elapsed = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - started);
+
+        ofstream report("attendance_performance_report.txt");
+        ofstream json("attendance_performance.json");
+        if (!report.is_open() || !json.is_open()) {
+            showError("Failed to create attendance vs performance report!");
+            return;
+        }
+
+        report << "=== Attendance vs Performance Report ===\n";
+        report << "Generated on: " << getCurrentDate() << "\n";
+        writeCorrelationSection(report, results);
+        writeCorrelationJson(json, results);
+
+        logAction("Generated attendance vs performance report");
+        showSuccess("Attendance vs performance analysis written in " +
+                    to_string(elapsed.count()) + " us: attendance_performance_report.txt, attendance_performance.json");
+    }
+
+    MemorySnapshot takeMemorySnapshot(const string& label) const {
+        MemorySnapshot snapshot(label);
+
+        MemoryUsage objects;
+        objects.addAllocation(students.capacity() * sizeof(Student));
+        objects.elements = students.size();
+        snapshot.charge("students", objects);
+
+        unordered_set<string> seen;
+        for (const auto& student : students) {
+            student.accountMemory(snapshot);
+            if (!seen.insert(student.getUniqueId()).second) snapshot.duplicateStudents++;
+        }
+        snapshot.students = students.size();
+
+        auto charge = [&](const string& category, const auto& container) {
+            MemoryUsage usage;
+            accountHeap(usage, container);
+            snapshot.charge(category, usage);
+        };
+        charge("notificationList", notificationList);
+        charge("pendingParentNotifications", pendingParentNotifications);
+        charge("chatMessages", chatMessages);
+        charge("systemLogs", systemLogs);
+        charge("examRecords", examRecords);
+        charge("parentMessages", parentMessages);
+        charge("parentMeetings", parentMeetings);
+        charge("teacherRemarks", teacherRemarks);
+
+        // Arena chunks are the real heap blocks; unused and abandoned space is their slack
+        MemoryUsage arenas;
+        for (const auto& entry : sectionArenas) {
+            const SectionArena& arena = *entry.second;
+            for (const auto& chunk : arena.getChunks()) {
+                arenas.overhead += allocatorOverhead(chunk.second);
+                arenas.allocations++;
+            }
+            arenas.bytes += arena.reservedBytes() - arena.usedBytes() + arena.abandonedBytes();
+            arenas.elements++;
+        }
+        snapshot.charge("sectionArenas", arenas);
+
+        MemoryUsage pool;
+        pool.addInline(stringPool().memoryBytes());
+        pool.elements = stringPool().size();
+        snapshot.charge("stringPool", pool);
+
+        MemoryUsage hot;
+        hot.addAllocation(roster.memoryBytes());
+        hot.elements = roster.size();
+        snapshot.charge("roster", hot);
+
+        MemoryUsage search;
+        search.addInline(searchIndex.memoryBytes());
+        search.elements = searchIndex.size();
+        snapshot.charge("searchIndex", search);
+
+        MemoryUsage text;
+        text.addInline(textIndex.memoryBytes());
+        text.elements = textIndex.size();
+        snapshot.charge("textIndex", text);
+        return snapshot;
+    }
+
+    // Writes the current snapshot and, after the first call, its diff against the previous one
+    void generateMemoryReport() {
+        METRIC_STAGE(STAGE_AGGREGATE);
+        TRACE_SPAN("generateMemoryReport");
+        loadAllSections();
+        MemorySnapshot snapshot = takeMemorySnapshot("snapshot " + to_string(++memorySnapshotCount) +
+                                                     " (" + getCurrentDate() + ")");
+
+        string filename = "memory_report.txt";
+        ofstream file(filename);
+        if (!file.is_open()) {
+            showError("Could not create memory report!");
+            return;
+        }
+        writeMemorySnapshot(file, snapshot);
+        if (previousMemorySnapshot) {
+            file << "\n";
+            writeMemoryDiff(file, *previousMemorySnapshot, snapshot);
+        }
         file.close();
 
-        showSuccess("Progress card generated successfully!");
+        MemoryUsage total = snapshot.total();
+        cout << "Estimated model size: " << formatBytes(total.total()) << " for " << snapshot.students
+             << " students (" << snapshot.duplicateStudents << " duplicates)\n";
+        if (snapshot.duplicateStudents > 0) {
+            showWarning("Some students are loaded more than once; see " + filename);
+        }
+
+        previousMemorySnapshot = make_unique<MemorySnapshot>(move(snapshot));
+        logAction("Generated memory report");
+        showSuccess("Memory report generated: " + filename);
     }
 
     void generateClassTeacherReport(const string& className) {
+        METRIC_STAGE(STAGE_RENDER);
+        TRACE_SPAN_DETAIL("generateClassTeacherReport", className);
+        METRIC_ADD(COUNTER_REPORTS_RENDERED, 1);
         clearScreen();
         UIHelper::drawBox("Class Performance Analysis - " + className, 80);
 
         int totalStudents = 0;
         float avgAttendance = 0;
-        map<string, float> subjectAverages;
         
         for (const auto& student : students) {
             if (student.getClassName() == className) {
                 totalStudents++;
                 avgAttendance += student.getAttendancePercentage();
-                
-                for (const auto& grade : student.getGrades()) {
-                    subjectAverages[grade.first] += grade.second;
-                }
             }
         }
 
         cout << "\nClass Overview:\n";
         cout << "Total Students: " << totalStudents << endl;
-        cout << "Average Attendance: " << avgAttendance/totalStudents << "%\n\n";
+        cout << "Average Attendance: " << (totalStudents ? avgAttendance / totalStudents : 0) << "%\n\n";
+
+        const ClassGradebook* classBook = gradebook.findClass(className);
+        if (!classBook || classBook->getExams().empty()) {
+            cout << "No exam marks recorded for class " << className << ".\n";
+            return;
+        }
+
+        cout << "Exam Statistics:\n";
+        cout << left << setw(14) << "Subject" << setw(11) << "Exam"
+             << right << setw(7) << "Count" << setw(8) << "Mean" << setw(8) << "StdDev"
+             << setw(7) << "Min" << setw(7) << "Max" << setw(8) << "P90" << setw(8) << "Pass%" << "\n";
+        const auto& exams = classBook->getExams();
+        for (size_t i = 0; i < exams.size(); i++) {
+            GradeStats stats = classBook->stats(i, getPassingMarks(className, exams[i].subject));
+            cout << left << setw(14) << exams[i].subject.substr(0, 13)
+                 << setw(11) << exams[i].examType.substr(0, 10) << right << fixed << setprecision(1)
+                 << setw(7) << stats.count << setw(8) << stats.mean << setw(8) << stats.stddev
+                 << setw(7) << stats.min << setw(7) << stats.max
+                 << setw(8) << classBook->percentile(i, 90) << setw(8) << stats.passRate << "\n";
+        }
 
-        cout << "Subject-wise Performance:\n";
-        for (auto& subject : subjectAverages) {
-            subject.second /= totalStudents;
-            cout << subject.first << ": " << subject.second << "%\n";
+        cout << "\nSubject-wise Performance:\n";
+        map<string, bool> seenSubjects;
+        for (const auto& exam : exams) {
+            if (seenSubjects[exam.subject]) continue;
+            seenSubjects[exam.subject] = true;
+
+            vector<float> averages = classBook->studentAverages(exam.subject);
+            float sum = 0;
+            int graded = 0;
+            for (float avg : averages) {
+                if (!isnan(avg)) { sum += avg; graded++; }
+            }
+            cout << exam.subject << ": " << (graded ? sum / graded : 0) << "%\n";
         }
 
         cout << "\nPerformance Distribution:\n";
         int excellent = 0, good = 0, average = 0, needsImprovement = 0;
         
-        for (const auto& student : students) {
-            if (student.getClassName() == className) {
-                float avg = 0;
-                for (const auto& grade : student.getGrades()) {
-                    avg += grade.second;
-                }
-                avg /= student.getGrades().size();
-                
-                if (avg >= 90) excellent++;
-                else if (avg >= 75) good++;
-                else if (avg >= 60) average++;
-                else needsImprovement++;
-            }
+        for (float avg : classBook->studentAverages()) {
+            if (isnan(avg)) continue;
+            if (avg >= 90) excellent++;
+            else if (avg >= 75) good++;
+            else if (avg >= 60) average++;
+            else needsImprovement++;
         }
 
         cout << "Excellent (>90%): " << excellent << " students\n";
@@ -2742,6 +4423,747 @@ public:
         showSuccess("Data exported to: " + exportPath);
     }
 
+    // Writes every class-section as a row group of a columnar file for BI tools
+    void exportColumnarData() {
+        TRACE_SPAN("exportColumnarData");
+        loadAllSections();
+        map<pair<string, string>, vector<const Student*>> partitions;
+        for (const auto& student : students) {
+            partitions[{student.getClassName(), student.getSection()}].push_back(&student);
+        }
+        if (partitions.empty()) {
+            showError("No students registered yet!");
+            return;
+        }
+
+        vector<ColumnarPartitionSource> sources;
+        for (const auto& partition : partitions) {
+            const vector<const Student*>* members = &partition.second;
+            sources.push_back({
+                partition.first.first + "_" + partition.first.second,
+                [members](ColumnarRowGroupBuilder& builder) {
+                    for (const Student* student : *members) {
+                        builder.beginStudent(student->getUniqueId());
+                        for (const auto& record : student->getAttendanceRecord()) {
+                            int day = dayNumberFromDate(record.first);
+                            if (day == INVALID_DAY) continue;
+                            builder.addRow(day, record.second, student->getRemarkForDate(record.first));
+                        }
+                    }
+                }
+            });
+        }
+
+        filesystem::create_directories("exports");
+        string exportPath = "exports/attendance_" + getCurrentDate() + ".sacf";
+        string error;
+        size_t bytes = ColumnarWriter::write(exportPath, sources, error);
+        if (bytes == 0) {
+            showError(error);
+            return;
+        }
+
+        logAction("Exported columnar attendance data to " + exportPath);
+        showSuccess("Columnar export written: " + exportPath + " (" + to_string(bytes) + " bytes, " +
+                    to_string(sources.size()) + " partitions)");
+    }
+
+    // Last second of a date in local time, for point-in-time backup queries
+    static int64_t endOfDay(const string& date) {
+        tm day = {};
+        day.tm_year = stoi(date.substr(0, 4)) - 1900;
+        day.tm_mon = stoi(date.substr(5, 2)) - 1;
+        day.tm_mday = stoi(date.substr(8, 2)) + 1;
+        day.tm_isdst = -1;
+        return (int64_t)mktime(&day) - 1;
+    }
+
+    static string formatTimestamp(int64_t seconds) {
+        time_t raw = (time_t)seconds;
+        tm* local = localtime(&raw);
+        stringstream ss;
+        ss << put_time(local, "%Y-%m-%d %H:%M:%S");
+        return ss.str();
+    }
+
+    void manageBackups() {
+        clearScreen();
+        printTitle("Backups");
+
+        cout << "1. List Backups (as of a date)\n";
+        cout << "2. Version History of a Class and Section\n";
+        cout << "3. Restore a Class and Section\n";
+        cout << "0. Back\n\n";
+
+        int choice;
+        cout << "Enter choice: ";
+        cin >> choice;
+
+        if (choice == 1) {
+            string date;
+            cout << "As of date (YYYY-MM-DD, blank for now): ";
+            cin.ignore();
+            getline(cin, date);
+            if (!date.empty() && !validateDate(date)) {
+                showError("Invalid date format! Use YYYY-MM-DD");
+                return;
+            }
+            vector<BackupSnapshot> snapshots = backups.list(date.empty() ? INT64_MAX : endOfDay(date));
+            if (snapshots.empty()) {
+                showError("No backups found");
+                return;
+            }
+            cout << "\n" << left << setw(50) << "File" << setw(22) << "Version" << "Bytes" << endl;
+            cout << setfill('-') << setw(80) << "-" << setfill(' ') << endl;
+            for (const auto& snapshot : snapshots) {
+                cout << left << setw(50) << snapshot.path << setw(22) << formatTimestamp(snapshot.time)
+                     << snapshot.size << endl;
+            }
+            cout << right << "\n" << backups.chunkCount() << " chunks, " << backups.diskBytes()
+                 << " bytes on disk\n";
+            return;
+        }
+        if (choice != 2 && choice != 3) {
+            if (choice != 0) showError("Invalid choice!");
+            return;
+        }
+
+        auto [className, section] = getClassAndSection();
+        if (className.empty() || section.empty()) {
+            return;
+        }
+        string path = getClassFilePath(className, section);
+        persistence.waitFor(PartitionTracker::keyFor(className, section));
+
+        if (choice == 2) {
+            vector<BackupSnapshot> versions = backups.history(path);
+            if (versions.empty()) {
+                showError("No backups of class " + className + "-" + section);
+                return;
+            }
+            cout << "\n" << left << setw(22) << "Version" << "Bytes" << endl;
+            cout << setfill('-') << setw(40) << "-" << setfill(' ') << endl;
+            for (const auto& version : versions) {
+                cout << left << setw(22) << formatTimestamp(version.time) << version.size << endl;
+            }
+            cout << right;
+            return;
+        }
+
+        string date;
+        cout << "Restore as of date (YYYY-MM-DD): ";
+        getline(cin, date);
+        if (!validateDate(date)) {
+            showError("Invalid date format! Use YYYY-MM-DD");
+            return;
+        }
+        restoreSection(className, section, endOfDay(date));
+    }
+
+    // Every mark of a loaded section, keyed by (uniqueId, date)
+    map<pair<string, string>, bool> sectionMarks(const string& className, const string& section) const {
+        map<pair<string, string>, bool> marks;
+        for (const auto& student : students) {
+            if (student.getClassName() != className || student.getSection() != section) continue;
+            for (const auto& record : student.getAttendanceRecord().raw()) {
+                marks[{student.getUniqueId(), record.key.str()}] = record.value;
+            }
+        }
+        return marks;
+    }
+
+    // Replaces a class-section with its newest backup at or before asOf. The
+    // restored file is saved as a new version, so the restore can be undone
+    // from the backups too. Unsaved changes to the section are dropped. The
+    // marks it changes are logged to the attendance history.
+    bool restoreSection(const string& className, const string& section, int64_t asOf) {
+        string path = getClassFilePath(className, section);
+        string key = PartitionTracker::keyFor(className, section);
+        persistence.waitFor(key);
+
+        string content, error;
+        if (!backups.restore(path, asOf, content, error)) {
+            showError(error);
+            return false;
+        }
+
+        bool versioned = ensureHistoryStarted();
+        loadClassData(className, section);
+        map<pair<string, string>, bool> before = sectionMarks(className, section);
+        evictSection(className, section);
+        uint32_t checksum = crc32c(content);
+        vector<PersistFile> files;
+        files.push_back({path, move(content), true});
+        persistence.enqueue(key, move(files));
+        persistence.waitFor(key);
+        reportPersistenceErrors();
+        // Record our own write first so the reload doesn't take it for an
+        // outside change, then summarize the restored students
+        catalog.update(summarizeSection(className, section, checksum), true);
+        joinHistoryOnLoad = false;  // the restored marks are logged one by one below
+        loadClassData(className, section);
+        joinHistoryOnLoad = true;
+        catalog.update(summarizeSection(className, section, checksum), false);
+        queueCatalogSave();
+        generateAttendanceStats(className, section);
+
+        if (versioned) {
+            int64_t now = time(nullptr);
+            map<pair<string, string>, bool> after = sectionMarks(className, section);
+            for (const auto& mark : before) {
+                auto restored = after.find(mark.first);
+                history.recordMark(mark.first.first, mark.first.second, mark.second,
+                                   restored == after.end() ? -1 : restored->second, now);
+            }
+            for (const auto& mark : after) {
+                if (!before.count(mark.first)) history.recordMark(mark.first.first, mark.first.second, -1, mark.second, now);
+            }
+            flushHistory();
+        }
+
+        logAction("Restored class " + key + " from backup");
+        showSuccess("Class " + key + " restored");
+        return true;
+    }
+
+    struct VerifyReport {
+        size_t files = 0;
+        size_t segments = 0;
+        size_t chunks = 0;
+        uint64_t bytes = 0;
+        double seconds = 0;
+        vector<string> problems;
+    };
+
+    // Checks every class file against the CRC-32C in its catalog entry, every
+    // archive segment against its header and every backup chunk against its
+    // index, spread over all cores, then every attendance history record.
+    // Class files the catalog does not list are reported too.
+    VerifyReport verifyDataDirectory(unsigned threadCount = thread::hardware_concurrency()) {
+        METRIC_STAGE(STAGE_VALIDATE);
+        TRACE_SPAN("verifyDataDirectory");
+        queueCatalogSave();
+        persistence.flush();  // queued saves and the catalog reach the disk first
+        auto started = chrono::steady_clock::now();
+        VerifyReport report;
+
+        vector<const CatalogEntry*> entries;
+        set<string> catalogued;
+        for (const auto& item : catalog.all()) {
+            entries.push_back(&item.second);
+            catalogued.insert(item.second.path);
+        }
+        for (const auto& folder : SCHOOL_SECTIONS) {
+            string sectionPath = BASE_DIR + "/" + folder.first;
+            for (const string& filename : listClassFiles(sectionPath)) {
+                string className, section, path = sectionPath + "/" + filename;
+                if (parseClassFileName(filename, className, section) && !section.empty() && !catalogued.count(path)) {
+                    report.problems.push_back(path + ": not in the catalog");
+                }
+            }
+        }
+
+        vector<int> years = archive.years();
+        size_t count = entries.size() + years.size();
+        vector<string> mismatches(count);
+        vector<uint64_t> sizes(count, 0);
+        atomic<size_t> next{0};
+        auto worker = [&]() {
+            string buffer;
+            for (size_t i = next++; i < count; i = next++) {
+                if (i >= entries.size()) {
+                    // Archive segments carry their own CRC-32C; a fresh mapping per check
+                    string path = archive.pathFor(years[i - entries.size()]), error;
+                    ArchiveSegment segment;
+                    if (!segment.open(path, error)) mismatches[i] = error;
+                    else if (!segment.verify()) mismatches[i] = path + ": CRC-32C does not match its header";
+                    else sizes[i] = segment.bytes();
+                    continue;
+                }
+                uint32_t crc = 0;
+                if (!crc32cOfFile(entries[i]->path, buffer, crc, sizes[i])) {
+                    mismatches[i] = entries[i]->path + ": missing or unreadable";
+                } else if (crc != entries[i]->checksum) {
+                    mismatches[i] = entries[i]->path + ": CRC-32C " + crc32cHex(crc) + ", catalog has " +
+                                    crc32cHex(entries[i]->checksum);
+                }
+            }
+        };
+        threadCount = max(1u, min(threadCount, (unsigned)max<size_t>(count, 1)));
+        vector<thread> workers;
+        for (unsigned t = 1; t < threadCount; t++) workers.emplace_back(worker);
+        worker();
+        for (auto& t : workers) t.join();
+
+        for (size_t i = 0; i < count; i++) {
+            if (!mismatches[i].empty()) report.problems.push_back(mismatches[i]);
+            report.bytes += sizes[i];
+        }
+        report.files = entries.size();
+        report.segments = years.size();
+
+        uint64_t chunkBytes = 0;
+        for (uint32_t chunk : backups.verifyChunks(chunkBytes)) {
+            report.problems.push_back("backup chunk " + to_string(chunk) + ": contents do not match the index");
+        }
+        report.chunks = backups.chunkCount();
+        report.bytes += chunkBytes;
+        flushHistory();
+        history.verify(report.problems, report.bytes);
+        report.seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+        return report;
+    }
+
+    // Prints a verify run; returns the number of problems found
+    size_t verifyData() {
+        VerifyReport report = verifyDataDirectory();
+        double mib = report.bytes / 1048576.0;
+        cout << "Checked " << report.files << " class files, " << report.segments << " archive segments and "
+             << report.chunks << " backup chunks: "
+             << fixed << setprecision(1) << mib << " MiB in " << setprecision(3) << report.seconds << " s ("
+             << setprecision(0) << (report.seconds > 0 ? mib / report.seconds : 0) << " MiB/s, CRC-32C "
+             << (crc32cAccelerated() ? "SSE4.2" : "software") << ")\n";
+        for (const string& problem : report.problems) {
+            showError(problem);
+        }
+        if (report.problems.empty()) showSuccess("No corruption found");
+        else showWarning(to_string(report.problems.size()) + " problem(s) found in " + BASE_DIR);
+        logAction("Verified data: " + to_string(report.problems.size()) + " problem(s)");
+        return report.problems.size();
+    }
+
+    // Moves a closed academic year's marks and remarks out of the class
+    // files into its archive segment. Marks archived for that year earlier
+    // are kept, with a live mark for the same date taking precedence. The
+    // students keep the rest of their marks in memory and their sections
+    // are marked dirty; moved is 0 when no live mark fell in the year.
+    bool archiveYearMarks(int year, size_t& moved) {
+        string label = academicYearLabel(year);
+        int firstDay = academicYearFirstDay(year), lastDay = academicYearLastDay(year);
+        moved = 0;
+        if (dayNumberFromDate(getCurrentDate()) <= lastDay) {
+            showError("The " + label + " academic year has not ended yet");
+            return false;
+        }
+        loadAllSections();
+        if (!ensureHistoryStarted()) return false;
+        string first = dateFromDayNumber(firstDay), last = dateFromDayNumber(lastDay);
+
+        map<string, map<int, ArchiveMark>> marks;  // uniqueId -> day -> mark
+        string error;
+        if (filesystem::exists(archive.pathFor(year))) {
+            const ArchiveSegment* existing = archive.segment(year, error);
+            if (!existing) {
+                showError(error);
+                return false;
+            }
+            for (size_t i = 0; i < existing->studentCount(); i++) {
+                const ArchiveStudent& entry = existing->student(i);
+                auto& studentMarks = marks[string(existing->idOf(entry))];
+                existing->forEachMark(entry, [&](int day, bool present) { studentMarks[day] = {day, present, ""}; });
+                existing->forEachRemark(entry, [&](int day, string_view text) { studentMarks[day].remark = text; });
+            }
+        }
+        vector<AttendanceCounts> leaving(students.size());  // per row, logged to the history once dropped
+        for (size_t row = 0; row < students.size(); row++) {
+            const Student& student = students[row];
+            for (const auto& record : student.getAttendanceRecord().raw()) {
+                string date = record.key.str();
+                if (date < first || date > last) continue;
+                int day = dayNumberFromDate(date);
+                marks[student.getUniqueId()][day] = {day, record.value, student.getRemarkForDate(date)};
+                leaving[row].present += record.value ? 1 : 0;
+                leaving[row].recorded++;
+                moved++;
+            }
+        }
+        if (moved == 0) return true;
+
+        vector<ArchiveStudentMarks> segmentInput;
+        for (auto& student : marks) {
+            ArchiveStudentMarks input{student.first, {}};
+            for (auto& mark : student.second) input.marks.push_back(move(mark.second));
+            segmentInput.push_back(move(input));
+        }
+        archive.close(year);  // unmapped before its file is replaced
+        indexedArchiveYears.erase(year);
+        if (!writeArchiveSegment(archive.pathFor(year), firstDay, lastDay, move(segmentInput), error)) {
+            showError(error);
+            moved = 0;
+            return false;
+        }
+
+        // The segment is durable, so the live copies can go
+        for (size_t row = 0; row < students.size(); row++) {
+            Student& student = students[row];
+            if (student.dropAttendanceBetween(first, last) == 0) continue;
+            roster.refresh(row, student.getAttendanceRecord());
+            partitions.markDirty(student.getClassName(), student.getSection());
+            history.recordArchived(student.getUniqueId(), leaving[row].present, leaving[row].recorded, time(nullptr));
+        }
+        flushHistory();
+        return true;
+    }
+
+    // Drops every section from memory; each reloads from its file on next access
+    void unloadAllSections() {
+        students.clear();  // before the arenas their strings live in
+        roster.clear();
+        partitions.clear();
+        sectionArenas.clear();
+        allSectionsLoaded = false;
+    }
+
+    // Archives a closed year, then saves every section and unloads it, so
+    // each reloads from its smaller file
+    bool archiveAcademicYear(int year) {
+        METRIC_STAGE(STAGE_SAVE);
+        TRACE_SPAN("archiveAcademicYear");
+        string label = academicYearLabel(year);
+        size_t moved;
+        if (!archiveYearMarks(year, moved)) return false;
+        if (moved == 0) {
+            showWarning("No attendance in the class files falls in " + label);
+            return false;
+        }
+        saveToFile();
+        unloadAllSections();
+
+        logAction("Archived " + to_string(moved) + " marks of " + label);
+        showSuccess("Archived " + to_string(moved) + " marks of " + label + " to " + archive.pathFor(year));
+        return true;
+    }
+
+    string getRollupPath(int year) const { return archive.directory() + "/rollup_" + to_string(year) + ".csv"; }
+
+    // Final attendance of a closed year from its segment: one row per
+    // student, then per section and for the whole school. Written durably,
+    // since the marks behind it are no longer in the class files.
+    bool writeYearRollups(int year, string& error) {
+        const ArchiveSegment* segment = archive.segment(year, error);
+        if (!segment) return false;
+        unordered_map<string, const Student*> byId;
+        for (const auto& student : students) byId[student.getUniqueId()] = &student;
+
+        ostringstream out;
+        out << "scope,class,section,unique_id,roll_no,name,present,days,percentage\n";
+        auto row = [&](const string& scope, const string& className, const string& section, const string& uniqueId,
+                       const string& rollNo, const string& name, uint64_t present, uint64_t days) {
+            out << scope << "," << className << "," << section << "," << uniqueId << "," << rollNo << ","
+                << name << "," << present << "," << days << "," << fixed << setprecision(2)
+                << (days > 0 ? (double)present / days * 100 : 0.0) << "\n";
+        };
+        map<pair<string, string>, pair<uint64_t, uint64_t>> sections;  // (class, section) -> (present, days)
+        uint64_t schoolPresent = 0, schoolDays = 0;
+        for (size_t i = 0; i < segment->studentCount(); i++) {
+            const ArchiveStudent& entry = segment->student(i);
+            string uniqueId(segment->idOf(entry));
+            uint32_t present = 0, recorded = 0;
+            segment->count(entry, INT_MIN, INT_MAX, present, recorded);
+
+            // uniqueId is class_section_rollNo; a student no longer loaded has no name
+            size_t first = uniqueId.find('_'), second = uniqueId.find('_', first + 1);
+            string className = uniqueId.substr(0, first);
+            string section = second == string::npos ? "" : uniqueId.substr(first + 1, second - first - 1);
+            string rollNo = second == string::npos ? "" : uniqueId.substr(second + 1);
+            auto student = byId.find(uniqueId);
+            row("student", className, section, uniqueId, rollNo, student == byId.end() ? "" : student->second->getName(),
+                present, recorded);
+            auto& totals = sections[{className, section}];
+            totals.first += present;
+            totals.second += recorded;
+            schoolPresent += present;
+            schoolDays += recorded;
+        }
+        for (const auto& section : sections) {
+            row("section", section.first.first, section.first.second, "", "", "", section.second.first,
+                section.second.second);
+        }
+        row("school", "", "", "", "", "", schoolPresent, schoolDays);
+
+        string path = getRollupPath(year);
+        if (!writeDurableTemp(path, out.str(), error) || !commitDurableTemp(path, error)) return false;
+        syncDirectory(archive.directory());
+        return true;
+    }
+
+    // A date in a rolled-over year; its marks are frozen in the archive
+    bool isClosedDate(const string& date) {
+        int last = idHistory.lastRolledOver();
+        return last != INT_MIN && dayNumberFromDate(date) <= academicYearLastDay(last);
+    }
+
+    string getRolloverJournalPath() const { return BASE_DIR + "/rollover.pending"; }
+
+    // Starts the journal of a rollover: its year, then "renamed" once the id
+    // changes are in the attendance history
+    bool writeRolloverJournal(int year, string& error) {
+        string path = getRolloverJournalPath();
+        if (!writeDurableTemp(path, to_string(year) + "\n", error) || !commitDurableTemp(path, error)) return false;
+        syncDirectory(BASE_DIR);
+        return true;
+    }
+
+    // Class and stats files staged by an unfinished rollover
+    vector<string> stagedRolloverFiles() const {
+        vector<string> found;
+        error_code code;
+        for (auto it = filesystem::recursive_directory_iterator(BASE_DIR, code);
+             !code && it != filesystem::recursive_directory_iterator(); it.increment(code)) {
+            string path = it->path().string();
+            if (path.ends_with(ROLLOVER_FILE_SUFFIX)) found.push_back(path);
+        }
+        sort(found.begin(), found.end());
+        return found;
+    }
+
+    // Rolls back a rollover that never reached its commit point
+    void discardRollover() {
+        error_code code;
+        for (const string& path : stagedRolloverFiles()) filesystem::remove(path, code);
+        filesystem::remove(getRolloverJournalPath(), code);
+    }
+
+    // Everything after a rollover's commit point; safe to repeat. Logs the
+    // renames to the attendance history unless the journal says they are
+    // there, then moves each staged file over its class or stats file.
+    void finishRollover(int year, const vector<pair<string, string>>& changes, bool renamesLogged) {
+        string error;
+        if (!renamesLogged && history.started()) {
+            // Highest class first, so each id is vacated before the class below takes it
+            vector<pair<string, string>> renames = changes;
+            stable_sort(renames.begin(), renames.end(), [](const auto& a, const auto& b) {
+                return stoi(a.first) > stoi(b.first);
+            });
+            for (const auto& rename : renames) history.recordRename(rename.first, rename.second, time(nullptr));
+            flushHistory();
+            if (!appendDurable(getRolloverJournalPath(), "renamed\n", error)) logAction("Rollover journal: " + error);
+        }
+
+        set<string> directories;
+        int64_t now = time(nullptr);
+        for (const string& stagedPath : stagedRolloverFiles()) {
+            string path = stagedPath.substr(0, stagedPath.size() - strlen(ROLLOVER_FILE_SUFFIX));
+            bool classFile = path.ends_with(".csv");
+            if (classFile && !backups.captureExisting(path, now, error)) logAction("Backup failed: " + error);
+            if (!replaceWithSynced(stagedPath, path, error)) {
+                showError("Rollover of " + academicYearLabel(year) + " not finished: " + error);
+                return;  // the journal stays, so the next start tries again
+            }
+            directories.insert(filesystem::path(path).parent_path().string());
+            if (classFile) {
+                ifstream in(path, ios::binary);
+                string content((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+                if (!backups.backup(path, content, now, error)) logAction("Backup failed: " + error);
+            }
+        }
+        for (const string& directory : directories) syncDirectory(directory);
+        error_code code;
+        filesystem::remove(getRolloverJournalPath(), code);
+        syncDirectory(BASE_DIR);
+    }
+
+    // Startup: a rollover interrupted before its id changes were recorded is
+    // dropped; one interrupted after them is finished. The catalog predates
+    // the promotion either way, so it is rebuilt from the class files.
+    void resumeRollover() {
+        ifstream in(getRolloverJournalPath());
+        if (!in.is_open()) return;
+        string yearLine, renamed;
+        getline(in, yearLine);
+        getline(in, renamed);
+        in.close();
+        int year = atoi(yearLine.c_str());
+        string label = academicYearLabel(year);
+        error_code code;
+        if (yearLine.empty() || idHistory.lastRolledOver() < year) {
+            discardRollover();
+            logAction("Discarded the unfinished rollover of " + label);
+            showWarning("An unfinished rollover of " + label + " was discarded; the year is still open");
+            return;
+        }
+        finishRollover(year, idHistory.changesIn(year), renamed == "renamed");
+        filesystem::remove(getCatalogPath(), code);
+        logAction("Finished the interrupted rollover of " + label);
+        showWarning("The rollover of " + label + " was interrupted and has been finished");
+    }
+
+    // Closes an academic year: archives its marks, writes its final
+    // rollups, promotes every student to the next class (class 12
+    // graduates and leaves the class files) and records the id changes.
+    // Exams and the session's indexes start empty. Everything is saved and
+    // unloaded, so the new year loads from small files.
+    //
+    // The promoted class files are first staged next to their targets
+    // (<path>.rollover) under a rollover.pending journal. Recording the id
+    // changes is the commit point: before it, a failure drops the staged
+    // files and reloads the untouched class files; after it, the renames are
+    // logged and the staged files replace the class files, and startup
+    // finishes that step if a crash interrupted it (resumeRollover).
+    bool rolloverAcademicYear(int year) {
+        METRIC_STAGE(STAGE_SAVE);
+        TRACE_SPAN("rolloverAcademicYear");
+        string label = academicYearLabel(year);
+        int lastRolledOver = idHistory.lastRolledOver();
+        if (year <= lastRolledOver) {
+            showError(label + " is not after the last closed year, " + academicYearLabel(lastRolledOver));
+            return false;
+        }
+        if (dayNumberFromDate(getCurrentDate()) <= academicYearLastDay(year)) {
+            showError("The " + label + " academic year has not ended yet");
+            return false;
+        }
+
+        // Earlier years still in the class files are closed along with it
+        loadAllSections();
+        string earliest = dateFromDayNumber(academicYearFirstDay(year));
+        for (const auto& student : students) {
+            const auto& records = student.getAttendanceRecord().raw();
+            if (!records.empty()) earliest = min(earliest, records.front().key.str());
+        }
+        size_t moved = 0;
+        for (int closing = academicYearOf(earliest); closing <= year; closing++) {
+            size_t yearMoved;
+            if (!archiveYearMarks(closing, yearMoved)) return false;
+            moved += yearMoved;
+        }
+        string error;
+        if (filesystem::exists(archive.pathFor(year)) && !writeYearRollups(year, error)) {
+            showError("Rollups not written: " + error);
+            return false;
+        }
+
+        // The class files must match memory, so an abort can reload them
+        saveToFile();
+        if (!partitions.dirtyPartitions().empty()) {
+            showError("Rollover of " + label + " not started: the class files could not be saved");
+            return false;
+        }
+
+        vector<pair<string, string>> changes;  // old uniqueId -> new, empty for a graduate
+        size_t graduated = 0;
+        vector<Student> promoted;
+        promoted.reserve(students.size());
+        for (auto& student : students) {
+            string oldId = student.getUniqueId(), className = student.getClassName(), section = student.getSection();
+            partitions.markDirty(className, section);
+            int classNum = stoi(className);
+            if (classNum >= 12) {
+                changes.push_back({oldId, ""});
+                graduated++;
+                continue;
+            }
+            student.promoteTo(to_string(classNum + 1));
+            partitions.markDirty(student.getClassName(), section);
+            changes.push_back({oldId, student.getUniqueId()});
+            promoted.push_back(move(student));
+        }
+        students = move(promoted);
+
+        vector<PersistFile> staged;
+        vector<CatalogEntry> entries;
+        bool committed = writeRolloverJournal(year, error);
+        for (const PartitionState* partition : partitions.dirtyPartitions()) {
+            if (!committed) break;
+            string className = partition->className, section = partition->section;
+            string content = renderClassFile(className, section);
+            entries.push_back(summarizeSection(className, section, crc32c(content)));
+            staged.push_back({getClassFilePath(className, section), move(content), true});
+            staged.push_back({getStatsFilePath(className, section), renderAttendanceStats(className, section), false});
+            for (size_t i = staged.size() - 2; i < staged.size() && committed; i++) {
+                string stagedPath = staged[i].path + ROLLOVER_FILE_SUFFIX;
+                committed = writeDurableTemp(stagedPath, staged[i].content, error) && commitDurableTemp(stagedPath, error);
+            }
+        }
+        committed = committed && idHistory.record(year, changes, error);
+        if (!committed) {
+            discardRollover();
+            unloadAllSections();  // drops the promotion; sections reload from the class files
+            showError("Rollover of " + label + " abandoned, nothing was changed: " + error);
+            return false;
+        }
+
+        for (CatalogEntry& entry : entries) catalog.update(move(entry), true);
+        finishRollover(year, changes, false);
+        roster.clear();
+        examRecords.clear();
+        gradebook = Gradebook();
+        undoActions.clear();  // they name the old ids
+        redoActions.clear();
+        searchIndex = StudentSearchIndex();
+        textIndex = FullTextIndex();
+        indexedArchiveYears.clear();
+        unloadAllSections();
+        queueCatalogSave();
+        persistence.flush();
+        reportPersistenceErrors();
+
+        logAction("Closed " + label + ": " + to_string(moved) + " marks archived, " +
+                  to_string(changes.size() - graduated) + " promoted, " + to_string(graduated) + " graduated");
+        showSuccess("Closed " + label + ": " + to_string(changes.size() - graduated) + " students promoted, " +
+                    to_string(graduated) + " graduated");
+        return true;
+    }
+
+    void archiveYear() {
+        clearScreen();
+        printTitle("Archive a Closed Year");
+        int year;
+        cout << "Academic year starting in (e.g. 2024 for " << academicYearLabel(2024) << "): ";
+        if (!(cin >> year)) {
+            cin.clear();
+            cin.ignore(10000, '\n');
+            showError("Invalid year!");
+            return;
+        }
+        archiveAcademicYear(year);
+    }
+
+    void undoRedoMarking() {
+        clearScreen();
+        printTitle("Undo/Redo Marking");
+        cout << "1. Undo " << (undoActions.empty() ? "(nothing)" : undoActions.back().label) << "\n";
+        cout << "2. Redo " << (redoActions.empty() ? "(nothing)" : redoActions.back().label) << "\n";
+        cout << "3. Undo One Student's Entry\n";
+        cout << "0. Back\n\n";
+
+        int choice;
+        cout << "Enter choice: ";
+        cin >> choice;
+        if (choice == 1) {
+            undoMarking();
+        } else if (choice == 2) {
+            redoMarking();
+        } else if (choice == 3) {
+            auto [className, section] = getClassAndSection();
+            if (className.empty() || section.empty()) return;
+            string rollNo;
+            cout << "Enter Roll No: ";
+            getline(cin, rollNo);
+            undoStudentEntry(className, section, rollNo);
+        } else if (choice != 0) {
+            showError("Invalid choice!");
+        }
+    }
+
+    void closeAcademicYear() {
+        clearScreen();
+        printTitle("Close Academic Year");
+        int year;
+        cout << "Academic year starting in (e.g. 2024 for " << academicYearLabel(2024) << "): ";
+        if (!(cin >> year)) {
+            cin.clear();
+            cin.ignore(10000, '\n');
+            showError("Invalid year!");
+            return;
+        }
+        cout << "Every student moves up a class and class 12 graduates. Continue? (y/n): ";
+        char confirm = tolower(readKey());
+        cout << confirm << endl;
+        if (confirm != 'y') return;
+        rolloverAcademicYear(year);
+    }
+
     void viewSystemLogs() {
         auto [className, section] = getClassAndSection();
         if (className.empty() || section.empty()) {
@@ -2768,8 +5190,17 @@ public:
     }
 };
 
-int main() {
+#ifndef ATTENDANCE_NO_MAIN
+int main(int argc, char* argv[]) {
+    // No-op unless built with -DATTENDANCE_METRICS; declared first so the final
+    // dump includes the shutdown save
+    METRICS_EXPORTER("metrics/attendance.prom", 10);
     AttendanceSystem system;
+
+    // "attendance_system --verify" checks the data directory and exits, for scripts
+    if (argc > 1 && string(argv[1]) == "--verify") {
+        return system.verifyData() == 0 ? 0 : 1;
+    }
     string password;
     int choice;
     bool loggedIn = false;
@@ -2829,8 +5260,7 @@ int main() {
                     system.showStatistics();
                     break;
                 case 7:
-                    // system.exportToExcel(); // This function does not exist in AttendanceSystem class
-                    system.showError("Export to Excel feature is not available.");
+                    system.exportColumnarData();
                     break;
                 case 8:
                     // system.viewSystemLogs(); // This function does not exist in AttendanceSystem class
@@ -2838,20 +5268,37 @@ int main() {
                     break;
                 case 9:
                     loggedIn = false;
+                    system.logout();
                     system.showSuccess("Logged out successfully!");
                     break;
                 case 10:
                     system.showSuccess("Thank you for using Smart Attendance System!");
                     return 0;
+                case 11:
+                    system.manageBackups();
+                    break;
+                case 12:
+                    printTitle("Verify Data");
+                    system.verifyData();
+                    break;
+                case 13:
+                    system.archiveYear();
+                    break;
+                case 14:
+                    system.closeAcademicYear();
+                    break;
+                case 15:
+                    system.undoRedoMarking();
+                    break;
                 default:
                     system.showError("Invalid choice!");
             }
         }
         
         cout << "\nPress any key to continue...";
-        _getch();
+        readKey();
     }
 
     return 0;
-} 
-} 
\ No newline at end of file
+}
+#endif
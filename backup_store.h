@@ -0,0 +1,580 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <mutex>
+#include <thread>
+#include <filesystem>
+#include <fstream>
+#include <climits>
+#include <cstdint>
+#include <charconv>
+#include "varint.h"
+#include "durable_io.h"
+
+// Deduplicating backup store for class files. Every saved version of a file
+// is cut into content-defined chunks; a chunk is stored once, however many
+// versions or files contain it, and each version is a manifest listing its
+// chunks. A save that appends a day of attendance changes only the last
+// chunk of each row, so a backup costs about one small chunk per student
+// instead of a full copy of the file.
+//
+// On disk, under the store root:
+//   chunks.pack          chunk bytes, appended back to back
+//   chunks.idx           per chunk: fixed64 hash, fixed64 check hash, varint length
+//   manifests/<file>.log one record per version of that file, appended; the
+//                        file's path with '%', '/', '\\' and ':' written as %XX
+//
+// A manifest record is: varint body length, then varint time, varint file
+// size, varint kind. A full record (kind 1) lists every chunk number; a
+// delta record (kind 0) is a list of ops against the previous record, each
+// either a copy of a run of its chunks or a run of literal chunk numbers.
+// Every BACKUP_CHECKPOINT_EVERY-th record is full, bounding restore work.
+// Pack, index and manifest are appended in that order, each synced before
+// the next is written, so a record never reaches the device ahead of the
+// chunks it lists; after a crash the loader trims whatever the index or log
+// did not finish referencing.
+
+const size_t BACKUP_CHUNK_MIN = 32;
+const size_t BACKUP_CHUNK_MAX = 1024;
+const int BACKUP_CHUNK_BITS = 6;           // about 64 bytes past the minimum on average
+const size_t BACKUP_CHECKPOINT_EVERY = 32;
+
+// Random 64-bit value per byte for the rolling gear hash (splitmix64)
+struct BackupGearTable {
+    uint64_t values[256];
+    constexpr BackupGearTable() : values() {
+        uint64_t state = 0x6A09E667F3BCC909ULL;
+        for (int i = 0; i < 256; i++) {
+            state += 0x9E3779B97F4A7C15ULL;
+            uint64_t z = state;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            values[i] = z ^ (z >> 31);
+        }
+    }
+};
+inline constexpr BackupGearTable BACKUP_GEAR;
+
+struct BackupSnapshot {
+    string path;
+    int64_t time;   // seconds since the epoch
+    uint64_t size;
+};
+
+class BackupStore {
+private:
+    struct ChunkEntry {
+        uint64_t check;
+        uint64_t offset;
+        uint32_t length;
+    };
+
+    struct Record {
+        int64_t time;
+        uint64_t size;
+        uint64_t offset;   // of the body in the log
+        uint32_t length;   // of the body
+        bool full;
+    };
+
+    struct History {
+        vector<Record> records;
+        vector<uint32_t> lastChunks;  // chunk list of the newest record
+        bool loaded = false;
+    };
+
+    mutable mutex lock;
+    string root;
+    bool opened = false;
+    vector<ChunkEntry> chunks;
+    unordered_map<uint64_t, uint32_t> byHash;
+    uint64_t packBytes = 0;
+    map<string, History> histories;
+
+    string packPath() const { return root + "/chunks.pack"; }
+    string indexPath() const { return root + "/chunks.idx"; }
+
+    string logPath(const string& path) const {
+        return root + "/manifests/" + escapeName(filesystem::path(path).generic_string()) + ".log";
+    }
+
+    static string escapeName(const string& path) {
+        static const char* const HEX = "0123456789ABCDEF";
+        string name;
+        for (unsigned char c : path) {
+            if (c == '%' || c == '/' || c == '\\' || c == ':') {
+                name += '%';
+                name += HEX[c >> 4];
+                name += HEX[c & 15];
+            } else {
+                name += (char)c;
+            }
+        }
+        return name;
+    }
+
+    // Inverse of escapeName; false for a name escapeName could not have written
+    static bool unescapeName(const string& name, string& path) {
+        path.clear();
+        for (size_t i = 0; i < name.size(); i++) {
+            if (name[i] != '%') {
+                path += name[i];
+                continue;
+            }
+            unsigned value = 0;
+            const char* digits = name.data() + i + 1;
+            if (i + 2 >= name.size() || from_chars(digits, digits + 2, value, 16).ptr != digits + 2) return false;
+            path += (char)value;
+            i += 2;
+        }
+        return true;
+    }
+
+    static uint64_t hashBytes(string_view bytes, uint64_t seed) {
+        uint64_t hash = seed;
+        for (unsigned char c : bytes) hash = (hash ^ c) * 0x100000001B3ULL;  // FNV-1a
+        return hash ^ (hash >> 29);
+    }
+
+    static uint64_t hashOf(string_view bytes) { return hashBytes(bytes, 0xCBF29CE484222325ULL); }
+    static uint64_t checkOf(string_view bytes) { return hashBytes(bytes, 0x84222325CBF29CE4ULL) * 0x9E3779B97F4A7C15ULL; }
+
+    static string readAll(const string& path) {
+        ifstream in(path, ios::binary);
+        if (!in.is_open()) return string();
+        return string(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+    }
+
+    // Appends durably; a file the append created is only durable once its
+    // directory is synced too
+    static bool append(const string& path, const string& bytes, string& error) {
+        error_code code;
+        bool created = !filesystem::exists(path, code);
+        if (!appendDurable(path, bytes, error)) return false;
+        if (created) syncDirectory(filesystem::path(path).parent_path().string());
+        return true;
+    }
+
+    // Loads the chunk index, trimming entries whose bytes never reached the pack
+    void open() {
+        if (opened) return;
+        opened = true;
+        error_code code;
+        if (filesystem::create_directories(root + "/manifests", code)) syncDirectory(root);
+
+        string index = readAll(indexPath());
+        uint64_t packSize = filesystem::exists(packPath(), code) ? filesystem::file_size(packPath(), code) : 0;
+        const char* pos = index.data();
+        const char* end = pos + index.size();
+        const char* valid = pos;
+        while (end - pos >= 16) {
+            uint64_t hash = getFixed64(pos);
+            uint64_t check = getFixed64(pos + 8);
+            const char* cursor = pos + 16;
+            uint64_t length;
+            if (!getVarint(cursor, end, length) || packBytes + length > packSize) break;
+            byHash.emplace(hash, (uint32_t)chunks.size());
+            chunks.push_back({check, packBytes, (uint32_t)length});
+            packBytes += length;
+            pos = valid = cursor;
+        }
+        if (valid != end) filesystem::resize_file(indexPath(), valid - index.data(), code);
+        if (packSize > packBytes) filesystem::resize_file(packPath(), packBytes, code);
+    }
+
+    // Reads a file's manifest log, dropping a torn last record
+    History& historyFor(const string& path) {
+        History& history = histories[path];
+        if (history.loaded) return history;
+        history.loaded = true;
+
+        string log = readAll(logPath(path));
+        const char* begin = log.data();
+        const char* pos = begin;
+        const char* end = begin + log.size();
+        const char* valid = pos;
+        vector<uint32_t> current;
+        while (pos < end) {
+            uint64_t length;
+            if (!getVarint(pos, end, length) || (uint64_t)(end - pos) < length) break;
+            Record record;
+            record.offset = (uint64_t)(pos - begin);
+            record.length = (uint32_t)length;
+            if (!decodeRecord(string_view(pos, (size_t)length), current, record)) break;
+            history.records.push_back(record);
+            pos += length;
+            valid = pos;
+        }
+        if (valid != end) {
+            error_code code;
+            filesystem::resize_file(logPath(path), valid - begin, code);
+        }
+        history.lastChunks = move(current);
+        return history;
+    }
+
+    // Applies one record body to the previous version's chunk list
+    bool decodeRecord(string_view body, vector<uint32_t>& chunkList, Record& record) const {
+        const char* pos = body.data();
+        const char* end = pos + body.size();
+        uint64_t time, size, kind, count;
+        if (!getVarint(pos, end, time) || !getVarint(pos, end, size) || !getVarint(pos, end, kind) ||
+            !getVarint(pos, end, count)) {
+            return false;
+        }
+        record.time = (int64_t)time;
+        record.size = size;
+        record.full = kind == 1;
+
+        vector<uint32_t> result;
+        if (record.full) {
+            for (uint64_t i = 0; i < count; i++) {
+                uint64_t chunk;
+                if (!getVarint(pos, end, chunk) || chunk >= chunks.size()) return false;
+                result.push_back((uint32_t)chunk);
+            }
+        } else {
+            for (uint64_t op = 0; op < count; op++) {
+                uint64_t header;
+                if (!getVarint(pos, end, header)) return false;
+                uint64_t run = header >> 1;
+                if (header & 1) {
+                    uint64_t start;
+                    if (!getVarint(pos, end, start) || start + run > chunkList.size()) return false;
+                    result.insert(result.end(), chunkList.begin() + start, chunkList.begin() + start + run);
+                } else {
+                    for (uint64_t i = 0; i < run; i++) {
+                        uint64_t chunk;
+                        if (!getVarint(pos, end, chunk) || chunk >= chunks.size()) return false;
+                        result.push_back((uint32_t)chunk);
+                    }
+                }
+            }
+        }
+        chunkList.swap(result);
+        return true;
+    }
+
+    // Copy runs against the previous version where it lines up, literals elsewhere
+    static string encodeDelta(const vector<uint32_t>& previous, const vector<uint32_t>& next, size_t& opCount) {
+        unordered_map<uint32_t, size_t> firstAt;
+        for (size_t i = previous.size(); i-- > 0;) firstAt[previous[i]] = i;
+
+        string ops;
+        opCount = 0;
+        vector<uint32_t> literals;
+        auto flushLiterals = [&]() {
+            if (literals.empty()) return;
+            putVarint(ops, literals.size() << 1);
+            for (uint32_t chunk : literals) putVarint(ops, chunk);
+            literals.clear();
+            opCount++;
+        };
+
+        size_t expected = 0;  // where the previous copy run left off
+        for (size_t i = 0; i < next.size();) {
+            size_t start = SIZE_MAX;
+            if (expected < previous.size() && previous[expected] == next[i]) {
+                start = expected;
+            } else {
+                auto found = firstAt.find(next[i]);
+                if (found != firstAt.end()) start = found->second;
+            }
+            if (start == SIZE_MAX) {
+                literals.push_back(next[i++]);
+                continue;
+            }
+            size_t run = 0;
+            while (i + run < next.size() && start + run < previous.size() && previous[start + run] == next[i + run]) run++;
+            flushLiterals();
+            putVarint(ops, run << 1 | 1);
+            putVarint(ops, start);
+            opCount++;
+            i += run;
+            expected = start + run;
+        }
+        flushLiterals();
+        return ops;
+    }
+
+    // Chunk list of one record, replayed from the checkpoint before it
+    bool chunksOf(const string& path, const History& history, size_t index, vector<uint32_t>& chunkList,
+                  string& error) const {
+        size_t first = index;
+        while (first > 0 && !history.records[first].full) first--;
+        ifstream log(logPath(path), ios::binary);
+        chunkList.clear();
+        for (size_t i = first; i <= index; i++) {
+            Record record = history.records[i];
+            string body(record.length, '\0');
+            log.seekg((streamoff)record.offset);
+            log.read(&body[0], (streamsize)body.size());
+            if (!log || !decodeRecord(body, chunkList, record)) {
+                error = "Backup manifest is damaged: " + logPath(path);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Newest record at or before asOf, or -1
+    static long latestAsOf(const History& history, int64_t asOf) {
+        long found = -1;
+        for (size_t i = 0; i < history.records.size(); i++) {
+            if (history.records[i].time <= asOf) found = (long)i;
+        }
+        return found;
+    }
+
+public:
+    explicit BackupStore(const string& storeRoot) : root(storeRoot) {}
+
+    BackupStore(const BackupStore&) = delete;
+    BackupStore& operator=(const BackupStore&) = delete;
+
+    // Chunk boundaries: a cut when the rolling gear hash's top bits are zero,
+    // after every newline so an edit never moves the cuts of another row,
+    // and at BACKUP_CHUNK_MAX
+    static vector<size_t> chunkEnds(string_view content) {
+        vector<size_t> ends;
+        uint64_t hash = 0;
+        size_t start = 0;
+        for (size_t i = 0; i < content.size(); i++) {
+            hash = (hash << 1) + BACKUP_GEAR.values[(unsigned char)content[i]];
+            size_t length = i + 1 - start;
+            bool cut = content[i] == '\n' || length >= BACKUP_CHUNK_MAX ||
+                       (length >= BACKUP_CHUNK_MIN && (hash >> (64 - BACKUP_CHUNK_BITS)) == 0);
+            if (cut) {
+                ends.push_back(i + 1);
+                start = i + 1;
+                hash = 0;
+            }
+        }
+        if (start < content.size()) ends.push_back(content.size());
+        return ends;
+    }
+
+    // Records a version of path. Chunks already stored are referenced, not
+    // written again; a version identical to the newest one adds nothing.
+    bool backup(const string& path, string_view content, int64_t time, string& error) {
+        vector<size_t> ends = chunkEnds(content);
+        vector<pair<uint64_t, uint64_t>> hashes;
+        hashes.reserve(ends.size());
+        for (size_t i = 0, start = 0; i < ends.size(); start = ends[i++]) {
+            string_view chunk = content.substr(start, ends[i] - start);
+            hashes.push_back({hashOf(chunk), checkOf(chunk)});
+        }
+
+        lock_guard<mutex> guard(lock);
+        open();
+        History& history = historyFor(path);
+
+        string pack, index;
+        vector<uint32_t> chunkList;
+        chunkList.reserve(ends.size());
+        vector<ChunkEntry> added;
+        unordered_map<uint64_t, uint32_t> addedByHash;
+        for (size_t i = 0, start = 0; i < ends.size(); start = ends[i++]) {
+            uint32_t length = (uint32_t)(ends[i] - start);
+            auto matches = [&](const ChunkEntry& entry) {
+                return entry.check == hashes[i].second && entry.length == length;
+            };
+            auto known = byHash.find(hashes[i].first);
+            if (known != byHash.end() && matches(chunks[known->second])) {
+                chunkList.push_back(known->second);
+                continue;
+            }
+            auto repeated = addedByHash.find(hashes[i].first);
+            if (repeated != addedByHash.end() && matches(added[repeated->second - chunks.size()])) {
+                chunkList.push_back(repeated->second);
+                continue;
+            }
+            uint32_t number = (uint32_t)(chunks.size() + added.size());
+            addedByHash.emplace(hashes[i].first, number);
+            added.push_back({hashes[i].second, packBytes + pack.size(), length});
+            pack.append(content.data() + start, length);
+            putFixed64(index, hashes[i].first);
+            putFixed64(index, hashes[i].second);
+            putVarint(index, length);
+            chunkList.push_back(number);
+        }
+
+        if (!history.records.empty() && added.empty() && chunkList == history.lastChunks) return true;
+
+        bool full = history.records.size() % BACKUP_CHECKPOINT_EVERY == 0;
+        string body;
+        putVarint(body, (uint64_t)time);
+        putVarint(body, content.size());
+        putVarint(body, full ? 1 : 0);
+        if (full) {
+            putVarint(body, chunkList.size());
+            for (uint32_t chunk : chunkList) putVarint(body, chunk);
+        } else {
+            size_t opCount;
+            string ops = encodeDelta(history.lastChunks, chunkList, opCount);
+            putVarint(body, opCount);
+            body += ops;
+        }
+        string record;
+        putVarint(record, body.size());
+        uint64_t logSize = 0;
+        {
+            error_code code;
+            if (filesystem::exists(logPath(path), code)) logSize = filesystem::file_size(logPath(path), code);
+        }
+        uint64_t bodyOffset = logSize + record.size();
+        record += body;
+
+        if (!pack.empty() && (!append(packPath(), pack, error) || !append(indexPath(), index, error))) return false;
+        chunks.insert(chunks.end(), added.begin(), added.end());
+        for (const auto& entry : addedByHash) byHash.emplace(entry.first, entry.second);
+        packBytes += pack.size();
+
+        if (!append(logPath(path), record, error)) return false;
+        history.records.push_back({time, content.size(), bodyOffset, (uint32_t)body.size(), full});
+        history.lastChunks = move(chunkList);
+        return true;
+    }
+
+    // Records the file now on disk if the store has never seen path, so the
+    // version that predates the store survives its first overwrite
+    bool captureExisting(const string& path, int64_t time, string& error) {
+        {
+            lock_guard<mutex> guard(lock);
+            open();
+            if (!historyFor(path).records.empty()) return true;
+        }
+        error_code code;
+        if (!filesystem::exists(path, code)) return true;
+        return backup(path, readAll(path), time, error);
+    }
+
+    // Versions of one file, oldest first
+    vector<BackupSnapshot> history(const string& path) {
+        lock_guard<mutex> guard(lock);
+        open();
+        vector<BackupSnapshot> snapshots;
+        for (const Record& record : historyFor(path).records) snapshots.push_back({path, record.time, record.size});
+        return snapshots;
+    }
+
+    // Point in time: for every file with a version at or before asOf, the newest such version
+    vector<BackupSnapshot> list(int64_t asOf = INT64_MAX) {
+        lock_guard<mutex> guard(lock);
+        open();
+        error_code code;
+        for (const auto& entry : filesystem::directory_iterator(root + "/manifests", code)) {
+            string name = entry.path().filename().string();
+            if (!name.ends_with(".log")) continue;
+            string path;
+            if (unescapeName(name.substr(0, name.size() - 4), path)) historyFor(path);
+        }
+        vector<BackupSnapshot> snapshots;
+        for (const auto& file : histories) {
+            long found = latestAsOf(file.second, asOf);
+            if (found >= 0) {
+                const Record& record = file.second.records[found];
+                snapshots.push_back({file.first, record.time, record.size});
+            }
+        }
+        return snapshots;
+    }
+
+    // Contents of path as of a point in time
+    bool restore(const string& path, int64_t asOf, string& content, string& error) {
+        lock_guard<mutex> guard(lock);
+        open();
+        const History& history = historyFor(path);
+        long found = latestAsOf(history, asOf);
+        if (found < 0) {
+            error = "No backup of " + path + " at that time";
+            return false;
+        }
+
+        vector<uint32_t> chunkList;
+        if (!chunksOf(path, history, (size_t)found, chunkList, error)) return false;
+        ifstream pack(packPath(), ios::binary);
+        content.clear();
+        content.reserve(history.records[found].size);
+        string buffer;
+        for (uint32_t number : chunkList) {
+            const ChunkEntry& chunk = chunks[number];
+            buffer.resize(chunk.length);
+            pack.seekg((streamoff)chunk.offset);
+            pack.read(&buffer[0], (streamsize)chunk.length);
+            if (!pack) {
+                error = "Backup chunk store is damaged: " + packPath();
+                return false;
+            }
+            content += buffer;
+        }
+        if (content.size() != history.records[found].size) {
+            error = "Backup of " + path + " did not restore to its recorded size";
+            return false;
+        }
+        return true;
+    }
+
+    size_t chunkCount() {
+        lock_guard<mutex> guard(lock);
+        open();
+        return chunks.size();
+    }
+
+    // Re-reads every chunk from the pack and compares it with the check hash
+    // in the index, each thread taking a contiguous run of chunks. Returns
+    // the numbers of the chunks that differ; bytes counts what was read.
+    vector<uint32_t> verifyChunks(uint64_t& bytes, unsigned threadCount = thread::hardware_concurrency()) {
+        vector<ChunkEntry> stored;
+        {
+            lock_guard<mutex> guard(lock);
+            open();
+            stored = chunks;  // chunks appended while verifying are left for the next run
+        }
+        bytes = 0;
+        threadCount = max(1u, min(threadCount, (unsigned)max<size_t>(stored.size() / 1024, 1)));
+        vector<vector<uint32_t>> bad(threadCount);
+        vector<uint64_t> read(threadCount, 0);
+
+        auto worker = [&](unsigned t) {
+            size_t first = stored.size() * t / threadCount, last = stored.size() * (t + 1) / threadCount;
+            if (first == last) return;
+            ifstream pack(packPath(), ios::binary);
+            pack.seekg((streamoff)stored[first].offset);
+            string buffer;
+            for (size_t i = first; i < last; i++) {
+                buffer.resize(stored[i].length);
+                if (!pack.read(buffer.data(), (streamsize)buffer.size()) || checkOf(buffer) != stored[i].check) {
+                    bad[t].push_back((uint32_t)i);
+                    pack.clear();
+                    pack.seekg((streamoff)(stored[i].offset + stored[i].length));
+                }
+                read[t] += buffer.size();
+            }
+        };
+        vector<thread> workers;
+        for (unsigned t = 1; t < threadCount; t++) workers.emplace_back(worker, t);
+        worker(0);
+        for (auto& w : workers) w.join();
+
+        vector<uint32_t> failed;
+        for (unsigned t = 0; t < threadCount; t++) {
+            failed.insert(failed.end(), bad[t].begin(), bad[t].end());
+            bytes += read[t];
+        }
+        return failed;
+    }
+
+    // Bytes on disk: chunk pack, index and every manifest log
+    uint64_t diskBytes() const {
+        error_code code;
+        uint64_t bytes = 0;
+        for (const auto& entry : filesystem::recursive_directory_iterator(root, code)) {
+            if (entry.is_regular_file(code)) bytes += entry.file_size(code);
+        }
+        return bytes;
+    }
+};
@@ -0,0 +1,174 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <fstream>
+#include <functional>
+#include <thread>
+#include <atomic>
+#include <cmath>
+#include <ctime>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include "trace_spans.h"
+
+// Exam marks pivoted once per class into a dense student x subject x exam-type
+// cube, so rendering a card is a handful of array reads instead of a rescan
+// of every Exam's studentMarks map.
+class ExamPivot {
+private:
+    vector<string> subjects;
+    vector<string> examTypes;
+    unordered_map<string, size_t> studentRows;  // uniqueId -> row
+    vector<float> marks;                         // NaN = not recorded
+
+    static size_t indexOf(vector<string>& values, const string& value) {
+        for (size_t i = 0; i < values.size(); i++) {
+            if (values[i] == value) return i;
+        }
+        values.push_back(value);
+        return values.size() - 1;
+    }
+
+public:
+    // Unit Test / Mid Term / Final always come first so card columns are stable
+    ExamPivot() : examTypes{"Unit Test", "Mid Term", "Final"} {}
+
+    template <typename ExamRange>
+    void build(const ExamRange& exams) {
+        for (const auto& exam : exams) {
+            indexOf(subjects, exam.subject);
+            indexOf(examTypes, exam.examType.empty() ? "Unit Test" : exam.examType);
+            for (const auto& mark : exam.studentMarks) {
+                studentRows.emplace(mark.first, studentRows.size());
+            }
+        }
+
+        marks.assign(studentRows.size() * subjects.size() * examTypes.size(), NAN);
+        for (const auto& exam : exams) {
+            size_t subject = indexOf(subjects, exam.subject);
+            size_t type = indexOf(examTypes, exam.examType.empty() ? "Unit Test" : exam.examType);
+            for (const auto& mark : exam.studentMarks) {
+                marks[cell(studentRows[mark.first], subject, type)] = mark.second;
+            }
+        }
+    }
+
+    size_t cell(size_t row, size_t subject, size_t type) const {
+        return (row * subjects.size() + subject) * examTypes.size() + type;
+    }
+
+    // Returns SIZE_MAX when the student has no recorded marks
+    size_t rowFor(const string& uniqueId) const {
+        auto it = studentRows.find(uniqueId);
+        return it == studentRows.end() ? SIZE_MAX : it->second;
+    }
+
+    float mark(size_t row, size_t subject, size_t type) const {
+        return row == SIZE_MAX ? NAN : marks[cell(row, subject, type)];
+    }
+
+    const vector<string>& getSubjects() const { return subjects; }
+    const vector<string>& getExamTypes() const { return examTypes; }
+};
+
+// Minimal ustar writer used to bundle generated reports into one archive
+class TarWriter {
+private:
+    ofstream file;
+
+    static void putOctal(char* field, size_t width, unsigned long long value) {
+        snprintf(field, width, "%0*llo", (int)width - 1, value);
+    }
+
+public:
+    explicit TarWriter(const string& filepath) : file(filepath, ios::binary | ios::trunc) {}
+
+    bool isOpen() const { return file.is_open(); }
+
+    bool addFile(const string& name, const string& content) {
+        if (name.size() >= 100) return false;
+
+        char header[512] = {};
+        memcpy(header, name.data(), name.size());
+        putOctal(header + 100, 8, 0644);
+        putOctal(header + 108, 8, 0);
+        putOctal(header + 116, 8, 0);
+        putOctal(header + 124, 12, content.size());
+        putOctal(header + 136, 12, (unsigned long long)time(nullptr));
+        memset(header + 148, ' ', 8);
+        header[156] = '0';
+        memcpy(header + 257, "ustar", 6);
+        memcpy(header + 263, "00", 2);
+
+        unsigned checksum = 0;
+        for (unsigned char c : header) checksum += c;
+        snprintf(header + 148, 8, "%06o", checksum);
+
+        file.write(header, sizeof(header));
+        file.write(content.data(), content.size());
+        static const char padding[512] = {};
+        file.write(padding, (512 - content.size() % 512) % 512);
+        return file.good();
+    }
+
+    bool close() {
+        static const char endBlocks[1024] = {};
+        file.write(endBlocks, sizeof(endBlocks));
+        file.close();
+        return !file.fail();
+    }
+};
+
+// Renders count documents across worker threads. Each worker reuses one string
+// buffer; render(i, buffer) fills it and returns the document's file name.
+// When bundle is null every document is written straight to disk, otherwise
+// the documents are collected and appended to the archive in index order;
+// documents the archive rejects are counted in bundleFailures, not written.
+inline size_t renderDocumentsInParallel(size_t count,
+                                        const function<string(size_t, string&)>& render,
+                                        TarWriter* bundle = nullptr,
+                                        size_t* bundleFailures = nullptr,
+                                        unsigned threadCount = thread::hardware_concurrency()) {
+    vector<pair<string, string>> collected(bundle ? count : 0);
+    atomic<size_t> next{0};
+    atomic<size_t> written{0};
+
+    auto worker = [&]() {
+        string buffer;
+        buffer.reserve(16 * 1024);
+        for (size_t i = next++; i < count; i = next++) {
+            TRACE_SPAN("renderDocument");
+            buffer.clear();
+            string filename = render(i, buffer);
+            if (filename.empty()) continue;
+            if (bundle) {
+                collected[i] = {filename, buffer};
+            } else {
+                ofstream file(filename, ios::binary | ios::trunc);
+                file.write(buffer.data(), buffer.size());
+                if (file.good()) written++;
+            }
+        }
+    };
+
+    threadCount = max(1u, min(threadCount, (unsigned)max<size_t>(count, 1)));
+    vector<thread> workers;
+    for (unsigned t = 1; t < threadCount; t++) workers.emplace_back(worker);
+    worker();
+    for (auto& t : workers) t.join();
+
+    if (bundle) {
+        TRACE_SPAN("writeBundle");
+        size_t failed = 0;
+        for (const auto& document : collected) {
+            if (document.first.empty()) continue;
+            if (bundle->addFile(document.first, document.second)) written++;
+            else failed++;
+        }
+        if (bundleFailures) *bundleFailures = failed;
+    }
+    return written;
+}
@@ -0,0 +1,298 @@
+// Micro/macro benchmarks for the attendance system.
+//
+// Build from the repository root (the attendance_bench target):
+//   cmake -S . -B build && cmake --build build --target attendance_bench
+//
+// Usage:
+//   attendance_bench [--scales small,medium,large] [--out bench_results.json]
+//                    [--classes 1-12] [--sections N] [--students N] [--days N]
+//                    [--absence R] [--chronic F] [--remarks R] [--seed N] [--iterations N]
+//
+// Passing any school-shape option runs a single "custom" scale instead of the
+// presets. Each scale
+// generates a synthetic school in a scratch directory, then times the load,
+// save, stats, report and dashboard paths and writes the results as JSON.
+
+#define ATTENDANCE_NO_MAIN
+#include "../attendance_system.cpp"
+#include "synthetic_school.h"
+#include "bench_common.h"
+
+struct BenchmarkResult {
+    string name;
+    size_t iterations = 0;
+    double meanNs = 0, minNs = 0, p50Ns = 0, maxNs = 0;
+};
+
+struct BenchmarkScale {
+    string name;
+    SyntheticSchoolConfig config;
+    SyntheticSchoolSummary summary;
+    vector<BenchmarkResult> results;
+};
+
+struct AttendanceBenchmark {
+    static BenchmarkResult measure(const string& name, size_t iterations, const function<void()>& body) {
+        NullBuffer sink;
+        streambuf* original = cout.rdbuf(&sink);
+
+        vector<double> samples;
+        for (size_t i = 0; i < iterations; i++) {
+            auto start = chrono::steady_clock::now();
+            body();
+            samples.push_back(chrono::duration<double, nano>(chrono::steady_clock::now() - start).count());
+        }
+        cout.rdbuf(original);
+
+        sort(samples.begin(), samples.end());
+        BenchmarkResult result;
+        result.name = name;
+        result.iterations = iterations;
+        result.meanNs = accumulate(samples.begin(), samples.end(), 0.0) / samples.size();
+        result.minNs = samples.front();
+        result.p50Ns = samples[samples.size() / 2];
+        result.maxNs = samples.back();
+        cout << "  " << left << setw(34) << name << right << setw(14) << fixed << setprecision(3)
+             << result.p50Ns / 1e6 << " ms (p50 of " << iterations << ")\n";
+        return result;
+    }
+
+    static void runScale(BenchmarkScale& scale, size_t iterations) {
+        filesystem::path original = filesystem::current_path();
+        filesystem::path scratch = filesystem::temp_directory_path() / ("attendance_bench_" + scale.name);
+        filesystem::remove_all(scratch);
+        filesystem::create_directories(scratch);
+        filesystem::current_path(scratch);
+
+        cout << "\nScale '" << scale.name << "'\n";
+        scale.summary = generateSyntheticSchool(scale.config);
+        cout << "  " << scale.summary.students << " students, " << scale.summary.records << " records, "
+             << scale.summary.files << " files, " << scale.summary.bytes / 1024 << " KiB\n";
+
+        auto& results = scale.results;
+        const SyntheticSchoolConfig& config = scale.config;
+        string className = to_string((config.firstClass + config.lastClass) / 2);
+        string section = "A";
+
+        // Without a catalog, startup reads every class file and writes one
+        results.push_back(measure("loadFromFile", iterations, [&]() {
+            filesystem::remove("student_data/catalog.txt");
+            AttendanceSystem probe;
+            probe.headless = true;
+        }));
+        // With it, startup reads only the catalog
+        results.push_back(measure("startup.catalog", iterations, [&]() {
+            AttendanceSystem probe;
+            probe.headless = true;
+        }));
+
+        unique_ptr<AttendanceSystem> system = make_unique<AttendanceSystem>();
+        system->headless = true;
+        system->loadAllSections();
+
+        results.push_back(measure("loadClassData", iterations, [&]() {
+            system->evictSection(className, section);
+            system->loadClassData(className, section);
+        }));
+        results.push_back(measure("saveClassData", iterations, [&]() {
+            system->saveClassData(className, section);
+        }));
+        results.push_back(measure("saveClassData.durable", iterations, [&]() {
+            system->saveClassData(className, section);
+            system->persistence.waitFor(PartitionTracker::keyFor(className, section));
+        }));
+        results.push_back(measure("generateAttendanceStats", iterations, [&]() {
+            system->generateAttendanceStats(className, section);
+        }));
+
+        results.push_back(measure("report.html", iterations, [&]() { system->generateHTMLReport(className, section); }));
+        results.push_back(measure("report.csv", iterations, [&]() { system->generateCSVReport(className, section); }));
+        results.push_back(measure("report.detailed", iterations, [&]() { system->generateDetailedReport(className, section); }));
+        results.push_back(measure("report.classSummary", iterations, [&]() { system->generateClassSummary(className, section); }));
+        results.push_back(measure("report.monthly", iterations, [&]() { system->generateMonthlyReport(className, section); }));
+        results.push_back(measure("report.trend", iterations, [&]() { system->generateTrendAnalysis(className, section); }));
+        results.push_back(measure("report.yearHistory", iterations, [&]() { system->generateYearHistory(className, section); }));
+        results.push_back(measure("report.asOf", iterations, [&]() {
+            system->generateAsOfReport(className, section, (int64_t)time(nullptr));
+        }));
+        results.push_back(measure("report.classTeacher", iterations, [&]() { system->generateClassTeacherReport(className); }));
+        results.push_back(measure("report.progressCards.section", iterations, [&]() {
+            system->generateProgressCards(className, section);
+        }));
+        results.push_back(measure("report.progressCards.school", 1, [&]() { system->generateProgressCards("", ""); }));
+        results.push_back(measure("report.correlation", iterations, [&]() { system->generateCorrelationReport(); }));
+        results.push_back(measure("export.columnar", iterations, [&]() { system->exportColumnarData(); }));
+        results.push_back(measure("verify.dataDirectory", iterations, [&]() { system->verifyDataDirectory(); }));
+
+        volatile float sinkValue = 0;
+        results.push_back(measure("dashboard.todayPresent", iterations, [&]() { sinkValue = system->getTodayPresent(); }));
+        results.push_back(measure("dashboard.overallAttendance", iterations, [&]() { sinkValue = system->getOverallAttendance(); }));
+        results.push_back(measure("dashboard.bestClass", iterations, [&]() { sinkValue = system->getBestClass().size(); }));
+        results.push_back(measure("dashboard.weekly", iterations, [&]() { sinkValue = system->getWeeklyAttendance().size(); }));
+        results.push_back(measure("dashboard.classPerformance", iterations, [&]() {
+            sinkValue = system->getDepartmentPerformance().size();
+        }));
+        results.push_back(measure("dashboard.render", iterations, [&]() { system->showDashboard(); }));
+
+        // Typo-tolerant lookups, on this school and on 50,000 distinct random
+        // records, so posting lists are as long as a real archive's
+        const vector<string> queries = {"meera", "meeera sharma", "kapor", "4321", "12", "a"};
+        results.push_back(measure("search.school", iterations, [&]() {
+            for (const string& query : queries) sinkValue = system->searchIndex.search(query).size();
+        }));
+        SplitMix64 random(config.seed);
+        auto randomWord = [&random](size_t minLength, size_t maxLength, char first, int alphabet) {
+            string word(minLength + random.next() % (maxLength - minLength + 1), ' ');
+            for (char& c : word) c = (char)(first + random.next() % alphabet);
+            return word;
+        };
+        StudentSearchIndex historical;
+        vector<string> historicalNames;
+        for (size_t i = 0; historical.size() < 50000; i++) {
+            string name = randomWord(3, 9, 'a', 26) + " " + randomWord(3, 9, 'a', 26);
+            historical.add("h" + to_string(i), to_string(1 + i % 12), string(1, (char)('A' + i % 4)),
+                           to_string(1 + random.next() % 60), name,
+                           randomWord(3, 9, 'a', 26) + " " + randomWord(3, 9, 'a', 26), randomWord(10, 10, '0', 10));
+            if (i % 5000 == 0) historicalNames.push_back(name);
+        }
+        // One query per sample: a short prefix, a one-letter prefix, then a
+        // mix of exact names, names missing their first letter and numbers
+        vector<string> historicalQueries = {"ka", "4321", "12"};
+        for (const string& name : historicalNames) {
+            historicalQueries.push_back(name.substr(0, name.find(' ')));
+            historicalQueries.push_back(name.substr(1, min<size_t>(6, name.size() - 1)));
+        }
+        results.push_back(measure("search.historical50k.prefix", iterations, [&]() {
+            sinkValue = historical.search("btfw").size();
+        }));
+        results.push_back(measure("search.historical50k.short", iterations, [&]() {
+            sinkValue = historical.search("a").size();
+        }));
+        size_t nextQuery = 0;
+        results.push_back(measure("search.historical50k.mixed", iterations * historicalQueries.size(), [&]() {
+            sinkValue = historical.search(historicalQueries[nextQuery++ % historicalQueries.size()]).size();
+        }));
+
+        // Three years of remarks for every student: one month, then every year
+        static const char* NOTE_TEXTS[] = {"sick", "late", "medical leave", "family function", "sports meet",
+                                           "bus delay", "fever", "doctor appointment", "medical checkup"};
+        FullTextIndex notes;
+        int firstDay = dayNumberFromDate("2022-06-01");
+        uint64_t state = config.seed;
+        for (const Student& student : system->students) {
+            string owner = student.getUniqueId();
+            for (int day = firstDay; day < firstDay + 3 * 365; day++) {
+                state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+                if ((state >> 33) % 25 == 0) {
+                    notes.add(owner, TEXT_REMARK, day, NOTE_TEXTS[(state >> 40) % 9], true);
+                }
+            }
+        }
+        int marchFrom = dayNumberFromDate("2023-03-01"), marchTo = dayNumberFromDate("2023-03-31");
+        results.push_back(measure("fulltext.month", iterations, [&]() {
+            sinkValue = notes.query("medical", marchFrom, marchTo).size();
+        }));
+        results.push_back(measure("fulltext.allYears", iterations, [&]() {
+            sinkValue = notes.query("medical leave").size();
+        }));
+
+        results.push_back(measure("shutdown.saveToFile", 1, [&]() { system.reset(); }));
+
+        filesystem::current_path(original);
+        filesystem::remove_all(scratch);
+    }
+
+    static void writeJson(const string& path, const vector<BenchmarkScale>& scales) {
+        ofstream file(path);
+        file << "{\n  \"benchmark\": \"attendance_system\",\n  \"generated_at\": " << time(nullptr)
+             << ",\n  \"scales\": [\n";
+        for (size_t s = 0; s < scales.size(); s++) {
+            const BenchmarkScale& scale = scales[s];
+            const SyntheticSchoolConfig& c = scale.config;
+            file << "    {\n      \"name\": \"" << scale.name << "\",\n"
+                 << "      \"config\": {\"classes\": [" << c.firstClass << ", " << c.lastClass << "], "
+                 << "\"sections\": " << c.sectionsPerClass << ", \"studentsPerSection\": " << c.studentsPerSection
+                 << ", \"days\": " << c.schoolDays << ", \"absenceRate\": " << c.absenceRate
+                 << ", \"chronicFraction\": " << c.chronicFraction << ", \"remarkRate\": " << c.remarkRate
+                 << ", \"seed\": " << c.seed << "},\n"
+                 << "      \"students\": " << scale.summary.students << ", \"records\": " << scale.summary.records
+                 << ", \"bytes\": " << scale.summary.bytes << ",\n      \"results\": [\n";
+            for (size_t r = 0; r < scale.results.size(); r++) {
+                const BenchmarkResult& result = scale.results[r];
+                file << "        {\"name\": \"" << result.name << "\", \"iterations\": " << result.iterations
+                     << fixed << setprecision(0) << ", \"mean_ns\": " << result.meanNs
+                     << ", \"min_ns\": " << result.minNs << ", \"p50_ns\": " << result.p50Ns
+                     << ", \"max_ns\": " << result.maxNs << "}" << (r + 1 < scale.results.size() ? "," : "") << "\n";
+                file << defaultfloat;
+            }
+            file << "      ]\n    }" << (s + 1 < scales.size() ? "," : "") << "\n";
+        }
+        file << "  ]\n}\n";
+    }
+};
+
+int main(int argc, char** argv) {
+    map<string, SyntheticSchoolConfig> presets;
+    presets["small"].sectionsPerClass = 2;
+    presets["small"].studentsPerSection = 30;
+    presets["small"].schoolDays = 60;
+    presets["medium"].sectionsPerClass = 3;
+    presets["medium"].studentsPerSection = 40;
+    presets["medium"].schoolDays = 120;
+    presets["large"].sectionsPerClass = 6;
+    presets["large"].studentsPerSection = 45;
+    presets["large"].schoolDays = 200;
+
+    string scaleList = "small,medium,large";
+    string outPath = "bench_results.json";
+    size_t iterations = 5;
+    SyntheticSchoolConfig custom;
+    bool useCustom = false;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        string flag = argv[i], value = argv[i + 1];
+        if (flag == "--scales") scaleList = value;
+        else if (flag == "--out") outPath = value;
+        else if (flag == "--iterations") iterations = max(1, stoi(value));
+        else {
+            useCustom = true;
+            if (flag == "--classes") {
+                custom.firstClass = stoi(value);
+                custom.lastClass = value.find('-') == string::npos ? custom.firstClass
+                                                                   : stoi(value.substr(value.find('-') + 1));
+            }
+            else if (flag == "--sections") custom.sectionsPerClass = stoi(value);
+            else if (flag == "--students") custom.studentsPerSection = stoi(value);
+            else if (flag == "--days") custom.schoolDays = stoi(value);
+            else if (flag == "--absence") custom.absenceRate = stod(value);
+            else if (flag == "--chronic") custom.chronicFraction = stod(value);
+            else if (flag == "--remarks") custom.remarkRate = stod(value);
+            else if (flag == "--seed") custom.seed = stoull(value);
+            else {
+                cerr << "Unknown option: " << flag << "\n";
+                return 1;
+            }
+        }
+    }
+
+    vector<BenchmarkScale> scales;
+    stringstream names(useCustom ? "custom" : scaleList);
+    string name;
+    while (getline(names, name, ',')) {
+        if (name == "custom") {
+            scales.push_back({name, custom, {}, {}});
+        } else if (presets.count(name)) {
+            scales.push_back({name, presets[name], {}, {}});
+        } else {
+            cerr << "Unknown scale: " << name << "\n";
+            return 1;
+        }
+    }
+
+    for (auto& scale : scales) {
+        AttendanceBenchmark::runScale(scale, iterations);
+    }
+    AttendanceBenchmark::writeJson(outPath, scales);
+    cout << "\nResults written to " << outPath << "\n";
+    return 0;
+}
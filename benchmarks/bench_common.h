@@ -0,0 +1,92 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <streambuf>
+#include <cstdint>
+#include <cmath>
+#include <bit>
+#ifdef _WIN32
+#include <psapi.h>  // GetProcessMemoryInfo, link with -lpsapi
+#else
+#include <unistd.h>
+#endif
+
+// Helpers shared by the benchmark and the load harness.
+
+// Discards console output from the code under test
+class NullBuffer : public streambuf {
+protected:
+    int overflow(int c) override { return c; }
+    streamsize xsputn(const char*, streamsize n) override { return n; }
+};
+
+// Log-linear latency histogram: 16 linear sub-buckets per power of two, so
+// any recorded value is reported within ~6% while using a fixed 1 KiB table.
+class LatencyHistogram {
+private:
+    static const int SUB_BUCKETS = 16;
+    static const int MAGNITUDES = 48;
+    uint64_t buckets[MAGNITUDES * SUB_BUCKETS] = {};
+    uint64_t total = 0;
+    uint64_t maxValue = 0;
+
+    static int indexOf(uint64_t value) {
+        if (value < SUB_BUCKETS) return (int)value;
+        int magnitude = 63 - std::countl_zero(value);          // >= 4
+        int sub = (int)((value >> (magnitude - 4)) & (SUB_BUCKETS - 1));
+        int index = (magnitude - 3) * SUB_BUCKETS + sub;
+        return min(index, MAGNITUDES * SUB_BUCKETS - 1);
+    }
+
+    static uint64_t upperBound(int index) {
+        if (index < SUB_BUCKETS) return (uint64_t)index;
+        int magnitude = index / SUB_BUCKETS + 3;
+        uint64_t sub = (uint64_t)(index % SUB_BUCKETS);
+        return ((SUB_BUCKETS + sub + 1) << (magnitude - 4)) - 1;
+    }
+
+public:
+    void record(uint64_t nanoseconds) {
+        buckets[indexOf(nanoseconds)]++;
+        total++;
+        maxValue = std::max(maxValue, nanoseconds);
+    }
+
+    void merge(const LatencyHistogram& other) {
+        for (int i = 0; i < MAGNITUDES * SUB_BUCKETS; i++) buckets[i] += other.buckets[i];
+        total += other.total;
+        maxValue = std::max(maxValue, other.maxValue);
+    }
+
+    uint64_t count() const { return total; }
+    uint64_t maximum() const { return maxValue; }
+
+    // q in [0, 1]; returns the upper edge of the bucket holding that quantile
+    uint64_t quantile(double q) const {
+        if (total == 0) return 0;
+        uint64_t rank = (uint64_t)ceil(q * total);
+        uint64_t seen = 0;
+        for (int i = 0; i < MAGNITUDES * SUB_BUCKETS; i++) {
+            seen += buckets[i];
+            if (seen >= rank && buckets[i]) return std::min(upperBound(i), maxValue);
+        }
+        return maxValue;
+    }
+};
+
+inline uint64_t residentSetBytes() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return counters.WorkingSetSize;
+    }
+    return 0;
+#else
+    long pages = 0, resident = 0;
+    FILE* statm = fopen("/proc/self/statm", "r");
+    if (!statm) return 0;
+    if (fscanf(statm, "%ld %ld", &pages, &resident) != 2) resident = 0;
+    fclose(statm);
+    return (uint64_t)resident * (uint64_t)sysconf(_SC_PAGESIZE);
+#endif
+}
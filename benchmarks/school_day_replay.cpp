@@ -0,0 +1,265 @@
+// School-day replay soak harness.
+//
+// Build from the repository root (the school_day_replay target):
+//   cmake -S . -B build && cmake --build build --target school_day_replay
+//
+// Usage:
+//   school_day_replay [--days 200] [--teachers N] [--sections 3] [--students 40]
+//                     [--reports 20] [--broadcast-every 10] [--seed 42] [--out replay_results.json]
+//
+// Generates a roster without history, then replays an academic year one school
+// day at a time. Each morning N simulated teachers mark their sections through
+// markSectionAttendance (the same path as the interactive markAttendance) while
+// a report client issues report and dashboard requests, and notification
+// broadcasts go out on a fixed cadence. The application is not thread-safe, so
+// every call holds one process-wide lock; latencies are measured from the
+// caller's side and include time spent waiting for it.
+//
+// Per day it records latency percentiles, RSS, the estimated model size from
+// takeMemorySnapshot, files/bytes written and the sizes of the in-memory
+// collections that are known to grow (students, systemLogs, notificationList).
+
+#define ATTENDANCE_NO_MAIN
+#include "../attendance_system.cpp"
+#include "synthetic_school.h"
+#include "bench_common.h"
+#include <mutex>
+
+enum ReplayOperation { OP_MARK, OP_REPORT, OP_DASHBOARD, OP_BROADCAST, OP_COUNT };
+const char* REPLAY_OPERATION_NAMES[OP_COUNT] = {"mark_section", "report", "dashboard", "broadcast"};
+
+struct ReplayConfig {
+    SyntheticSchoolConfig school;
+    int days = 200;
+    int teachers = 0;           // 0 = one per section
+    int reportsPerDay = 20;
+    int broadcastEvery = 10;
+    string outPath = "replay_results.json";
+};
+
+struct SchoolDayReplay {
+    ReplayConfig config;
+    AttendanceSystem* system = nullptr;
+    mutex systemLock;
+
+    struct FileState {
+        uintmax_t size;
+        filesystem::file_time_type written;
+    };
+
+    static map<string, FileState> scanFiles(const filesystem::path& root) {
+        map<string, FileState> files;
+        error_code ec;
+        for (auto it = filesystem::recursive_directory_iterator(root, ec);
+             it != filesystem::recursive_directory_iterator(); it.increment(ec)) {
+            if (ec) break;
+            if (it->is_regular_file(ec)) {
+                files[it->path().string()] = {it->file_size(ec), it->last_write_time(ec)};
+            }
+        }
+        return files;
+    }
+
+    template <typename Body>
+    uint64_t timed(Body body) {
+        auto start = chrono::steady_clock::now();
+        {
+            lock_guard<mutex> guard(systemLock);
+            body();
+        }
+        return (uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+    }
+
+    static void writeHistogram(ostream& out, const LatencyHistogram& histogram) {
+        out << "{\"count\": " << histogram.count()
+            << ", \"p50_us\": " << histogram.quantile(0.50) / 1000.0
+            << ", \"p99_us\": " << histogram.quantile(0.99) / 1000.0
+            << ", \"p999_us\": " << histogram.quantile(0.999) / 1000.0
+            << ", \"max_us\": " << histogram.maximum() / 1000.0 << "}";
+    }
+
+    int run() {
+        filesystem::path original = filesystem::current_path();
+        filesystem::path scratch = filesystem::temp_directory_path() / "attendance_school_day_replay";
+        filesystem::remove_all(scratch);
+        filesystem::create_directories(scratch);
+        filesystem::current_path(scratch);
+
+        SyntheticSchoolConfig roster = config.school;
+        roster.schoolDays = 0;
+        SyntheticSchoolSummary summary = generateSyntheticSchool(roster);
+
+        vector<pair<string, string>> sections;
+        for (int c = roster.firstClass; c <= roster.lastClass; c++) {
+            for (int s = 0; s < roster.sectionsPerClass; s++) {
+                sections.push_back({to_string(c), string(1, (char)('A' + s))});
+            }
+        }
+        int teacherCount = config.teachers > 0 ? config.teachers : (int)sections.size();
+
+        vector<string> dates;
+        for (int day = dayNumberFromDate(roster.startDate); (int)dates.size() < config.days; day++) {
+            int weekday = weekdayFromDayNumber(day);
+            if (weekday != 0 && weekday != 6) dates.push_back(dateFromDayNumber(day));
+        }
+
+        ofstream out(original / config.outPath);
+        out << fixed << setprecision(1);
+        out << "{\n  \"config\": {\"days\": " << config.days << ", \"teachers\": " << teacherCount
+            << ", \"sections\": " << sections.size() << ", \"students\": " << summary.students
+            << ", \"reportsPerDay\": " << config.reportsPerDay << ", \"broadcastEvery\": " << config.broadcastEvery
+            << ", \"seed\": " << roster.seed << "},\n  \"days\": [\n";
+
+        cerr << "Replaying " << dates.size() << " days, " << sections.size() << " sections, "
+             << summary.students << " students, " << teacherCount << " teachers\n";
+
+        NullBuffer sink;
+        streambuf* console = cout.rdbuf(&sink);
+
+        AttendanceSystem instance;
+        instance.headless = true;
+        system = &instance;
+
+        LatencyHistogram overall[OP_COUNT];
+        uint64_t startRss = residentSetBytes();
+        map<string, FileState> previousFiles = scanFiles(scratch);
+
+        for (size_t d = 0; d < dates.size(); d++) {
+            const string& date = dates[d];
+            vector<LatencyHistogram> teacherHistograms(teacherCount);
+            LatencyHistogram clientHistograms[OP_COUNT];
+            atomic<size_t> marks{0};
+
+            vector<thread> teachers;
+            for (int t = 0; t < teacherCount; t++) {
+                teachers.emplace_back([&, t]() {
+                    SplitMix64 rng(roster.seed ^ ((uint64_t)d << 20) ^ (uint64_t)t);
+                    for (size_t s = t; s < sections.size(); s += teacherCount) {
+                        size_t marked = 0;
+                        uint64_t latency = timed([&]() {
+                            marked = system->markSectionAttendance(sections[s].first, sections[s].second, date,
+                                [&](const Student&, string& remark) {
+                                    if (rng.uniform() < roster.remarkRate) remark = "late";
+                                    return rng.uniform() >= roster.absenceRate;
+                                });
+                        });
+                        teacherHistograms[t].record(latency);
+                        marks += marked;
+                    }
+                });
+            }
+
+            thread client([&]() {
+                SplitMix64 rng(roster.seed ^ 0xC11E57ULL ^ d);
+                for (int r = 0; r < config.reportsPerDay; r++) {
+                    const auto& target = sections[rng.below(sections.size())];
+                    switch (rng.below(4)) {
+                        case 0:
+                            clientHistograms[OP_REPORT].record(timed([&]() {
+                                system->generateCSVReport(target.first, target.second);
+                            }));
+                            break;
+                        case 1:
+                            clientHistograms[OP_REPORT].record(timed([&]() {
+                                system->generateDetailedReport(target.first, target.second);
+                            }));
+                            break;
+                        case 2:
+                            clientHistograms[OP_REPORT].record(timed([&]() {
+                                system->generateMonthlyReport(target.first, target.second);
+                            }));
+                            break;
+                        default:
+                            clientHistograms[OP_DASHBOARD].record(timed([&]() { system->showDashboard(); }));
+                    }
+                    this_thread::yield();
+                }
+            });
+
+            if (config.broadcastEvery > 0 && d % config.broadcastEvery == 0) {
+                clientHistograms[OP_BROADCAST].record(timed([&]() {
+                    system->broadcastMessage("School notice for " + date);
+                }));
+            }
+
+            for (auto& teacher : teachers) teacher.join();
+            client.join();
+
+            LatencyHistogram dayMarks;
+            for (const auto& histogram : teacherHistograms) dayMarks.merge(histogram);
+            overall[OP_MARK].merge(dayMarks);
+            for (int op = OP_REPORT; op < OP_COUNT; op++) overall[op].merge(clientHistograms[op]);
+
+            system->persistence.flush();  // count the day's background saves
+            map<string, FileState> files = scanFiles(scratch);
+            size_t filesWritten = 0;
+            uintmax_t bytesWritten = 0;
+            for (const auto& file : files) {
+                auto before = previousFiles.find(file.first);
+                if (before == previousFiles.end() || before->second.written != file.second.written) {
+                    filesWritten++;
+                    bytesWritten += file.second.size;
+                }
+            }
+            previousFiles.swap(files);
+
+            out << "    {\"day\": " << d + 1 << ", \"date\": \"" << date << "\", \"marks\": " << marks.load()
+                << ", \"mark\": ";
+            writeHistogram(out, dayMarks);
+            out << ", \"report\": ";
+            writeHistogram(out, clientHistograms[OP_REPORT]);
+            MemorySnapshot memory = system->takeMemorySnapshot(date);
+            out << ", \"rss_bytes\": " << residentSetBytes() << ", \"model_bytes\": " << memory.total().total()
+                << ", \"duplicate_students\": " << memory.duplicateStudents << ", \"files_written\": " << filesWritten
+                << ", \"bytes_written\": " << bytesWritten << ", \"files_total\": " << previousFiles.size()
+                << ", \"students\": " << system->students.size()
+                << ", \"system_logs\": " << system->systemLogs.size()
+                << ", \"notifications\": " << system->notificationList.size() << "}"
+                << (d + 1 < dates.size() ? "," : "") << "\n";
+
+            cerr << "\rday " << d + 1 << "/" << dates.size() << "  mark p99 "
+                 << dayMarks.quantile(0.99) / 1000 << " us  students " << system->students.size() << "   " << flush;
+        }
+
+        uint64_t endRss = residentSetBytes();
+        out << "  ],\n  \"summary\": {";
+        for (int op = 0; op < OP_COUNT; op++) {
+            out << (op ? ", " : "") << "\"" << REPLAY_OPERATION_NAMES[op] << "\": ";
+            writeHistogram(out, overall[op]);
+        }
+        out << ", \"rss_start_bytes\": " << startRss << ", \"rss_end_bytes\": " << endRss
+            << ", \"rss_growth_bytes\": " << (int64_t)(endRss - startRss) << "}\n}\n";
+
+        system = nullptr;
+        cout.rdbuf(console);
+        cerr << "\nResults written to " << (original / config.outPath).string() << "\n";
+
+        filesystem::current_path(original);
+        filesystem::remove_all(scratch);
+        return 0;
+    }
+};
+
+int main(int argc, char** argv) {
+    SchoolDayReplay replay;
+    ReplayConfig& config = replay.config;
+    config.school.sectionsPerClass = 3;
+    config.school.studentsPerSection = 40;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        string flag = argv[i], value = argv[i + 1];
+        if (flag == "--days") config.days = stoi(value);
+        else if (flag == "--teachers") config.teachers = stoi(value);
+        else if (flag == "--sections") config.school.sectionsPerClass = stoi(value);
+        else if (flag == "--students") config.school.studentsPerSection = stoi(value);
+        else if (flag == "--reports") config.reportsPerDay = stoi(value);
+        else if (flag == "--broadcast-every") config.broadcastEvery = stoi(value);
+        else if (flag == "--seed") config.school.seed = stoull(value);
+        else if (flag == "--out") config.outPath = value;
+        else {
+            cerr << "Unknown option: " << flag << "\n";
+            return 1;
+        }
+    }
+    return replay.run();
+}
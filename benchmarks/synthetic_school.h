@@ -0,0 +1,126 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <fstream>
+#include <filesystem>
+#include <cstdint>
+#include "../date_utils.h"
+
+// Deterministic synthetic school written in the student_data/<folder>/class_N_S.csv
+// layout used by saveClassData. Uses its own PRNG so the same seed produces
+// byte-identical files on every platform and standard library.
+
+struct SyntheticSchoolConfig {
+    int firstClass = 1;
+    int lastClass = 12;
+    int sectionsPerClass = 3;
+    int studentsPerSection = 40;
+    int schoolDays = 120;              // weekdays starting at startDate
+    string startDate = "2024-06-03";
+    double absenceRate = 0.07;         // typical student
+    double chronicFraction = 0.08;     // share of students with chronic absence
+    double chronicAbsenceRate = 0.30;
+    double remarkRate = 0.04;          // share of records carrying a remark
+    uint64_t seed = 42;
+};
+
+class SplitMix64 {
+private:
+    uint64_t state;
+
+public:
+    explicit SplitMix64(uint64_t seed) : state(seed) {}
+
+    uint64_t next() {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    double uniform() { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+    size_t below(size_t n) { return (size_t)(next() % n); }
+};
+
+inline string syntheticSectionFolder(int classNum) {
+    if (classNum <= 3) return "primary";
+    if (classNum <= 5) return "upper_primary";
+    if (classNum <= 8) return "midschool";
+    if (classNum <= 10) return "high_school";
+    return "higher_secondary";
+}
+
+struct SyntheticSchoolSummary {
+    size_t students = 0;
+    size_t records = 0;
+    size_t files = 0;
+    uint64_t bytes = 0;
+};
+
+// Writes one file per class-section under baseDir and returns what was written
+inline SyntheticSchoolSummary generateSyntheticSchool(const SyntheticSchoolConfig& config,
+                                                      const string& baseDir = "student_data") {
+    static const char* FIRST_NAMES[] = {"Aarav", "Diya", "Kabir", "Meera", "Rohan", "Ananya", "Ishaan",
+                                        "Saanvi", "Vivaan", "Aisha", "Arjun", "Kavya", "Reyansh", "Tara"};
+    static const char* LAST_NAMES[] = {"Sharma", "Patel", "Iyer", "Khan", "Reddy", "Das", "Gupta",
+                                       "Nair", "Singh", "Mehta", "Rao", "Bose"};
+    static const char* REMARKS[] = {"sick", "late", "medical leave", "family function", "sports meet",
+                                    "bus delay", "fever", "doctor appointment"};
+    static const char* GENDERS[] = {"M", "F", "O"};
+
+    SplitMix64 rng(config.seed);
+    SyntheticSchoolSummary summary;
+
+    vector<string> dates;
+    for (int day = dayNumberFromDate(config.startDate); (int)dates.size() < config.schoolDays; day++) {
+        int weekday = weekdayFromDayNumber(day);
+        if (weekday != 0 && weekday != 6) dates.push_back(dateFromDayNumber(day));
+    }
+
+    for (int classNum = config.firstClass; classNum <= config.lastClass; classNum++) {
+        string folder = baseDir + "/" + syntheticSectionFolder(classNum);
+        filesystem::create_directories(folder);
+
+        for (int s = 0; s < config.sectionsPerClass; s++) {
+            string section(1, (char)('A' + s));
+            string path = folder + "/class_" + to_string(classNum) + "_" + section + ".csv";
+            ofstream file(path, ios::binary | ios::trunc);
+            file << "version:1.0,date:" << (dates.empty() ? config.startDate : dates.back()) << "\n";
+            file << "Roll No,Name,Section,Contact,Email,Gender,DOB,AttendanceData,Remarks\n";
+
+            string row;
+            for (int roll = 1; roll <= config.studentsPerSection; roll++) {
+                string first = FIRST_NAMES[rng.below(sizeof(FIRST_NAMES) / sizeof(*FIRST_NAMES))];
+                string last = LAST_NAMES[rng.below(sizeof(LAST_NAMES) / sizeof(*LAST_NAMES))];
+                string contact = to_string(9000000000ULL + rng.below(999999999));
+                int birthYear = 2019 - classNum;
+                string dob = dateFromDayNumber(dayNumberFromCivil(birthYear, 1, 1) + (int)rng.below(365));
+                double absence = rng.uniform() < config.chronicFraction ? config.chronicAbsenceRate
+                                                                        : config.absenceRate;
+
+                row.clear();
+                row += to_string(roll) + "," + first + " " + last + "," + section + "," + contact + ",";
+                for (char c : first) row += (char)tolower(c);
+                row += "." + to_string(classNum) + section + to_string(roll) + "@school.edu,";
+                row += string(GENDERS[rng.below(10) < 9 ? rng.below(2) : 2]) + "," + dob + ",";
+
+                for (const auto& date : dates) {
+                    row += date;
+                    row += rng.uniform() < absence ? ":0" : ":1";
+                    if (rng.uniform() < config.remarkRate) {
+                        row += ":";
+                        row += REMARKS[rng.below(sizeof(REMARKS) / sizeof(*REMARKS))];
+                    }
+                    row += ";";
+                }
+                row += "\n";
+                file << row;
+                summary.bytes += row.size();
+                summary.records += dates.size();
+                summary.students++;
+            }
+            summary.files++;
+        }
+    }
+    return summary;
+}
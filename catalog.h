@@ -0,0 +1,157 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstdlib>
+#include <cstdint>
+#include "crc32c.h"
+
+// Startup catalog of the class files: one line per partition (class-section)
+// with its path, student count, date range, save generation, the CRC-32C of
+// the file and the summary counters the dashboard needs. Startup reads this
+// one file instead of parsing every class file, so the menu appears in the
+// same time whatever the size of the school; a section's file is parsed on
+// first access.
+//
+// The catalog is rewritten after each section save, so after a crash it may
+// be ahead of or behind a class file. Loading a section compares the file's
+// checksum with its entry and corrects the entry when they differ; verify
+// reports every file that does not match.
+//
+// File format:
+//   catalog:2
+//   partition:<class>,<section>,<path>,<students>,<first date>,<last date>,
+//             <generation>,<crc32c hex>,<percent sum>,<date>=<present>;...
+// (one line per partition). The dates are empty for a section with no
+// attendance, and the trailing list holds the last CATALOG_RECENT_DATES
+// recorded dates, oldest first. A version 1 catalog (FNV-1a checksums) is
+// not read; startup rebuilds it from the class files.
+
+const int CATALOG_VERSION = 2;
+const size_t CATALOG_RECENT_DATES = 7;
+
+struct CatalogEntry {
+    string className;
+    string section;
+    string path;
+    uint32_t students = 0;
+    string firstDate;         // earliest attendance date in the file
+    string lastDate;          // latest attendance date in the file
+    uint64_t generation = 0;  // saves of this partition since its entry was created
+    uint32_t checksum = 0;    // CRC-32C of the class file as last written or read
+    double percentSum = 0;    // sum of the students' attendance percentages
+    vector<pair<string, uint32_t>> recent;  // students present on each of the last recorded dates
+};
+
+class SchoolCatalog {
+private:
+    map<string, CatalogEntry> entries;  // by partition key, e.g. "5-A"
+    bool changed = false;
+
+    static vector<string> split(const string& text, char separator) {
+        vector<string> fields;
+        string field;
+        istringstream in(text);
+        while (getline(in, field, separator)) fields.push_back(field);
+        if (!text.empty() && text.back() == separator) fields.push_back("");
+        return fields;
+    }
+
+public:
+    static string keyFor(const string& className, const string& section) { return className + "-" + section; }
+
+    // Reads the catalog; false when it is missing, unreadable or from another
+    // version, in which case the caller scans the class files instead
+    bool load(const string& path) {
+        entries.clear();
+        changed = false;
+        ifstream in(path);
+        string line;
+        if (!in.is_open() || !getline(in, line) || line != "catalog:" + to_string(CATALOG_VERSION)) return false;
+
+        while (getline(in, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (!line.starts_with("partition:")) continue;
+            vector<string> fields = split(line.substr(10), ',');
+            if (fields.size() < 9) return false;
+            CatalogEntry entry;
+            entry.className = fields[0];
+            entry.section = fields[1];
+            entry.path = fields[2];
+            entry.students = (uint32_t)strtoul(fields[3].c_str(), nullptr, 10);
+            entry.firstDate = fields[4];
+            entry.lastDate = fields[5];
+            entry.generation = strtoull(fields[6].c_str(), nullptr, 10);
+            entry.checksum = (uint32_t)strtoul(fields[7].c_str(), nullptr, 16);
+            entry.percentSum = strtod(fields[8].c_str(), nullptr);
+            if (fields.size() > 9) {
+                for (const string& day : split(fields[9], ';')) {
+                    size_t equals = day.find('=');
+                    if (equals == string::npos) continue;
+                    entry.recent.push_back({day.substr(0, equals),
+                                            (uint32_t)strtoul(day.c_str() + equals + 1, nullptr, 10)});
+                }
+            }
+            entries[keyFor(entry.className, entry.section)] = move(entry);
+        }
+        return true;
+    }
+
+    string render() const {
+        ostringstream out;
+        out << "catalog:" << CATALOG_VERSION << "\n";
+        for (const auto& item : entries) {
+            const CatalogEntry& entry = item.second;
+            out << "partition:" << entry.className << "," << entry.section << "," << entry.path << ","
+                << entry.students << "," << entry.firstDate << "," << entry.lastDate << ","
+                << entry.generation << "," << crc32cHex(entry.checksum) << "," << fixed << setprecision(4) << entry.percentSum << ",";
+            for (size_t i = 0; i < entry.recent.size(); i++) {
+                if (i > 0) out << ";";
+                out << entry.recent[i].first << "=" << entry.recent[i].second;
+            }
+            out << "\n";
+        }
+        return out.str();
+    }
+
+    const CatalogEntry* find(const string& className, const string& section) const {
+        auto it = entries.find(keyFor(className, section));
+        return it == entries.end() ? nullptr : &it->second;
+    }
+
+    // Replaces a partition's entry, keeping its generation count
+    void update(CatalogEntry entry, bool saved) {
+        CatalogEntry& current = entries[keyFor(entry.className, entry.section)];
+        entry.generation = current.generation + (saved ? 1 : 0);
+        current = move(entry);
+        changed = true;
+    }
+
+    // True once since the last call if an entry changed, so the caller rewrites the file
+    bool takeChanged() {
+        bool was = changed;
+        changed = false;
+        return was;
+    }
+
+    const map<string, CatalogEntry>& all() const { return entries; }
+
+    // Students present on a date, answered from the summary alone: nobody
+    // after the last recorded date or on an unrecorded date inside the
+    // recent window. False when the date is older than the window.
+    static bool presentOn(const CatalogEntry& entry, const string& date, uint32_t& present) {
+        present = 0;
+        if (entry.lastDate.empty() || date > entry.lastDate || date < entry.firstDate) return true;
+        for (const auto& day : entry.recent) {
+            if (day.first == date) {
+                present = day.second;
+                return true;
+            }
+        }
+        return !entry.recent.empty() && date > entry.recent.front().first;
+    }
+};
@@ -0,0 +1,397 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <fstream>
+#include <functional>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <cstdint>
+#include <utility>
+#include "varint.h"
+#include "trace_spans.h"
+
+// Columnar analytics export ("SACF" - school attendance columnar file).
+//
+// One row per attendance record. Each class-section becomes a row group that
+// is encoded independently (and in parallel); every column of a row group is
+// a separate chunk so readers only fetch the columns they need.
+//
+// Layout:
+//   "SACF" u32 version
+//   row group column chunks ...
+//   footer: varint rowGroupCount, then per row group
+//           name, rowCount, COLUMN_COUNT x (offset u64, length u64)
+//   u64 footerOffset, "SACF"
+//
+// Column encodings:
+//   STUDENT_DICT / REMARK_DICT  varint count + length-prefixed strings
+//   STUDENT_ID                  (value, runLength) varint pairs
+//   DAY_NUMBER                  zigzag varint delta from previous row
+//   PRESENT                     first bit, then alternating varint run lengths
+//   REMARK_ID                   (value, runLength) varint pairs, 0 = no remark
+//
+// The writer reads every file back with ColumnarReader and compares each row
+// group with what it encoded, so an export that would not decode is reported
+// instead of handed to a BI tool.
+
+const char COLUMNAR_MAGIC[4] = {'S', 'A', 'C', 'F'};
+const uint32_t COLUMNAR_VERSION = 1;
+
+enum ColumnarColumn {
+    COLUMN_STUDENT_DICT = 0,
+    COLUMN_REMARK_DICT,
+    COLUMN_STUDENT_ID,
+    COLUMN_DAY_NUMBER,
+    COLUMN_PRESENT,
+    COLUMN_REMARK_ID,
+    COLUMN_COUNT
+};
+
+// One row group, decoded: the dictionaries and one entry per row in each column
+struct ColumnarRows {
+    std::vector<std::string> studentDict;
+    std::vector<std::string> remarkDict{""};  // id 0 is "no remark"
+    std::vector<uint32_t> studentIds;
+    std::vector<int32_t> dayNumbers;
+    std::vector<uint8_t> present;
+    std::vector<uint32_t> remarkIds;
+
+    bool operator==(const ColumnarRows&) const = default;
+};
+
+class ColumnarRowGroupBuilder {
+private:
+    ColumnarRows rows;
+    std::unordered_map<std::string, uint32_t> remarkIds{{"", 0}};
+
+    static void encodeRuns(std::string& out, const std::vector<uint32_t>& values) {
+        for (size_t i = 0; i < values.size();) {
+            size_t j = i + 1;
+            while (j < values.size() && values[j] == values[i]) j++;
+            putVarint(out, values[i]);
+            putVarint(out, j - i);
+            i = j;
+        }
+    }
+
+    static void encodeDictionary(std::string& out, const std::vector<std::string>& dict) {
+        putVarint(out, dict.size());
+        for (const auto& value : dict) putLengthPrefixed(out, value);
+    }
+
+public:
+    // Starts a new student; subsequent rows belong to it until the next call.
+    void beginStudent(const std::string& studentKey) {
+        rows.studentDict.push_back(studentKey);
+    }
+
+    void addRow(int dayNumber, bool present, const std::string& remark) {
+        uint32_t remarkId = 0;
+        if (!remark.empty()) {
+            auto it = remarkIds.find(remark);
+            if (it == remarkIds.end()) {
+                remarkId = (uint32_t)rows.remarkDict.size();
+                rows.remarkDict.push_back(remark);
+                remarkIds.emplace(remark, remarkId);
+            } else {
+                remarkId = it->second;
+            }
+        }
+        rows.studentIds.push_back((uint32_t)rows.studentDict.size() - 1);
+        rows.dayNumbers.push_back(dayNumber);
+        rows.present.push_back(present ? 1 : 0);
+        rows.remarkIds.push_back(remarkId);
+    }
+
+    size_t rowCount() const { return rows.studentIds.size(); }
+
+    // Hands over the rows added so far, leaving the builder empty
+    ColumnarRows takeRows() { return std::move(rows); }
+
+    void encode(std::string chunks[COLUMN_COUNT]) const {
+        encodeDictionary(chunks[COLUMN_STUDENT_DICT], rows.studentDict);
+        encodeDictionary(chunks[COLUMN_REMARK_DICT], rows.remarkDict);
+        encodeRuns(chunks[COLUMN_STUDENT_ID], rows.studentIds);
+        encodeRuns(chunks[COLUMN_REMARK_ID], rows.remarkIds);
+
+        int32_t previousDay = 0;
+        for (int32_t day : rows.dayNumbers) {
+            putSignedVarint(chunks[COLUMN_DAY_NUMBER], (int64_t)day - previousDay);
+            previousDay = day;
+        }
+
+        const std::vector<uint8_t>& bits = rows.present;
+        std::string& present = chunks[COLUMN_PRESENT];
+        if (!bits.empty()) {
+            present.push_back((char)bits[0]);
+            for (size_t i = 0; i < bits.size();) {
+                size_t j = i + 1;
+                while (j < bits.size() && bits[j] == bits[i]) j++;
+                putVarint(present, j - i);
+                i = j;
+            }
+        }
+    }
+};
+
+struct ColumnarRowGroupInfo {
+    std::string name;
+    uint64_t rowCount = 0;
+    uint64_t offsets[COLUMN_COUNT] = {};
+    uint64_t lengths[COLUMN_COUNT] = {};
+};
+
+// Reads the footer on open, then decodes row groups on demand. Every chunk
+// must lie before the footer and every run must fit in its group's row
+// count, so a damaged file is rejected rather than decoded into garbage.
+class ColumnarReader {
+private:
+    mutable std::ifstream file;
+    std::vector<ColumnarRowGroupInfo> groups;
+
+    bool readChunk(size_t group, ColumnarColumn column, std::string& out) const {
+        out.resize((size_t)groups[group].lengths[column]);
+        file.clear();
+        file.seekg((std::streamoff)groups[group].offsets[column]);
+        file.read(out.data(), (std::streamsize)out.size());
+        return (size_t)file.gcount() == out.size();
+    }
+
+    bool decodeDictionary(size_t group, ColumnarColumn column, std::vector<std::string>& dict) const {
+        std::string chunk;
+        if (!readChunk(group, column, chunk)) return false;
+        const char* pos = chunk.data();
+        const char* end = pos + chunk.size();
+        uint64_t count;
+        if (!getVarint(pos, end, count) || count > (uint64_t)(end - pos)) return false;  // each entry takes a byte
+        dict.assign((size_t)count, std::string());
+        for (auto& value : dict) {
+            if (!getLengthPrefixed(pos, end, value)) return false;
+        }
+        return pos == end;
+    }
+
+    bool decodeRuns(size_t group, ColumnarColumn column, std::vector<uint32_t>& values, size_t limit) const {
+        std::string chunk;
+        if (!readChunk(group, column, chunk)) return false;
+        uint64_t rowCount = groups[group].rowCount;
+        values.clear();
+        values.reserve((size_t)rowCount);
+        const char* pos = chunk.data();
+        const char* end = pos + chunk.size();
+        while (pos < end) {
+            uint64_t value, run;
+            if (!getVarint(pos, end, value) || !getVarint(pos, end, run)) return false;
+            if (value >= limit || run == 0 || run > rowCount - values.size()) return false;
+            values.insert(values.end(), (size_t)run, (uint32_t)value);
+        }
+        return values.size() == rowCount;
+    }
+
+    bool decodeDayNumbers(size_t group, std::vector<int32_t>& values) const {
+        std::string chunk;
+        if (!readChunk(group, COLUMN_DAY_NUMBER, chunk)) return false;
+        uint64_t rowCount = groups[group].rowCount;
+        values.clear();
+        values.reserve((size_t)rowCount);
+        const char* pos = chunk.data();
+        const char* end = pos + chunk.size();
+        int64_t day = 0, delta;
+        while (pos < end) {
+            if (values.size() == rowCount || !getSignedVarint(pos, end, delta)) return false;
+            day += delta;
+            if (day < INT32_MIN || day > INT32_MAX) return false;
+            values.push_back((int32_t)day);
+        }
+        return values.size() == rowCount;
+    }
+
+    bool decodePresent(size_t group, std::vector<uint8_t>& values) const {
+        std::string chunk;
+        if (!readChunk(group, COLUMN_PRESENT, chunk)) return false;
+        uint64_t rowCount = groups[group].rowCount;
+        values.clear();
+        values.reserve((size_t)rowCount);
+        if (chunk.empty()) return rowCount == 0;
+        if ((uint8_t)chunk[0] > 1) return false;
+        const char* pos = chunk.data() + 1;
+        const char* end = chunk.data() + chunk.size();
+        uint8_t bit = (uint8_t)chunk[0];
+        while (pos < end) {
+            uint64_t run;
+            if (!getVarint(pos, end, run) || run == 0 || run > rowCount - values.size()) return false;
+            values.insert(values.end(), (size_t)run, bit);
+            bit ^= 1;
+        }
+        return values.size() == rowCount;
+    }
+
+public:
+    bool open(const std::string& filepath, std::string& error) {
+        groups.clear();
+        file.close();
+        file.clear();
+        file.open(filepath, std::ios::binary);
+        error = "Not a readable columnar export: " + filepath;
+        if (!file.is_open()) return false;
+        file.seekg(0, std::ios::end);
+        std::streamoff size = file.tellg();
+        if (size < 20) return false;
+
+        char trailer[12];
+        file.seekg(size - 12);
+        file.read(trailer, 12);
+        if (!file || memcmp(trailer + 8, COLUMNAR_MAGIC, 4) != 0) return false;
+        uint64_t footerOffset = getFixed64(trailer);
+        if (footerOffset < 8 || footerOffset > (uint64_t)size - 12) return false;
+
+        std::string footer((size_t)((uint64_t)size - 12 - footerOffset), '\0');
+        file.seekg((std::streamoff)footerOffset);
+        file.read(footer.data(), (std::streamsize)footer.size());
+        if (!file) return false;
+
+        const char* pos = footer.data();
+        const char* end = pos + footer.size();
+        std::vector<ColumnarRowGroupInfo> found;
+        uint64_t groupCount;
+        if (!getVarint(pos, end, groupCount)) return false;
+        for (uint64_t g = 0; g < groupCount; g++) {
+            ColumnarRowGroupInfo info;
+            if (!getLengthPrefixed(pos, end, info.name) || !getVarint(pos, end, info.rowCount)) return false;
+            if (end - pos < 16 * COLUMN_COUNT) return false;
+            for (int c = 0; c < COLUMN_COUNT; c++) {
+                info.offsets[c] = getFixed64(pos);
+                info.lengths[c] = getFixed64(pos + 8);
+                pos += 16;
+                if (info.offsets[c] < 8 || info.offsets[c] > footerOffset ||
+                    info.lengths[c] > footerOffset - info.offsets[c]) {
+                    return false;
+                }
+            }
+            if (info.rowCount > info.lengths[COLUMN_DAY_NUMBER]) return false;  // each row takes a delta byte
+            found.push_back(info);
+        }
+        if (pos != end) return false;
+        groups = std::move(found);
+        error.clear();
+        return true;
+    }
+
+    const std::vector<ColumnarRowGroupInfo>& rowGroups() const { return groups; }
+
+    bool readRowGroup(size_t group, ColumnarRows& rows) const {
+        if (group >= groups.size()) return false;
+        return decodeDictionary(group, COLUMN_STUDENT_DICT, rows.studentDict) &&
+               decodeDictionary(group, COLUMN_REMARK_DICT, rows.remarkDict) &&
+               decodeRuns(group, COLUMN_STUDENT_ID, rows.studentIds, rows.studentDict.size()) &&
+               decodeRuns(group, COLUMN_REMARK_ID, rows.remarkIds, rows.remarkDict.size()) &&
+               decodeDayNumbers(group, rows.dayNumbers) && decodePresent(group, rows.present);
+    }
+};
+
+struct ColumnarPartitionSource {
+    std::string name;  // e.g. "5_A"
+    std::function<void(ColumnarRowGroupBuilder&)> fill;
+};
+
+class ColumnarWriter {
+private:
+    struct EncodedGroup {
+        std::string chunks[COLUMN_COUNT];
+        ColumnarRows rows;
+    };
+
+public:
+    // Encodes every partition on its own worker thread, writes the row
+    // groups in input order, then reads the file back and checks each group
+    // decodes to the rows that went in. Returns the number of bytes written;
+    // on failure returns 0, sets error and removes the file.
+    static size_t write(const std::string& filepath, const std::vector<ColumnarPartitionSource>& partitions,
+                        std::string& error, unsigned threadCount = std::thread::hardware_concurrency()) {
+        std::vector<EncodedGroup> groups(partitions.size());
+
+        std::atomic<size_t> next{0};
+        auto worker = [&]() {
+            for (size_t i = next++; i < partitions.size(); i = next++) {
+                TRACE_SPAN_DETAIL("encodeRowGroup", partitions[i].name);
+                ColumnarRowGroupBuilder builder;
+                partitions[i].fill(builder);
+                builder.encode(groups[i].chunks);
+                groups[i].rows = builder.takeRows();
+            }
+        };
+
+        threadCount = std::max(1u, std::min(threadCount, (unsigned)partitions.size()));
+        std::vector<std::thread> workers;
+        for (unsigned t = 1; t < threadCount; t++) workers.emplace_back(worker);
+        worker();
+        for (auto& t : workers) t.join();
+
+        size_t written = writeGroups(filepath, partitions, groups);
+        if (written == 0) {
+            error = "Could not write columnar export: " + filepath;
+        } else if (!readsBack(filepath, partitions, groups, error)) {
+            written = 0;
+        }
+        if (written == 0) ::remove(filepath.c_str());
+        return written;
+    }
+
+private:
+    static size_t writeGroups(const std::string& filepath, const std::vector<ColumnarPartitionSource>& partitions,
+                              const std::vector<EncodedGroup>& groups) {
+        TRACE_SPAN("writeColumnarFile");
+        std::ofstream file(filepath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) return 0;
+
+        std::string header(COLUMNAR_MAGIC, 4);
+        putFixed32(header, COLUMNAR_VERSION);
+        file.write(header.data(), header.size());
+        uint64_t offset = header.size();
+
+        std::string footer;
+        putVarint(footer, groups.size());
+        for (size_t i = 0; i < groups.size(); i++) {
+            putLengthPrefixed(footer, partitions[i].name);
+            putVarint(footer, groups[i].rows.studentIds.size());
+            for (int c = 0; c < COLUMN_COUNT; c++) {
+                const std::string& chunk = groups[i].chunks[c];
+                file.write(chunk.data(), chunk.size());
+                putFixed64(footer, offset);
+                putFixed64(footer, chunk.size());
+                offset += chunk.size();
+            }
+        }
+        putFixed64(footer, offset);
+        footer.append(COLUMNAR_MAGIC, 4);
+        file.write(footer.data(), footer.size());
+        file.close();
+
+        return file.good() ? (size_t)(offset + footer.size()) : 0;
+    }
+
+    static bool readsBack(const std::string& filepath, const std::vector<ColumnarPartitionSource>& partitions,
+                          const std::vector<EncodedGroup>& groups, std::string& error) {
+        TRACE_SPAN("verifyColumnarFile");
+        ColumnarReader reader;
+        if (!reader.open(filepath, error)) return false;
+        if (reader.rowGroups().size() != groups.size()) {
+            error = "Columnar export lists the wrong number of row groups: " + filepath;
+            return false;
+        }
+        for (size_t i = 0; i < groups.size(); i++) {
+            ColumnarRows rows;
+            if (reader.rowGroups()[i].name != partitions[i].name || !reader.readRowGroup(i, rows) ||
+                rows != groups[i].rows) {
+                error = "Columnar export row group " + partitions[i].name + " did not read back: " + filepath;
+                return false;
+            }
+        }
+        return true;
+    }
+};
@@ -0,0 +1,176 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <functional>
+#include <thread>
+#include <atomic>
+#include <cmath>
+#include <ostream>
+#include <iomanip>
+#include <cstdint>
+#include "trace_spans.h"
+
+// Attendance-vs-performance statistics built from mergeable moment sums, so
+// partitions can be scanned independently and combined in any order.
+
+const int ATTENDANCE_BIN_COUNT = 10;  // 0-10%, 10-20%, ... 90-100%
+
+struct CorrelationAccumulator {
+    uint64_t n = 0;
+    double sumX = 0, sumY = 0, sumXX = 0, sumYY = 0, sumXY = 0;
+    uint64_t binCount[ATTENDANCE_BIN_COUNT] = {};
+    double binScoreSum[ATTENDANCE_BIN_COUNT] = {};
+
+    // x = attendance percentage, y = score percentage
+    void add(double x, double y) {
+        n++;
+        sumX += x; sumY += y;
+        sumXX += x * x; sumYY += y * y; sumXY += x * y;
+        int bin = min(ATTENDANCE_BIN_COUNT - 1, max(0, (int)(x / (100.0 / ATTENDANCE_BIN_COUNT))));
+        binCount[bin]++;
+        binScoreSum[bin] += y;
+    }
+
+    void merge(const CorrelationAccumulator& other) {
+        n += other.n;
+        sumX += other.sumX; sumY += other.sumY;
+        sumXX += other.sumXX; sumYY += other.sumYY; sumXY += other.sumXY;
+        for (int i = 0; i < ATTENDANCE_BIN_COUNT; i++) {
+            binCount[i] += other.binCount[i];
+            binScoreSum[i] += other.binScoreSum[i];
+        }
+    }
+
+    double covariance() const { return n ? sumXY / n - (sumX / n) * (sumY / n) : 0; }
+    double varianceX() const { return n ? sumXX / n - (sumX / n) * (sumX / n) : 0; }
+    double varianceY() const { return n ? sumYY / n - (sumY / n) * (sumY / n) : 0; }
+
+    // Pearson r; NaN when either side has no spread
+    double correlation() const {
+        double denominator = sqrt(varianceX() * varianceY());
+        return denominator > 1e-12 ? covariance() / denominator : NAN;
+    }
+
+    // Least-squares score = slope * attendance + intercept
+    double slope() const {
+        double vx = varianceX();
+        return vx > 1e-12 ? covariance() / vx : NAN;
+    }
+
+    double intercept() const {
+        double s = slope();
+        return isnan(s) ? NAN : sumY / n - s * (sumX / n);
+    }
+
+    double binAverage(int bin) const {
+        return binCount[bin] ? binScoreSum[bin] / binCount[bin] : NAN;
+    }
+};
+
+using CorrelationResults = map<string, CorrelationAccumulator>;
+using CorrelationEmit = function<void(const string& key, double attendance, double score)>;
+
+// Runs scan(partition, emit) for every partition on a pool of workers. Each
+// worker accumulates into its own map; the maps are merged once at the end.
+inline CorrelationResults runCorrelationJob(size_t partitionCount,
+                                            const function<void(size_t, const CorrelationEmit&)>& scan,
+                                            unsigned threadCount = thread::hardware_concurrency()) {
+    threadCount = max(1u, min(threadCount, (unsigned)max<size_t>(partitionCount, 1)));
+    vector<unordered_map<string, CorrelationAccumulator>> local(threadCount);
+    atomic<size_t> next{0};
+
+    auto worker = [&](unsigned id) {
+        auto& results = local[id];
+        CorrelationEmit emit = [&results](const string& key, double attendance, double score) {
+            results[key].add(attendance, score);
+        };
+        for (size_t i = next++; i < partitionCount; i = next++) {
+            TRACE_SPAN("correlationScan");
+            scan(i, emit);
+        }
+    };
+
+    vector<thread> workers;
+    for (unsigned t = 1; t < threadCount; t++) workers.emplace_back(worker, t);
+    worker(0);
+    for (auto& t : workers) t.join();
+
+    CorrelationResults merged;
+    for (const auto& results : local) {
+        for (const auto& entry : results) merged[entry.first].merge(entry.second);
+    }
+    return merged;
+}
+
+// Keys are '/'-separated paths ("school", "class/5", "class/5/Math"); keyPrefix
+// selects one path and everything below it, "" selects everything.
+inline bool correlationKeyMatches(const string& key, const string& keyPrefix) {
+    if (keyPrefix.empty()) return true;
+    return key.compare(0, keyPrefix.size(), keyPrefix) == 0 &&
+           (key.size() == keyPrefix.size() || key[keyPrefix.size()] == '/');
+}
+
+inline void writeCorrelationSection(ostream& out, const CorrelationResults& results, const string& keyPrefix = "") {
+    out << "\nAttendance vs Performance:\n";
+    out << string(30, '-') << "\n";
+    bool any = false;
+    for (const auto& entry : results) {
+        if (!correlationKeyMatches(entry.first, keyPrefix)) continue;
+        const CorrelationAccumulator& acc = entry.second;
+        any = true;
+        out << entry.first << " (" << acc.n << " students)\n"
+            << "  Correlation: " << fixed << setprecision(3) << acc.correlation() << "\n"
+            << "  Slope: " << setprecision(3) << acc.slope() << " score points per attendance point\n"
+            << "  Intercept: " << setprecision(2) << acc.intercept() << "\n"
+            << "  Average score by attendance band:\n";
+        for (int bin = 0; bin < ATTENDANCE_BIN_COUNT; bin++) {
+            if (!acc.binCount[bin]) continue;
+            int low = bin * (100 / ATTENDANCE_BIN_COUNT);
+            out << "    " << setw(3) << low << "-" << setw(3) << low + 100 / ATTENDANCE_BIN_COUNT << "%: "
+                << setprecision(2) << acc.binAverage(bin) << "% (" << acc.binCount[bin] << ")\n";
+        }
+    }
+    if (!any) out << "No students with both attendance and marks.\n";
+}
+
+inline void writeCorrelationJson(ostream& out, const CorrelationResults& results) {
+    auto number = [&out](double value) {
+        if (isnan(value)) out << "null";
+        else out << value;
+    };
+    auto quoted = [&out](const string& value) {
+        out << '"';
+        for (char c : value) {
+            if (c == '"' || c == '\\') out << '\\' << c;
+            else if ((unsigned char)c < 0x20) out << "\\u" << hex << setw(4) << setfill('0') << (int)c
+                                                  << dec << setfill(' ');
+            else out << c;
+        }
+        out << '"';
+    };
+
+    out << defaultfloat << setprecision(6) << "{\n";
+    bool first = true;
+    for (const auto& entry : results) {
+        const CorrelationAccumulator& acc = entry.second;
+        out << (first ? "" : ",\n") << "  ";
+        first = false;
+        quoted(entry.first);
+        out << ": {\"n\": " << acc.n << ", \"correlation\": ";
+        number(acc.correlation());
+        out << ", \"slope\": ";
+        number(acc.slope());
+        out << ", \"intercept\": ";
+        number(acc.intercept());
+        out << ", \"bins\": [";
+        for (int bin = 0; bin < ATTENDANCE_BIN_COUNT; bin++) {
+            out << (bin ? ", " : "") << "{\"count\": " << acc.binCount[bin] << ", \"avgScore\": ";
+            number(acc.binAverage(bin));
+            out << "}";
+        }
+        out << "]}";
+    }
+    out << "\n}\n";
+}
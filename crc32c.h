@@ -0,0 +1,128 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#if defined(__x86_64__) || defined(_M_X64)
+#define CRC32C_X86 1
+#include <nmmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// CRC-32C (Castagnoli), the checksum the catalog keeps for every class file
+// and `verify` recomputes. x86-64 CPUs with SSE4.2 compute it with the crc32
+// instruction, eight bytes at a time; everything else uses slicing-by-8
+// tables. Both give the same value, so a file checksummed on one machine
+// verifies on another.
+
+const uint32_t CRC32C_POLY = 0x82F63B78;  // reflected Castagnoli polynomial
+
+// values[k][b]: CRC of byte b followed by k zero bytes
+struct Crc32cTable {
+    uint32_t values[8][256];
+    constexpr Crc32cTable() : values() {
+        for (uint32_t b = 0; b < 256; b++) {
+            uint32_t crc = b;
+            for (int bit = 0; bit < 8; bit++) crc = (crc >> 1) ^ (CRC32C_POLY & (0u - (crc & 1)));
+            values[0][b] = crc;
+        }
+        for (uint32_t b = 0; b < 256; b++) {
+            for (int k = 1; k < 8; k++) values[k][b] = (values[k - 1][b] >> 8) ^ values[0][values[k - 1][b] & 0xFF];
+        }
+    }
+};
+inline constexpr Crc32cTable CRC32C_TABLE;
+
+// Runs on the inverted CRC, like the hardware instruction
+inline uint32_t crc32cSoftware(uint32_t crc, const unsigned char* bytes, size_t length) {
+    const auto& t = CRC32C_TABLE.values;
+    while (length >= 8) {
+        uint32_t low, high;
+        memcpy(&low, bytes, 4);
+        memcpy(&high, bytes + 4, 4);
+        low ^= crc;  // little-endian, as on every platform the app targets
+        crc = t[7][low & 0xFF] ^ t[6][(low >> 8) & 0xFF] ^ t[5][(low >> 16) & 0xFF] ^ t[4][low >> 24] ^
+              t[3][high & 0xFF] ^ t[2][(high >> 8) & 0xFF] ^ t[1][(high >> 16) & 0xFF] ^ t[0][high >> 24];
+        bytes += 8;
+        length -= 8;
+    }
+    while (length-- > 0) crc = (crc >> 8) ^ t[0][(crc ^ *bytes++) & 0xFF];
+    return crc;
+}
+
+#ifdef CRC32C_X86
+#ifndef _MSC_VER
+__attribute__((target("sse4.2")))
+#endif
+inline uint32_t crc32cHardware(uint32_t crc, const unsigned char* bytes, size_t length) {
+    uint64_t wide = crc;
+    while (length >= 8) {
+        uint64_t word;
+        memcpy(&word, bytes, 8);
+        wide = _mm_crc32_u64(wide, word);
+        bytes += 8;
+        length -= 8;
+    }
+    crc = (uint32_t)wide;
+    while (length-- > 0) crc = _mm_crc32_u8(crc, *bytes++);
+    return crc;
+}
+
+inline bool detectCrc32cHardware() {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 20)) != 0;
+#else
+    return __builtin_cpu_supports("sse4.2");
+#endif
+}
+#endif
+
+// True when crc32c() uses the CPU instruction
+inline bool crc32cAccelerated() {
+#ifdef CRC32C_X86
+    static const bool available = detectCrc32cHardware();
+    return available;
+#else
+    return false;
+#endif
+}
+
+// CRC-32C of bytes; pass a previous result as crc to continue it over more bytes
+inline uint32_t crc32c(string_view bytes, uint32_t crc = 0) {
+    const unsigned char* data = (const unsigned char*)bytes.data();
+    crc = ~crc;
+#ifdef CRC32C_X86
+    if (crc32cAccelerated()) return ~crc32cHardware(crc, data, bytes.size());
+#endif
+    return ~crc32cSoftware(crc, data, bytes.size());
+}
+
+inline string crc32cHex(uint32_t crc) {
+    char text[9];
+    snprintf(text, sizeof(text), "%08x", (unsigned)crc);
+    return text;
+}
+
+// CRC-32C of a whole file, streamed through buffer so any size fits in
+// memory; false when the file cannot be read
+inline bool crc32cOfFile(const string& path, string& buffer, uint32_t& crc, uint64_t& bytes) {
+    const size_t BLOCK = 1 << 20;
+    FILE* in = fopen(path.c_str(), "rb");
+    if (!in) return false;
+    buffer.resize(BLOCK);
+    crc = 0;
+    bytes = 0;
+    size_t got;
+    while ((got = fread(buffer.data(), 1, BLOCK, in)) > 0) {
+        crc = crc32c(string_view(buffer.data(), got), crc);
+        bytes += got;
+    }
+    bool ok = !ferror(in);
+    fclose(in);
+    return ok;
+}
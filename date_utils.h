@@ -0,0 +1,52 @@
+#pragma once
+#include <string>
+#include <cstdio>
+#include <climits>
+
+// Day numbers are days since 1970-01-01 (proleptic Gregorian), so date
+// arithmetic and range filters become integer comparisons.
+const int INVALID_DAY = INT_MIN;
+
+inline int dayNumberFromCivil(int year, int month, int day) {
+    year -= month <= 2;
+    const int era = (year >= 0 ? year : year - 399) / 400;
+    const unsigned yoe = (unsigned)(year - era * 400);
+    const unsigned doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (int)doe - 719468;
+}
+
+inline int dayNumberFromDate(const std::string& date) {
+    int year, month, day;
+    if (date.length() < 10 || sscanf(date.c_str(), "%d-%d-%d", &year, &month, &day) != 3) {
+        return INVALID_DAY;
+    }
+    if (month < 1 || month > 12 || day < 1 || day > 31) return INVALID_DAY;
+    return dayNumberFromCivil(year, month, day);
+}
+
+inline void civilFromDayNumber(int dayNumber, int& year, int& month, int& day) {
+    int z = dayNumber + 719468;
+    const int era = (z >= 0 ? z : z - 146096) / 146097;
+    const unsigned doe = (unsigned)(z - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    day = (int)(doy - (153 * mp + 2) / 5 + 1);
+    month = (int)(mp < 10 ? mp + 3 : mp - 9);
+    year = (int)yoe + era * 400 + (month <= 2);
+}
+
+inline std::string dateFromDayNumber(int dayNumber) {
+    int year, month, day;
+    civilFromDayNumber(dayNumber, year, month, day);
+
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%04d-%02d-%02d", year, month, day);
+    return std::string(buffer);
+}
+
+// 0 = Sunday ... 6 = Saturday
+inline int weekdayFromDayNumber(int dayNumber) {
+    return dayNumber >= -4 ? (dayNumber + 4) % 7 : (dayNumber + 5) % 7 + 6;
+}
@@ -0,0 +1,136 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdio>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Crash-safe file replacement. A file is written to "<path>.tmp", synced to
+// the device and renamed over the target, so after a crash or power loss the
+// target holds either its old or its new contents, never a torn mix. The
+// rename becomes durable once its directory is synced; a caller replacing
+// many files syncs each directory once per commit group rather than once
+// per file.
+//
+// That batching applies to POSIX only. Windows cannot sync a directory
+// without administrator rights, so every rename there is MOVEFILE_WRITE_THROUGH
+// and waits on its own; a commit group saves nothing and syncDirectory does
+// no work (DIRECTORY_SYNC is false).
+
+#ifdef _WIN32
+const bool DIRECTORY_SYNC = false;
+#else
+const bool DIRECTORY_SYNC = true;
+#endif
+
+const char* const TEMP_FILE_SUFFIX = ".tmp";
+
+// Writes content to path's temp file and waits until it is on the device
+inline bool writeDurableTemp(const string& path, string_view content, string& error) {
+    string temp = path + TEMP_FILE_SUFFIX;
+    FILE* out = fopen(temp.c_str(), "wb");
+    if (!out) {
+        error = "Could not open file: " + temp;
+        return false;
+    }
+    bool ok = fwrite(content.data(), 1, content.size(), out) == content.size() && fflush(out) == 0;
+#ifdef _WIN32
+    ok = ok && _commit(_fileno(out)) == 0;
+#else
+    ok = ok && fsync(fileno(out)) == 0;
+#endif
+    ok = fclose(out) == 0 && ok;
+    if (!ok) {
+        error = "Could not write file: " + temp;
+        ::remove(temp.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Appends bytes to path and waits until they are on the device. An append
+// cut short by a crash leaves a torn tail, which the file's reader trims.
+inline bool appendDurable(const string& path, string_view bytes, string& error) {
+    FILE* out = fopen(path.c_str(), "ab");
+    if (!out) {
+        error = "Could not open file: " + path;
+        return false;
+    }
+    bool ok = fwrite(bytes.data(), 1, bytes.size(), out) == bytes.size() && fflush(out) == 0;
+#ifdef _WIN32
+    ok = ok && _commit(_fileno(out)) == 0;
+#else
+    ok = ok && fsync(fileno(out)) == 0;
+#endif
+    ok = fclose(out) == 0 && ok;
+    if (!ok) {
+        error = "Could not append to file: " + path;
+        return false;
+    }
+    return true;
+}
+
+// Atomically replaces path with a synced file written next to it
+inline bool replaceWithSynced(const string& synced, const string& path, string& error) {
+#ifdef _WIN32
+    if (!MoveFileExA(synced.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+        error = "Could not replace " + path + " (error " + to_string(GetLastError()) + ")";
+        return false;
+    }
+#else
+    if (::rename(synced.c_str(), path.c_str()) != 0) {
+        error = "Could not replace " + path + ": " + strerror(errno);
+        return false;
+    }
+#endif
+    return true;
+}
+
+// Atomically replaces path with its synced temp file
+inline bool commitDurableTemp(const string& path, string& error) {
+    return replaceWithSynced(path + TEMP_FILE_SUFFIX, path, error);
+}
+
+// Makes the renames into a directory durable. A no-op on Windows, where
+// MOVEFILE_WRITE_THROUGH has already waited for each rename.
+inline bool syncDirectory(const string& directory) {
+#ifdef _WIN32
+    (void)directory;
+    return true;
+#else
+    int fd = ::open(directory.empty() ? "." : directory.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd < 0) return false;
+    bool ok = fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+#endif
+}
+
+// Startup recovery: deletes the temp files of writes a crash interrupted.
+// The rename never happened, so each target still holds its last committed
+// contents. Returns the paths removed.
+inline vector<string> removeInterruptedWrites(const string& root) {
+    vector<string> found, removed;
+    error_code code;
+    string suffix = TEMP_FILE_SUFFIX;
+    for (auto it = filesystem::recursive_directory_iterator(root, code);
+         !code && it != filesystem::recursive_directory_iterator(); it.increment(code)) {
+        error_code entryCode;
+        string path = it->path().string();
+        if (it->is_regular_file(entryCode) && path.ends_with(suffix)) found.push_back(path);
+    }
+    for (const string& path : found) {
+        error_code removeCode;
+        if (filesystem::remove(path, removeCode)) removed.push_back(path);
+    }
+    return removed;
+}
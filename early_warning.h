@@ -0,0 +1,162 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <bit>
+#include "date_utils.h"
+
+// Chronic-absence early warning. Every student carries a few bytes of sliding
+// window state that is updated in O(1) per mark, so rules never rescan the
+// attendance history.
+
+enum WarningRuleKind {
+    RULE_ROLLING_RATE_BELOW,      // last `window` school days below `threshold` percent
+    RULE_CONSECUTIVE_ABSENCES,    // `count` absences in a row
+    RULE_ABSENT_EVERY_WEEKDAY     // absent on every `weekday` marked so far this month (at least `count`)
+};
+
+struct WarningRule {
+    WarningRuleKind kind;
+    int window = 20;
+    float threshold = 75;
+    int count = 3;
+    int weekday = 1;              // 0 = Sunday
+    bool setsProbation = false;
+    string description;
+};
+
+inline vector<WarningRule> defaultWarningRules() {
+    vector<WarningRule> rules(4);
+    rules[0].kind = RULE_ROLLING_RATE_BELOW;
+    rules[0].window = 20;
+    rules[0].threshold = 75;
+    rules[0].description = "attendance over the last 20 school days is below 75%";
+
+    rules[1].kind = RULE_ROLLING_RATE_BELOW;
+    rules[1].window = 20;
+    rules[1].threshold = 60;
+    rules[1].setsProbation = true;
+    rules[1].description = "attendance over the last 20 school days is below 60%";
+
+    rules[2].kind = RULE_CONSECUTIVE_ABSENCES;
+    rules[2].count = 3;
+    rules[2].description = "absent 3 school days in a row";
+
+    rules[3].kind = RULE_ABSENT_EVERY_WEEKDAY;
+    rules[3].weekday = 1;
+    rules[3].count = 2;
+    rules[3].description = "absent every Monday this month";
+    return rules;
+}
+
+const int MAX_WARNING_WINDOW = 64;
+
+struct AttendanceWindowState {
+    int lastDay = INVALID_DAY;
+    uint64_t history = 0;         // bit i = present on the i-th most recent marked day
+    uint8_t marked = 0;           // valid bits in history, saturates at MAX_WARNING_WINDOW
+    uint16_t consecutiveAbsences = 0;
+    int month = -1;               // year * 12 + month of the weekday counters
+    uint8_t weekdayMarked[7] = {};
+    uint8_t weekdayAbsent[7] = {};
+    uint32_t activeRules = 0;     // bit per rule currently in the firing state
+
+    bool operator==(const AttendanceWindowState&) const = default;
+};
+
+class EarlyWarningEngine {
+private:
+    vector<WarningRule> rules;
+
+    static int monthOf(int day) {
+        int year, month, dayOfMonth;
+        civilFromDayNumber(day, year, month, dayOfMonth);
+        return year * 12 + month;
+    }
+
+    bool isActive(const WarningRule& rule, const AttendanceWindowState& state, int weekday) const {
+        switch (rule.kind) {
+            case RULE_ROLLING_RATE_BELOW: {
+                if (state.marked < rule.window) return false;
+                uint64_t mask = rule.window >= 64 ? ~0ULL : ((1ULL << rule.window) - 1);
+                int present = std::popcount(state.history & mask);
+                return present * 100.0f < rule.threshold * rule.window;
+            }
+            case RULE_CONSECUTIVE_ABSENCES:
+                return state.consecutiveAbsences >= rule.count;
+            case RULE_ABSENT_EVERY_WEEKDAY:
+                return weekday == rule.weekday &&
+                       state.weekdayMarked[weekday] >= rule.count &&
+                       state.weekdayAbsent[weekday] == state.weekdayMarked[weekday];
+        }
+        return false;
+    }
+
+public:
+    explicit EarlyWarningEngine(vector<WarningRule> ruleSet = defaultWarningRules())
+        : rules(move(ruleSet)) {
+        if (rules.size() > 32) rules.resize(32);
+        for (auto& rule : rules) rule.window = min(max(rule.window, 1), MAX_WARNING_WINDOW);
+    }
+
+    const vector<WarningRule>& getRules() const { return rules; }
+
+    // Returns false when the mark is not the newest one for the student (a
+    // correction or backfill); the caller must then rebuild the state from
+    // the full record. fired receives the indexes of rules that just became
+    // active; the every-weekday rule re-arms on the next month.
+    bool observe(AttendanceWindowState& state, int day, bool present, vector<int>& fired) const {
+        if (day == INVALID_DAY || (state.lastDay != INVALID_DAY && day <= state.lastDay)) return false;
+        state.lastDay = day;
+
+        state.history = (state.history << 1) | (present ? 1 : 0);
+        if (state.marked < MAX_WARNING_WINDOW) state.marked++;
+        state.consecutiveAbsences = present ? 0 : state.consecutiveAbsences + 1;
+
+        int month = monthOf(day);
+        if (month != state.month) {
+            state.month = month;
+            for (int i = 0; i < 7; i++) state.weekdayMarked[i] = state.weekdayAbsent[i] = 0;
+            for (size_t r = 0; r < rules.size(); r++) {
+                if (rules[r].kind == RULE_ABSENT_EVERY_WEEKDAY) state.activeRules &= ~(1u << r);
+            }
+        }
+        int weekday = weekdayFromDayNumber(day);
+        state.weekdayMarked[weekday]++;
+        if (!present) state.weekdayAbsent[weekday]++;
+
+        for (size_t r = 0; r < rules.size(); r++) {
+            const WarningRule& rule = rules[r];
+            uint32_t bit = 1u << r;
+            if (rule.kind == RULE_ABSENT_EVERY_WEEKDAY) {
+                // Only re-evaluated on its own weekday; a present mark on that day clears it
+                if (weekday != rule.weekday) continue;
+                if (present) { state.activeRules &= ~bit; continue; }
+            }
+            bool active = isActive(rule, state, weekday);
+            if (active && !(state.activeRules & bit)) fired.push_back((int)r);
+            if (active) state.activeRules |= bit;
+            else state.activeRules &= ~bit;
+        }
+        return true;
+    }
+
+    bool onProbation(const AttendanceWindowState& state) const {
+        for (size_t r = 0; r < rules.size(); r++) {
+            if (rules[r].setsProbation && (state.activeRules & (1u << r))) return true;
+        }
+        return false;
+    }
+
+    // Replays a chronologically ordered record (date -> present) from scratch.
+    // Returns how many rule firings the replay produced.
+    template <typename Record>
+    int rebuild(AttendanceWindowState& state, const Record& record) const {
+        state = AttendanceWindowState();
+        vector<int> fired;
+        for (const auto& entry : record) {
+            observe(state, dayNumberFromDate(entry.first), entry.second, fired);
+        }
+        return (int)fired.size();
+    }
+};
@@ -0,0 +1,249 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <cstdint>
+#include "varint.h"
+#include "string_pool.h"
+
+// Inverted index over the free text recorded about students: attendance
+// remarks, behavior notes, teacher remarks and parent-meeting feedback.
+// Every recorded text is an occurrence (owner, source, day, text); each word
+// maps to a posting list of occurrence ids. A list is partitioned into
+// 32-day buckets of the day number, and each bucket holds blocks of
+// delta-varint ids that carry their own day range. A query for one month
+// decodes only that month's buckets, however the occurrences were loaded.
+//
+// Occurrences are only appended. Text that replaces an earlier entry for the
+// same owner, source and day (a corrected remark, a rewritten note) retires
+// the earlier occurrence instead of editing its postings.
+
+enum TextSource { TEXT_REMARK, TEXT_BEHAVIOR, TEXT_TEACHER, TEXT_MEETING, TEXT_SOURCE_COUNT };
+
+const char* const TEXT_SOURCE_NAMES[TEXT_SOURCE_COUNT] = {"remark", "behavior note", "teacher remark",
+                                                          "meeting feedback"};
+const unsigned ALL_TEXT_SOURCES = (1u << TEXT_SOURCE_COUNT) - 1;
+const size_t POSTING_BLOCK_IDS = 128;
+
+struct TextOccurrence {
+    uint32_t ownerId;  // pooled student unique id (or roll no when no student matched)
+    uint32_t textId;   // pooled text
+    int32_t day;
+    uint8_t source;
+    bool live;
+};
+
+class PostingList {
+private:
+    struct Block {
+        uint32_t firstId;
+        uint32_t lastId;
+        int32_t minDay;
+        int32_t maxDay;
+        uint32_t count;
+        string deltas;  // varint gaps after firstId
+    };
+
+    struct Partition {
+        int32_t bucket;
+        vector<Block> blocks;
+    };
+
+    vector<Partition> partitions;  // ascending bucket
+    size_t total = 0;
+
+    const Partition* find(int32_t bucket) const {
+        auto it = lower_bound(partitions.begin(), partitions.end(), bucket,
+                              [](const Partition& partition, int32_t b) { return partition.bucket < b; });
+        return (it != partitions.end() && it->bucket == bucket) ? &*it : nullptr;
+    }
+
+public:
+    static int32_t bucketOf(int32_t day) { return day >> 5; }
+
+    // Ids must be appended in ascending order
+    void append(uint32_t id, int32_t day) {
+        int32_t bucket = bucketOf(day);
+        auto it = partitions.end();
+        if (partitions.empty() || partitions.back().bucket != bucket) {
+            it = lower_bound(partitions.begin(), partitions.end(), bucket,
+                             [](const Partition& partition, int32_t b) { return partition.bucket < b; });
+            if (it == partitions.end() || it->bucket != bucket) it = partitions.insert(it, Partition{bucket, {}});
+        } else {
+            it = partitions.end() - 1;
+        }
+
+        vector<Block>& blocks = it->blocks;
+        if (blocks.empty() || blocks.back().count == POSTING_BLOCK_IDS) {
+            blocks.push_back({id, id, day, day, 1, string()});
+        } else {
+            Block& block = blocks.back();
+            putVarint(block.deltas, id - block.lastId);
+            block.lastId = id;
+            block.minDay = min(block.minDay, day);
+            block.maxDay = max(block.maxDay, day);
+            block.count++;
+        }
+        total++;
+    }
+
+    // Calls visit(bucket) for each non-empty bucket overlapping [fromDay, toDay]
+    template <typename Visit>
+    void forEachBucket(int32_t fromDay, int32_t toDay, Visit&& visit) const {
+        auto it = lower_bound(partitions.begin(), partitions.end(), bucketOf(fromDay),
+                              [](const Partition& partition, int32_t b) { return partition.bucket < b; });
+        for (; it != partitions.end() && it->bucket <= bucketOf(toDay); ++it) visit(it->bucket);
+    }
+
+    // Appends, in ascending order, the ids of one bucket's blocks that overlap
+    // [fromDay, toDay]; the caller checks each occurrence's own day
+    void collect(int32_t bucket, int32_t fromDay, int32_t toDay, vector<uint32_t>& out) const {
+        const Partition* partition = find(bucket);
+        if (!partition) return;
+        for (const Block& block : partition->blocks) {
+            if (block.maxDay < fromDay || block.minDay > toDay) continue;
+            uint32_t id = block.firstId;
+            out.push_back(id);
+            const char* pos = block.deltas.data();
+            const char* end = pos + block.deltas.size();
+            uint64_t gap;
+            while (pos < end && getVarint(pos, end, gap)) {
+                id += (uint32_t)gap;
+                out.push_back(id);
+            }
+        }
+    }
+
+    size_t size() const { return total; }
+
+    size_t memoryBytes() const {
+        size_t bytes = partitions.capacity() * sizeof(Partition);
+        for (const Partition& partition : partitions) {
+            bytes += partition.blocks.capacity() * sizeof(Block);
+            for (const Block& block : partition.blocks) {
+                if (block.deltas.capacity() >= sizeof(string)) bytes += block.deltas.capacity() + 1;
+            }
+        }
+        return bytes;
+    }
+};
+
+class FullTextIndex {
+private:
+    vector<TextOccurrence> occurrences;
+    unordered_map<string, PostingList> terms;
+    unordered_map<uint64_t, uint32_t> latest;  // (owner, source, day) -> newest occurrence
+
+    static uint64_t slotKey(uint32_t ownerId, int source, int32_t day) {
+        return (uint64_t)ownerId << 34 | (uint64_t)(uint32_t)day << 2 | (uint64_t)source;
+    }
+
+public:
+    // Lower-cased words of letters and digits, each once
+    static vector<string> tokenize(string_view text) {
+        vector<string> words;
+        string word;
+        for (size_t i = 0; i <= text.size(); i++) {
+            if (i < text.size() && isalnum((unsigned char)text[i])) {
+                word += (char)tolower((unsigned char)text[i]);
+            } else if (!word.empty()) {
+                words.push_back(move(word));
+                word.clear();
+            }
+        }
+        sort(words.begin(), words.end());
+        words.erase(unique(words.begin(), words.end()), words.end());
+        return words;
+    }
+
+    // Records text for an owner. With replaces set, an earlier entry for the
+    // same owner, source and day is retired; identical text is not re-added.
+    // Returns false when nothing changed.
+    bool add(const string& owner, TextSource source, int32_t day, const string& text, bool replaces) {
+        if (text.empty()) return false;
+        uint32_t ownerId = stringPool().intern(owner);
+        uint32_t textId = stringPool().intern(text);
+        uint32_t id = (uint32_t)occurrences.size();
+
+        if (replaces) {
+            auto previous = latest.find(slotKey(ownerId, source, day));
+            if (previous != latest.end()) {
+                TextOccurrence& old = occurrences[previous->second];
+                if (old.live && old.textId == textId) return false;
+                old.live = false;
+                previous->second = id;
+            } else {
+                latest.emplace(slotKey(ownerId, source, day), id);
+            }
+        }
+
+        occurrences.push_back({ownerId, textId, day, (uint8_t)source, true});
+        for (const string& word : tokenize(text)) terms[word].append(id, day);
+        return true;
+    }
+
+    // Retires the live entry for an owner, source and day, e.g. an undone remark
+    void retire(const string& owner, TextSource source, int32_t day) {
+        auto previous = latest.find(slotKey(stringPool().intern(owner), source, day));
+        if (previous == latest.end()) return;
+        occurrences[previous->second].live = false;
+        latest.erase(previous);
+    }
+
+    // Occurrences containing every word of the query, dated within
+    // [fromDay, toDay] and from one of the sources in sourceMask, oldest day first
+    vector<uint32_t> query(const string& words, int32_t fromDay = INT_MIN, int32_t toDay = INT_MAX,
+                           unsigned sourceMask = ALL_TEXT_SOURCES) const {
+        vector<const PostingList*> lists;
+        for (const string& word : tokenize(words)) {
+            auto found = terms.find(word);
+            if (found == terms.end()) return {};
+            lists.push_back(&found->second);
+        }
+        if (lists.empty()) return {};
+        sort(lists.begin(), lists.end(),
+             [](const PostingList* a, const PostingList* b) { return a->size() < b->size(); });
+
+        // Buckets are disjoint day ranges, so each one is intersected on its own
+        // and the results come out in day order
+        vector<uint32_t> results, matches, next, merged;
+        lists[0]->forEachBucket(fromDay, toDay, [&](int32_t bucket) {
+            matches.clear();
+            lists[0]->collect(bucket, fromDay, toDay, matches);
+            for (size_t i = 1; i < lists.size() && !matches.empty(); i++) {
+                next.clear();
+                merged.clear();
+                lists[i]->collect(bucket, fromDay, toDay, next);
+                set_intersection(matches.begin(), matches.end(), next.begin(), next.end(), back_inserter(merged));
+                matches.swap(merged);
+            }
+            matches.erase(remove_if(matches.begin(), matches.end(), [&](uint32_t id) {
+                const TextOccurrence& occurrence = occurrences[id];
+                return !occurrence.live || occurrence.day < fromDay || occurrence.day > toDay ||
+                       !(sourceMask & (1u << occurrence.source));
+            }), matches.end());
+            stable_sort(matches.begin(), matches.end(),
+                        [this](uint32_t a, uint32_t b) { return occurrences[a].day < occurrences[b].day; });
+            results.insert(results.end(), matches.begin(), matches.end());
+        });
+        return results;
+    }
+
+    const TextOccurrence& occurrence(uint32_t id) const { return occurrences[id]; }
+    size_t size() const { return occurrences.size(); }
+    size_t termCount() const { return terms.size(); }
+
+    size_t memoryBytes() const {
+        size_t bytes = occurrences.capacity() * sizeof(TextOccurrence) +
+                       latest.size() * (sizeof(pair<uint64_t, uint32_t>) + 16) + latest.bucket_count() * sizeof(void*);
+        for (const auto& term : terms) {
+            bytes += sizeof(term) + 16 + term.second.memoryBytes();
+            if (term.first.capacity() >= sizeof(string)) bytes += term.first.capacity() + 1;
+        }
+        return bytes + terms.bucket_count() * sizeof(void*);
+    }
+};
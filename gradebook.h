@@ -0,0 +1,245 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <cstdint>
+#include <bit>
+// GCC/Clang define __SSE2__; MSVC never does, but SSE2 is baseline on x64 and
+// /arch:SSE2 sets _M_IX86_FP on 32-bit builds
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define GRADEBOOK_SSE2 1
+#endif
+
+// Columnar gradebook: one dense float column per (class, exam), indexed by the
+// class roster position. The roster holds uniqueIds, since roll numbers repeat
+// across the sections of a class. Missing marks are NaN so every kernel can
+// mask them without a side table.
+
+const float DEFAULT_PASS_FRACTION = 0.33f;  // used when a subject has no passingMarks
+
+struct MarkSummary {
+    size_t count = 0;
+    size_t passCount = 0;
+    float sum = 0;
+    float min = numeric_limits<float>::infinity();
+    float max = -numeric_limits<float>::infinity();
+};
+
+struct GradeStats {
+    size_t count = 0;
+    float mean = 0;
+    float stddev = 0;
+    float min = 0;
+    float max = 0;
+    float passRate = 0;  // percentage of recorded marks >= passing marks
+};
+
+// Single pass over a column: count, sum, min, max and pass count of non-NaN marks
+inline MarkSummary summarizeMarks(const float* marks, size_t n, float passMark) {
+    MarkSummary summary;
+    size_t i = 0;
+#ifdef GRADEBOOK_SSE2
+    __m128 sum = _mm_setzero_ps();
+    __m128 lo = _mm_set1_ps(numeric_limits<float>::infinity());
+    __m128 hi = _mm_set1_ps(-numeric_limits<float>::infinity());
+    __m128 pass = _mm_set1_ps(passMark);
+    for (; i + 4 <= n; i += 4) {
+        __m128 v = _mm_loadu_ps(marks + i);
+        __m128 valid = _mm_cmpord_ps(v, v);
+        sum = _mm_add_ps(sum, _mm_and_ps(v, valid));
+        lo = _mm_min_ps(lo, _mm_or_ps(_mm_and_ps(valid, v), _mm_andnot_ps(valid, lo)));
+        hi = _mm_max_ps(hi, _mm_or_ps(_mm_and_ps(valid, v), _mm_andnot_ps(valid, hi)));
+        summary.count += std::popcount(unsigned(_mm_movemask_ps(valid)));
+        summary.passCount += std::popcount(unsigned(_mm_movemask_ps(_mm_cmpge_ps(v, pass))));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, sum);
+    summary.sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    _mm_storeu_ps(lanes, lo);
+    summary.min = std::min(std::min(lanes[0], lanes[1]), std::min(lanes[2], lanes[3]));
+    _mm_storeu_ps(lanes, hi);
+    summary.max = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+#endif
+    for (; i < n; i++) {
+        float v = marks[i];
+        if (isnan(v)) continue;
+        summary.count++;
+        summary.sum += v;
+        summary.min = std::min(summary.min, v);
+        summary.max = std::max(summary.max, v);
+        if (v >= passMark) summary.passCount++;
+    }
+    return summary;
+}
+
+// Second pass for a numerically stable standard deviation
+inline float sumSquaredDeviation(const float* marks, size_t n, float mean) {
+    float total = 0;
+    size_t i = 0;
+#ifdef GRADEBOOK_SSE2
+    __m128 acc = _mm_setzero_ps();
+    __m128 m = _mm_set1_ps(mean);
+    for (; i + 4 <= n; i += 4) {
+        __m128 v = _mm_loadu_ps(marks + i);
+        __m128 d = _mm_and_ps(_mm_sub_ps(v, m), _mm_cmpord_ps(v, v));
+        acc = _mm_add_ps(acc, _mm_mul_ps(d, d));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, acc);
+    total = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+    for (; i < n; i++) {
+        if (!isnan(marks[i])) total += (marks[i] - mean) * (marks[i] - mean);
+    }
+    return total;
+}
+
+struct ExamColumn {
+    string subject;
+    string examType;
+    string date;
+    float maxMarks = 100;
+    vector<float> marks;  // roster position -> marks, NaN = not recorded
+};
+
+class ClassGradebook {
+private:
+    vector<string> roster;                          // position -> uniqueId
+    unordered_map<string, uint32_t> rosterIndex;   // uniqueId -> position
+    vector<ExamColumn> exams;
+    unordered_map<string, size_t> firstExamBySubject;
+
+public:
+    uint32_t rosterPosition(const string& uniqueId) {
+        auto it = rosterIndex.find(uniqueId);
+        if (it != rosterIndex.end()) return it->second;
+
+        uint32_t position = (uint32_t)roster.size();
+        roster.push_back(uniqueId);
+        rosterIndex.emplace(uniqueId, position);
+        for (auto& exam : exams) exam.marks.push_back(NAN);
+        return position;
+    }
+
+    // Returns -1 when the student has never been graded in this class
+    long findPosition(const string& uniqueId) const {
+        auto it = rosterIndex.find(uniqueId);
+        return it == rosterIndex.end() ? -1 : (long)it->second;
+    }
+
+    size_t addExam(const string& subject, const string& examType, const string& date, float maxMarks) {
+        ExamColumn column;
+        column.subject = subject;
+        column.examType = examType;
+        column.date = date;
+        column.maxMarks = maxMarks > 0 ? maxMarks : 100;
+        column.marks.assign(roster.size(), NAN);
+        exams.push_back(move(column));
+        firstExamBySubject.emplace(subject, exams.size() - 1);
+        return exams.size() - 1;
+    }
+
+    // Mirrors recordExamMarks: the first exam added for a subject
+    long findExam(const string& subject) const {
+        auto it = firstExamBySubject.find(subject);
+        return it == firstExamBySubject.end() ? -1 : (long)it->second;
+    }
+
+    void setMark(size_t exam, const string& uniqueId, float marks) {
+        uint32_t position = rosterPosition(uniqueId);
+        exams[exam].marks[position] = marks;
+    }
+
+    const vector<ExamColumn>& getExams() const { return exams; }
+    const vector<string>& getRoster() const { return roster; }
+
+    GradeStats stats(size_t exam, float passingMarks) const {
+        const ExamColumn& column = exams[exam];
+        if (passingMarks < 0) passingMarks = column.maxMarks * DEFAULT_PASS_FRACTION;
+
+        MarkSummary summary = summarizeMarks(column.marks.data(), column.marks.size(), passingMarks);
+        GradeStats result;
+        result.count = summary.count;
+        if (summary.count == 0) return result;
+
+        result.mean = summary.sum / summary.count;
+        result.stddev = sqrt(sumSquaredDeviation(column.marks.data(), column.marks.size(), result.mean) /
+                             summary.count);
+        result.min = summary.min;
+        result.max = summary.max;
+        result.passRate = summary.passCount * 100.0f / summary.count;
+        return result;
+    }
+
+    // Competition ranking (1 = highest, ties share a rank); 0 = no mark
+    vector<uint32_t> ranks(size_t exam) const {
+        const vector<float>& marks = exams[exam].marks;
+        vector<uint32_t> order;
+        for (uint32_t i = 0; i < marks.size(); i++) {
+            if (!isnan(marks[i])) order.push_back(i);
+        }
+        sort(order.begin(), order.end(), [&marks](uint32_t a, uint32_t b) { return marks[a] > marks[b]; });
+
+        vector<uint32_t> result(marks.size(), 0);
+        for (size_t i = 0; i < order.size(); i++) {
+            bool tied = i > 0 && marks[order[i]] == marks[order[i - 1]];
+            result[order[i]] = tied ? result[order[i - 1]] : (uint32_t)(i + 1);
+        }
+        return result;
+    }
+
+    // Linear-interpolated percentile (0-100) of the recorded marks
+    float percentile(size_t exam, float p) const {
+        vector<float> values;
+        for (float v : exams[exam].marks) {
+            if (!isnan(v)) values.push_back(v);
+        }
+        if (values.empty()) return NAN;
+
+        double rank = clamp(p, 0.0f, 100.0f) / 100.0 * (values.size() - 1);
+        size_t lower = (size_t)rank;
+        nth_element(values.begin(), values.begin() + lower, values.end());
+        float low = values[lower];
+        if (lower + 1 >= values.size()) return low;
+        float high = *min_element(values.begin() + lower + 1, values.end());
+        return low + (float)(rank - lower) * (high - low);
+    }
+
+    // Per-student average percentage across every exam (NaN = never graded).
+    // Walks the columns once each; the inner loop is branch-free and vectorizes.
+    vector<float> studentAverages(const string& subject = "") const {
+        vector<float> sum(roster.size(), 0.0f);
+        vector<float> count(roster.size(), 0.0f);
+        for (const auto& exam : exams) {
+            if (!subject.empty() && exam.subject != subject) continue;
+            const float scale = 100.0f / exam.maxMarks;
+            const float* marks = exam.marks.data();
+            for (size_t i = 0; i < roster.size(); i++) {
+                bool recorded = marks[i] == marks[i];
+                sum[i] += recorded ? marks[i] * scale : 0.0f;
+                count[i] += recorded ? 1.0f : 0.0f;
+            }
+        }
+        for (size_t i = 0; i < roster.size(); i++) {
+            sum[i] = count[i] > 0 ? sum[i] / count[i] : NAN;
+        }
+        return sum;
+    }
+};
+
+class Gradebook {
+private:
+    unordered_map<string, ClassGradebook> classes;
+
+public:
+    ClassGradebook& forClass(const string& className) { return classes[className]; }
+
+    const ClassGradebook* findClass(const string& className) const {
+        auto it = classes.find(className);
+        return it == classes.end() ? nullptr : &it->second;
+    }
+};
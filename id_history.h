@@ -0,0 +1,100 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <fstream>
+#include <sstream>
+#include <climits>
+#include <cstdlib>
+#include <filesystem>
+#include "durable_io.h"
+
+// Student ids across rollovers. A uniqueId embeds the class, so promotion
+// gives every student a new one. Each rollover records old -> new for every
+// student (new is empty for a graduate), so archive segments, which are keyed
+// by the id a student had during that year, can still be searched.
+//
+// File format: a "year,old_id,new_id" header, then one line per student per
+// rollover. The file is read on first use, not at startup.
+
+class IdHistory {
+private:
+    string path;
+    bool loaded = false;
+    map<int, unordered_map<string, string>> previous;  // rollover year -> new id -> old id
+    string content;                                    // the file as last read or written
+
+    void load() {
+        if (loaded) return;
+        loaded = true;
+        ifstream in(path, ios::binary);
+        if (!in.is_open()) return;
+        content.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+        istringstream lines(content);
+        string line;
+        getline(lines, line);  // header
+        while (getline(lines, line)) {
+            size_t first = line.find(','), second = line.find(',', first + 1);
+            if (first == string::npos || second == string::npos) continue;
+            string newId = line.substr(second + 1);
+            if (!newId.empty() && newId.back() == '\r') newId.pop_back();
+            auto& year = previous[atoi(line.c_str())];  // created even for graduates, so the year counts as rolled over
+            if (!newId.empty()) year[newId] = line.substr(first + 1, second - first - 1);
+        }
+    }
+
+public:
+    explicit IdHistory(const string& historyPath) : path(historyPath) {}
+
+    // Start year of the latest rollover, or INT_MIN when there has been none
+    int lastRolledOver() {
+        load();
+        return previous.empty() ? INT_MIN : previous.rbegin()->first;
+    }
+
+    // Appends a rollover's id changes and makes the file durable. Nothing
+    // changes, on disk or here, unless the write succeeds.
+    bool record(int year, const vector<pair<string, string>>& changes, string& error) {
+        load();
+        string updated = content.empty() ? "year,old_id,new_id\n" : content;
+        for (const auto& change : changes) {
+            updated += to_string(year) + "," + change.first + "," + change.second + "\n";
+        }
+        if (!writeDurableTemp(path, updated, error) || !commitDurableTemp(path, error)) return false;
+        syncDirectory(filesystem::path(path).parent_path().string());
+        content = move(updated);
+        auto& mapping = previous[year];
+        for (const auto& change : changes) {
+            if (!change.second.empty()) mapping[change.second] = change.first;
+        }
+        return true;
+    }
+
+    // The old -> new ids one rollover recorded, graduates included, in file order
+    vector<pair<string, string>> changesIn(int year) {
+        load();
+        vector<pair<string, string>> changes;
+        istringstream lines(content);
+        string line, prefix = to_string(year) + ",";
+        getline(lines, line);  // header
+        while (getline(lines, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            size_t second = line.find(',', prefix.size());
+            if (!line.starts_with(prefix) || second == string::npos) continue;
+            changes.push_back({line.substr(prefix.size(), second - prefix.size()), line.substr(second + 1)});
+        }
+        return changes;
+    }
+
+    // The id a student known today as currentId had during the given year
+    string idInYear(const string& currentId, int year) {
+        load();
+        string id = currentId;
+        for (auto it = previous.rbegin(); it != previous.rend() && it->first >= year; ++it) {
+            auto found = it->second.find(id);
+            if (found != it->second.end()) id = found->second;
+        }
+        return id;
+    }
+};
@@ -0,0 +1,272 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <algorithm>
+#include <atomic>
+#include <ostream>
+#include <iomanip>
+#include <ctime>
+#include <cstdlib>
+#include <cstdint>
+#include <new>
+#include "arena.h"
+
+// Walks the in-memory model and estimates heap usage per category. Sizes
+// come from the containers themselves (capacity, node counts), and every
+// heap block is also charged a malloc-style overhead estimate. Blocks that
+// live in a SectionArena are charged as plain bytes; the arena's chunks
+// and slack are charged separately.
+//
+// Building with -DATTENDANCE_TRACK_ALLOCATIONS and linking memory_tracking.cpp
+// also replaces the global operator new/delete with counting versions, so
+// snapshots can compare the model's estimate against the bytes that are
+// actually live:
+//   cmake -S . -B build -DATTENDANCE_TRACK_ALLOCATIONS=ON && cmake --build build
+
+const size_t MALLOC_HEADER_BYTES = sizeof(size_t);
+const size_t MALLOC_ALIGNMENT = 2 * sizeof(void*);
+const size_t MALLOC_MIN_CHUNK = 4 * sizeof(void*);
+const size_t TREE_NODE_HEADER_BYTES = 4 * sizeof(void*);  // color + parent/left/right, padded
+
+// Bytes malloc hands out beyond the request (header plus rounding)
+inline size_t allocatorOverhead(size_t requested) {
+    size_t chunk = (requested + MALLOC_HEADER_BYTES + MALLOC_ALIGNMENT - 1) & ~(MALLOC_ALIGNMENT - 1);
+    return max(chunk, MALLOC_MIN_CHUNK) - requested;
+}
+
+struct MemoryUsage {
+    uint64_t bytes = 0;          // requested heap bytes plus inline object sizes
+    uint64_t overhead = 0;       // estimated allocator overhead
+    uint64_t allocations = 0;
+    uint64_t elements = 0;
+
+    void addAllocation(size_t requested) {
+        if (!requested) return;
+        bytes += requested;
+        overhead += allocatorOverhead(requested);
+        allocations++;
+    }
+
+    void addInline(size_t size) { bytes += size; }
+
+    void merge(const MemoryUsage& other) {
+        bytes += other.bytes;
+        overhead += other.overhead;
+        allocations += other.allocations;
+        elements += other.elements;
+    }
+
+    uint64_t total() const { return bytes + overhead; }
+};
+
+// accountHeap charges the heap memory owned by a value, not the value itself;
+// the enclosing container has already counted sizeof(T). Model types provide
+// their own overloads next to their definitions.
+inline void accountHeap(MemoryUsage& usage, const string& value) {
+    const char* data = value.data();
+    const char* object = reinterpret_cast<const char*>(&value);
+    bool inlineBuffer = data >= object && data < object + sizeof(string);  // small-string optimisation
+    if (!inlineBuffer) usage.addAllocation(value.capacity() + 1);
+}
+
+// Charges one block obtained from resource
+inline void accountBlock(MemoryUsage& usage, size_t bytes, const pmr::memory_resource* resource) {
+    if (!bytes) return;
+    if (dynamic_cast<const SectionArena*>(resource)) usage.addInline(bytes);
+    else usage.addAllocation(bytes);
+}
+
+inline void accountHeap(MemoryUsage& usage, const pmr::string& value) {
+    const char* data = value.data();
+    const char* object = reinterpret_cast<const char*>(&value);
+    bool inlineBuffer = data >= object && data < object + sizeof(pmr::string);
+    if (!inlineBuffer) accountBlock(usage, value.capacity() + 1, value.get_allocator().resource());
+}
+
+template <typename T, typename = enable_if_t<is_arithmetic_v<T> || is_enum_v<T>>>
+inline void accountHeap(MemoryUsage&, const T&) {}
+
+template <typename A, typename B> void accountHeap(MemoryUsage& usage, const pair<A, B>& value);
+template <typename T> void accountHeap(MemoryUsage& usage, const vector<T>& value);
+template <typename T> void accountHeap(MemoryUsage& usage, const deque<T>& value);
+template <typename K, typename V> void accountHeap(MemoryUsage& usage, const map<K, V>& value);
+template <typename T> void accountHeap(MemoryUsage& usage, const pmr::vector<T>& value);
+template <typename V> void accountHeap(MemoryUsage& usage, const FlatDateMap<V>& value);
+template <typename V> void accountHeap(MemoryUsage& usage, const FlatIdMap<V>& value);
+
+template <typename A, typename B>
+void accountHeap(MemoryUsage& usage, const pair<A, B>& value) {
+    accountHeap(usage, value.first);
+    accountHeap(usage, value.second);
+}
+
+template <typename T>
+void accountHeap(MemoryUsage& usage, const vector<T>& value) {
+    usage.addAllocation(value.capacity() * sizeof(T));
+    usage.elements += value.size();
+    for (const auto& element : value) accountHeap(usage, element);
+}
+
+template <typename T>
+void accountHeap(MemoryUsage& usage, const deque<T>& value) {
+    // Blocks of ~512 bytes plus a map of block pointers
+    size_t perBlock = max<size_t>(1, 512 / sizeof(T));
+    size_t blocks = value.size() / perBlock + 1;
+    for (size_t b = 0; b < blocks; b++) usage.addAllocation(perBlock * sizeof(T));
+    usage.addAllocation(max<size_t>(8, blocks + 2) * sizeof(void*));
+    usage.elements += value.size();
+    for (const auto& element : value) accountHeap(usage, element);
+}
+
+template <typename T>
+void accountHeap(MemoryUsage& usage, const pmr::vector<T>& value) {
+    accountBlock(usage, value.capacity() * sizeof(T), value.get_allocator().resource());
+    usage.elements += value.size();
+    for (const auto& element : value) accountHeap(usage, element);
+}
+
+template <typename V>
+void accountHeap(MemoryUsage& usage, const FlatDateMap<V>& value) {
+    const auto& entries = value.raw();
+    accountBlock(usage, entries.capacity() * sizeof(entries[0]), entries.get_allocator().resource());
+    usage.elements += entries.size();
+    for (const auto& entry : entries) accountHeap(usage, entry.value);
+}
+
+template <typename V>
+void accountHeap(MemoryUsage& usage, const FlatIdMap<V>& value) {
+    accountHeap(usage, value.raw());
+}
+
+template <typename K, typename V>
+void accountHeap(MemoryUsage& usage, const map<K, V>& value) {
+    for (const auto& entry : value) {
+        usage.addAllocation(TREE_NODE_HEADER_BYTES + sizeof(entry));
+        accountHeap(usage, entry.first);
+        accountHeap(usage, entry.second);
+    }
+    usage.elements += value.size();
+}
+
+#ifdef ATTENDANCE_TRACK_ALLOCATIONS
+// Live heap totals kept by the operator new/delete replacements in
+// memory_tracking.cpp
+int64_t trackedLiveBytes();
+int64_t trackedLiveAllocations();
+#endif
+
+struct MemorySnapshot {
+    string label;
+    time_t takenAt = 0;
+    map<string, MemoryUsage> categories;
+    map<string, MemoryUsage> sections;   // "class-section" -> memory owned by its students
+    size_t students = 0;
+    size_t duplicateStudents = 0;        // same uniqueId loaded more than once
+    int64_t trackedBytes = -1;           // -1 unless built with ATTENDANCE_TRACK_ALLOCATIONS
+    int64_t trackedAllocations = -1;
+
+    MemorySnapshot(const string& snapshotLabel = "") : label(snapshotLabel), takenAt(time(nullptr)) {
+#ifdef ATTENDANCE_TRACK_ALLOCATIONS
+        trackedBytes = trackedLiveBytes();
+        trackedAllocations = trackedLiveAllocations();
+#endif
+    }
+
+    void charge(const string& category, const MemoryUsage& usage) { categories[category].merge(usage); }
+
+    MemoryUsage total() const {
+        MemoryUsage sum;
+        for (const auto& category : categories) sum.merge(category.second);
+        return sum;
+    }
+};
+
+inline string formatBytes(double bytes) {
+    static const char* UNITS[] = {"B", "KiB", "MiB", "GiB"};
+    int unit = 0;
+    bool negative = bytes < 0;
+    if (negative) bytes = -bytes;
+    while (bytes >= 1024 && unit < 3) {
+        bytes /= 1024;
+        unit++;
+    }
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), unit ? "%s%.2f %s" : "%s%.0f %s", negative ? "-" : "", bytes, UNITS[unit]);
+    return buffer;
+}
+
+inline void writeMemorySnapshot(ostream& out, const MemorySnapshot& snapshot) {
+    MemoryUsage total = snapshot.total();
+    out << "Memory Snapshot: " << snapshot.label << "\n";
+    out << "Students: " << snapshot.students << " (" << snapshot.duplicateStudents << " duplicates)\n";
+    out << "Estimated total: " << formatBytes(total.total()) << " (" << formatBytes(total.bytes)
+        << " data + " << formatBytes(total.overhead) << " allocator overhead, "
+        << total.allocations << " allocations)\n";
+    if (snapshot.trackedBytes >= 0) {
+        out << "Tracked live heap: " << formatBytes(snapshot.trackedBytes) << " in "
+            << snapshot.trackedAllocations << " allocations\n";
+    }
+
+    out << "\nBy Category:\n" << string(80, '-') << "\n";
+    out << left << setw(28) << "Category" << right << setw(12) << "Elements" << setw(14) << "Data"
+        << setw(14) << "Overhead" << setw(12) << "Allocs" << "\n";
+    for (const auto& category : snapshot.categories) {
+        const MemoryUsage& usage = category.second;
+        out << left << setw(28) << category.first << right << setw(12) << usage.elements
+            << setw(14) << formatBytes(usage.bytes) << setw(14) << formatBytes(usage.overhead)
+            << setw(12) << usage.allocations << "\n";
+    }
+
+    out << "\nBy Section:\n" << string(80, '-') << "\n";
+    for (const auto& section : snapshot.sections) {
+        out << left << setw(28) << section.first << right << setw(14) << formatBytes(section.second.total())
+            << "  (" << section.second.elements << " elements)\n";
+    }
+    out << left;
+}
+
+// Categories that grew or shrank between two snapshots, largest change first
+inline void writeMemoryDiff(ostream& out, const MemorySnapshot& before, const MemorySnapshot& after) {
+    auto delta = [](const map<string, MemoryUsage>& a, const map<string, MemoryUsage>& b) {
+        map<string, pair<int64_t, int64_t>> changes;  // name -> {bytes, elements}
+        for (const auto& entry : b) {
+            changes[entry.first] = {(int64_t)entry.second.total(), (int64_t)entry.second.elements};
+        }
+        for (const auto& entry : a) {
+            auto& change = changes[entry.first];
+            change.first -= (int64_t)entry.second.total();
+            change.second -= (int64_t)entry.second.elements;
+        }
+        vector<pair<string, pair<int64_t, int64_t>>> sorted;
+        for (const auto& change : changes) {
+            if (change.second.first || change.second.second) sorted.push_back(change);
+        }
+        sort(sorted.begin(), sorted.end(), [](const auto& x, const auto& y) {
+            return llabs(x.second.first) > llabs(y.second.first);
+        });
+        return sorted;
+    };
+
+    out << "Memory Diff: " << before.label << " -> " << after.label << " ("
+        << difftime(after.takenAt, before.takenAt) << "s apart)\n";
+    out << "Students: " << (int64_t)after.students - (int64_t)before.students
+        << ", duplicates: " << (int64_t)after.duplicateStudents - (int64_t)before.duplicateStudents << "\n";
+    out << "Estimated total: " << formatBytes((double)after.total().total() - (double)before.total().total()) << "\n";
+    if (before.trackedBytes >= 0 && after.trackedBytes >= 0) {
+        out << "Tracked live heap: " << formatBytes((double)(after.trackedBytes - before.trackedBytes)) << "\n";
+    }
+
+    out << "\nCategory changes:\n";
+    for (const auto& change : delta(before.categories, after.categories)) {
+        out << "  " << left << setw(28) << change.first << right << setw(14) << formatBytes(change.second.first)
+            << setw(12) << showpos << change.second.second << noshowpos << " elements\n";
+    }
+    out << "\nSection changes:\n";
+    for (const auto& change : delta(before.sections, after.sections)) {
+        out << "  " << left << setw(28) << change.first << right << setw(14) << formatBytes(change.second.first)
+            << setw(12) << showpos << change.second.second << noshowpos << " elements\n";
+    }
+    out << left;
+}
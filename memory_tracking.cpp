@@ -0,0 +1,62 @@
+// Counting replacements for the global operator new/delete, used by the
+// memory report when built with -DATTENDANCE_TRACK_ALLOCATIONS (see
+// memory_accounting.h). They live in their own translation unit so the
+// compiler never sees a malloc-backed operator new paired with a delete in
+// the same body. Without the define this file compiles to nothing.
+#ifdef ATTENDANCE_TRACK_ALLOCATIONS
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <malloc.h>  // _msize on Windows, malloc_usable_size elsewhere
+
+using namespace std;
+
+static atomic<int64_t> liveBytes{0};
+static atomic<int64_t> liveAllocations{0};
+
+// The allocator knows each block's size, so no header is needed; usable
+// size includes malloc's rounding, which is what the process actually holds
+static size_t blockSize(void* block) {
+#ifdef _WIN32
+    return _msize(block);
+#else
+    return malloc_usable_size(block);
+#endif
+}
+
+static void* trackedAllocate(size_t size) {
+    void* block = malloc(size ? size : 1);
+    if (!block) return nullptr;
+    liveBytes.fetch_add((int64_t)blockSize(block), memory_order_relaxed);
+    liveAllocations.fetch_add(1, memory_order_relaxed);
+    return block;
+}
+
+static void trackedRelease(void* block) {
+    if (!block) return;
+    liveBytes.fetch_sub((int64_t)blockSize(block), memory_order_relaxed);
+    liveAllocations.fetch_sub(1, memory_order_relaxed);
+    free(block);
+}
+
+int64_t trackedLiveBytes() { return liveBytes.load(memory_order_relaxed); }
+int64_t trackedLiveAllocations() { return liveAllocations.load(memory_order_relaxed); }
+
+void* operator new(size_t size) {
+    if (void* pointer = trackedAllocate(size)) return pointer;
+    throw bad_alloc();
+}
+void* operator new[](size_t size) {
+    if (void* pointer = trackedAllocate(size)) return pointer;
+    throw bad_alloc();
+}
+void* operator new(size_t size, const nothrow_t&) noexcept { return trackedAllocate(size); }
+void* operator new[](size_t size, const nothrow_t&) noexcept { return trackedAllocate(size); }
+void operator delete(void* pointer) noexcept { trackedRelease(pointer); }
+void operator delete[](void* pointer) noexcept { trackedRelease(pointer); }
+void operator delete(void* pointer, size_t) noexcept { trackedRelease(pointer); }
+void operator delete[](void* pointer, size_t) noexcept { trackedRelease(pointer); }
+void operator delete(void* pointer, const nothrow_t&) noexcept { trackedRelease(pointer); }
+void operator delete[](void* pointer, const nothrow_t&) noexcept { trackedRelease(pointer); }
+#endif
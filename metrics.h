@@ -0,0 +1,221 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <filesystem>
+#include <cstdint>
+
+// Hot-path instrumentation. Build with -DATTENDANCE_METRICS to enable it;
+// without the flag every METRIC_* macro expands to nothing and none of the
+// types below are instantiated.
+//
+// Each thread writes only its own counters and histograms, so recording
+// is a plain relaxed load+store with no locked instructions. The
+// exporter sums all threads when it writes the Prometheus text file.
+
+enum MetricStage {
+    STAGE_LOAD, STAGE_SAVE, STAGE_BACKUP, STAGE_VALIDATE, STAGE_PARSE, STAGE_AGGREGATE, STAGE_RENDER,
+    STAGE_COUNT
+};
+
+enum MetricCounter {
+    COUNTER_FILES_LOADED, COUNTER_FILES_SAVED, COUNTER_ROWS_PARSED, COUNTER_RECORDS_PARSED,
+    COUNTER_ROWS_WRITTEN, COUNTER_ROWS_REJECTED, COUNTER_BACKUPS, COUNTER_REPORTS_RENDERED,
+    COUNTER_FILE_SYNCS, COUNTER_DIR_SYNCS,
+    COUNTER_COUNT
+};
+
+inline const char* metricStageName(MetricStage stage) {
+    static const char* NAMES[STAGE_COUNT] = {"load", "save", "backup", "validate", "parse", "aggregate", "render"};
+    return NAMES[stage];
+}
+
+inline const char* metricCounterName(MetricCounter counter) {
+    static const char* NAMES[COUNTER_COUNT] = {
+        "attendance_files_loaded_total", "attendance_files_saved_total", "attendance_rows_parsed_total",
+        "attendance_records_parsed_total", "attendance_rows_written_total", "attendance_rows_rejected_total",
+        "attendance_backups_total", "attendance_reports_rendered_total", "attendance_file_syncs_total",
+        "attendance_dir_syncs_total"};
+    return NAMES[counter];
+}
+
+#ifdef ATTENDANCE_METRICS
+
+// Upper bounds of the latency buckets in nanoseconds (10us .. 10s); one more implicit +Inf bucket
+const uint64_t METRIC_BUCKET_BOUNDS_NS[] = {
+    10000, 50000, 100000, 500000, 1000000, 5000000, 10000000, 50000000,
+    100000000, 500000000, 1000000000, 10000000000ULL};
+const int METRIC_BUCKET_COUNT = sizeof(METRIC_BUCKET_BOUNDS_NS) / sizeof(*METRIC_BUCKET_BOUNDS_NS);
+
+struct ThreadMetrics {
+    atomic<uint64_t> counters[COUNTER_COUNT] = {};
+    atomic<uint64_t> buckets[STAGE_COUNT][METRIC_BUCKET_COUNT + 1] = {};
+    atomic<uint64_t> sumNs[STAGE_COUNT] = {};
+    atomic<uint64_t> observations[STAGE_COUNT] = {};
+
+    // Single writer: the owning thread
+    static void bump(atomic<uint64_t>& value, uint64_t n) {
+        value.store(value.load(memory_order_relaxed) + n, memory_order_relaxed);
+    }
+
+    void add(MetricCounter counter, uint64_t n) { bump(counters[counter], n); }
+
+    void observe(MetricStage stage, uint64_t nanoseconds) {
+        int bucket = 0;
+        while (bucket < METRIC_BUCKET_COUNT && nanoseconds > METRIC_BUCKET_BOUNDS_NS[bucket]) bucket++;
+        bump(buckets[stage][bucket], 1);
+        bump(sumNs[stage], nanoseconds);
+        bump(observations[stage], 1);
+    }
+};
+
+class MetricsRegistry {
+private:
+    mutex lock;
+    vector<unique_ptr<ThreadMetrics>> threads;  // never shrinks, so exited threads keep their totals
+
+public:
+    ThreadMetrics& local() {
+        thread_local ThreadMetrics* mine = nullptr;
+        if (!mine) {
+            lock_guard<mutex> guard(lock);
+            threads.push_back(make_unique<ThreadMetrics>());
+            mine = threads.back().get();
+        }
+        return *mine;
+    }
+
+    void writePrometheus(ostream& out) {
+        uint64_t counters[COUNTER_COUNT] = {};
+        uint64_t buckets[STAGE_COUNT][METRIC_BUCKET_COUNT + 1] = {};
+        uint64_t sumNs[STAGE_COUNT] = {};
+        uint64_t observations[STAGE_COUNT] = {};
+        {
+            lock_guard<mutex> guard(lock);
+            for (const auto& thread : threads) {
+                for (int c = 0; c < COUNTER_COUNT; c++) counters[c] += thread->counters[c].load(memory_order_relaxed);
+                for (int s = 0; s < STAGE_COUNT; s++) {
+                    for (int b = 0; b <= METRIC_BUCKET_COUNT; b++) {
+                        buckets[s][b] += thread->buckets[s][b].load(memory_order_relaxed);
+                    }
+                    sumNs[s] += thread->sumNs[s].load(memory_order_relaxed);
+                    observations[s] += thread->observations[s].load(memory_order_relaxed);
+                }
+            }
+        }
+
+        out << "# HELP attendance_stage_duration_seconds Time spent in each pipeline stage.\n"
+            << "# TYPE attendance_stage_duration_seconds histogram\n";
+        for (int s = 0; s < STAGE_COUNT; s++) {
+            string label = string("stage=\"") + metricStageName((MetricStage)s) + "\"";
+            uint64_t cumulative = 0;
+            for (int b = 0; b <= METRIC_BUCKET_COUNT; b++) {
+                cumulative += buckets[s][b];
+                out << "attendance_stage_duration_seconds_bucket{" << label << ",le=\"";
+                if (b < METRIC_BUCKET_COUNT) out << METRIC_BUCKET_BOUNDS_NS[b] / 1e9;
+                else out << "+Inf";
+                out << "\"} " << cumulative << "\n";
+            }
+            out << "attendance_stage_duration_seconds_sum{" << label << "} " << fixed << setprecision(9)
+                << sumNs[s] / 1e9 << defaultfloat << "\n";
+            out << "attendance_stage_duration_seconds_count{" << label << "} " << observations[s] << "\n";
+        }
+        for (int c = 0; c < COUNTER_COUNT; c++) {
+            out << "# TYPE " << metricCounterName((MetricCounter)c) << " counter\n"
+                << metricCounterName((MetricCounter)c) << " " << counters[c] << "\n";
+        }
+    }
+
+    // Written to a temp file and renamed, so a scraper never reads a partial file
+    bool writeTextFile(const string& path) {
+        stringstream text;
+        writePrometheus(text);
+        error_code ec;
+        filesystem::path target(path);
+        if (target.has_parent_path()) filesystem::create_directories(target.parent_path(), ec);
+        string temp = path + ".tmp";
+        {
+            ofstream file(temp, ios::binary | ios::trunc);
+            if (!file.is_open()) return false;
+            file << text.str();
+        }
+        filesystem::rename(temp, target, ec);
+        return !ec;
+    }
+};
+
+inline MetricsRegistry& metricsRegistry() {
+    static MetricsRegistry registry;
+    return registry;
+}
+
+class MetricStageTimer {
+private:
+    MetricStage stage;
+    chrono::steady_clock::time_point start;
+
+public:
+    explicit MetricStageTimer(MetricStage s) : stage(s), start(chrono::steady_clock::now()) {}
+    ~MetricStageTimer() {
+        auto elapsed = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+        metricsRegistry().local().observe(stage, (uint64_t)elapsed);
+    }
+};
+
+// Rewrites the metrics file every intervalSeconds for a textfile collector
+// (node_exporter --collector.textfile.directory) or any local scraper, and
+// once more on destruction.
+class MetricsExporter {
+private:
+    string path;
+    chrono::seconds interval;
+    mutex lock;
+    condition_variable wake;
+    bool stopping = false;
+    thread worker;
+
+public:
+    MetricsExporter(const string& filePath, int intervalSeconds)
+        : path(filePath), interval(max(1, intervalSeconds)) {
+        worker = thread([this]() {
+            unique_lock<mutex> guard(lock);
+            while (!wake.wait_for(guard, interval, [this]() { return stopping; })) {
+                guard.unlock();
+                metricsRegistry().writeTextFile(path);
+                guard.lock();
+            }
+        });
+    }
+
+    ~MetricsExporter() {
+        {
+            lock_guard<mutex> guard(lock);
+            stopping = true;
+        }
+        wake.notify_one();
+        worker.join();
+        metricsRegistry().writeTextFile(path);
+    }
+};
+
+#define METRIC_CONCAT_INNER(a, b) a##b
+#define METRIC_CONCAT(a, b) METRIC_CONCAT_INNER(a, b)
+#define METRIC_STAGE(stage) MetricStageTimer METRIC_CONCAT(metricStageTimer_, __LINE__)(stage)
+#define METRIC_ADD(counter, n) metricsRegistry().local().add(counter, (uint64_t)(n))
+#define METRICS_EXPORTER(path, seconds) MetricsExporter metricsExporter_(path, seconds)
+
+#else
+
+#define METRIC_STAGE(stage) ((void)0)
+#define METRIC_ADD(counter, n) ((void)0)
+#define METRICS_EXPORTER(path, seconds) ((void)0)
+
+#endif
@@ -0,0 +1,78 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdint>
+
+// Bookkeeping for each partition (class-section) of the student data, so a
+// save writes only what changed. Every mutation bumps the partition's
+// generation; queueing a save records the generation it captured. A
+// partition is dirty while its generation is ahead of the saved one, so a
+// change made after the snapshot was rendered stays dirty for the next save.
+
+struct PartitionState {
+    string className;
+    string section;
+    uint64_t generation = 0;
+    uint64_t savedGeneration = 0;
+    bool loaded = false;  // its file has been read; from then on memory is authoritative
+
+    bool dirty() const { return generation != savedGeneration; }
+};
+
+class PartitionTracker {
+private:
+    map<string, PartitionState> partitions;  // by key, so saves run in a stable order
+
+    PartitionState& at(const string& className, const string& section) {
+        PartitionState& state = partitions[keyFor(className, section)];
+        if (state.className.empty() && state.section.empty()) {
+            state.className = className;
+            state.section = section;
+        }
+        return state;
+    }
+
+public:
+    // Same key the arenas and the persistence queue use
+    static string keyFor(const string& className, const string& section) { return className + "-" + section; }
+
+    void markDirty(const string& className, const string& section) { at(className, section).generation++; }
+
+    bool isLoaded(const string& className, const string& section) const {
+        auto it = partitions.find(keyFor(className, section));
+        return it != partitions.end() && it->second.loaded;
+    }
+
+    void markLoaded(const string& className, const string& section) { at(className, section).loaded = true; }
+
+    // Records that a snapshot of the current generation was queued for writing
+    void markSaving(const string& className, const string& section) {
+        PartitionState& state = at(className, section);
+        state.savedGeneration = state.generation;
+    }
+
+    // A failed write leaves the partition dirty for the next save
+    void markFailed(const string& key) {
+        auto it = partitions.find(key);
+        if (it != partitions.end()) it->second.generation++;
+    }
+
+    // Evicted from memory: the next load reads the file again and unsaved changes are dropped
+    void forget(const string& className, const string& section) {
+        partitions.erase(keyFor(className, section));
+    }
+
+    // Everything was unloaded
+    void clear() { partitions.clear(); }
+
+    vector<const PartitionState*> dirtyPartitions() const {
+        vector<const PartitionState*> dirty;
+        for (const auto& partition : partitions) {
+            if (partition.second.dirty()) dirty.push_back(&partition.second);
+        }
+        return dirty;
+    }
+
+    size_t size() const { return partitions.size(); }
+};
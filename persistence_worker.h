@@ -0,0 +1,283 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <set>
+#include <filesystem>
+#include <algorithm>
+#include <ctime>
+#include <cstdint>
+#include "backup_store.h"
+#include "durable_io.h"
+
+// Background writer for class files. The UI thread renders a partition
+// (class-section) into memory and queues it; a few writer threads write
+// different partitions in parallel, while jobs for one partition run one at
+// a time in queue order. A partition that is queued again before a writer
+// reaches it is coalesced: the newer snapshot replaces the older one in
+// place. The queue is bounded, so a producer that outruns the disk waits
+// instead of growing memory without limit.
+//
+// Every file is written to "<path>.tmp", synced and renamed over the target
+// (durable_io.h), so a crash leaves either the previous or the new file,
+// never a torn one. The renames of a commit group, every job finished until
+// the queue runs dry or GROUP_COMMIT_JOBS accumulate, are made durable with
+// one sync per directory rather than one per file (POSIX only, see
+// durable_io.h); a job counts as done only once its group is synced. A bulk save brackets its jobs with beginGroup()
+// and endGroup() so the group stays open while it is still rendering. Files marked for backup are also recorded as a
+// new version in the backup store. flush() is the barrier: it returns once
+// everything queued before the call is durable.
+
+struct PersistFile {
+    string path;
+    string content;
+    bool backup = false;  // record this version in the backup store
+};
+
+struct PersistError {
+    string key;
+    string message;
+};
+
+struct PersistJob {
+    string key;  // partition, e.g. "5-A"
+    vector<PersistFile> files;
+    uint64_t sequence = 0;
+};
+
+class PersistenceWorker {
+private:
+    static const size_t DEFAULT_CAPACITY = 64;
+    static const size_t DEFAULT_WRITERS = 4;
+    static const size_t GROUP_COMMIT_JOBS = 64;
+
+    mutable mutex lock;
+    condition_variable wake;       // writers: work arrived, a partition freed up, or stopping
+    condition_variable progress;   // producers: space freed or a job finished
+    deque<PersistJob> queue;
+    size_t capacity;
+    vector<pair<string, uint64_t>> inFlight;  // (key, sequence) being written or awaiting its group sync
+    vector<pair<string, uint64_t>> unsynced;  // written jobs of the open commit group
+    set<string> unsyncedDirectories;          // directories their renames touched
+    size_t openGroups = 0;                    // beginGroup() calls not yet ended
+    uint64_t nextSequence = 1;
+    uint64_t completedSequence = 0;  // every job up to here is written
+    bool stopping = false;
+    vector<PersistError> errors;
+    size_t coalescedCount = 0;
+    size_t writtenCount = 0;
+    BackupStore* backups;
+    vector<thread> writers;
+
+    bool isInFlight(const string& key) const {
+        for (const auto& job : inFlight) {
+            if (job.first == key) return true;
+        }
+        return false;
+    }
+
+    // Oldest queued job whose partition no other writer holds
+    deque<PersistJob>::iterator nextRunnable() {
+        for (auto it = queue.begin(); it != queue.end(); ++it) {
+            if (!isInFlight(it->key)) return it;
+        }
+        return queue.end();
+    }
+
+    void updateCompleted() {
+        uint64_t oldest = nextSequence;
+        for (const auto& job : inFlight) oldest = min(oldest, job.second);
+        for (const PersistJob& job : queue) oldest = min(oldest, job.sequence);
+        completedSequence = oldest - 1;
+    }
+
+    bool writeAtomically(const PersistFile& file, string& error) {
+        filesystem::path target(file.path);
+        error_code code;
+        if (target.has_parent_path()) filesystem::create_directories(target.parent_path(), code);
+
+        if (!writeDurableTemp(file.path, file.content, error)) return false;
+        METRIC_ADD(COUNTER_FILE_SYNCS, 1);
+
+        // A file written before the store existed is kept as its first version
+        if (file.backup && backups && !backups->captureExisting(file.path, (int64_t)time(nullptr), error)) {
+            return false;
+        }
+        return commitDurableTemp(file.path, error);
+    }
+
+    // Syncs the directories of the open commit group and completes its jobs.
+    // Called with the lock held; releases it while syncing.
+    void commitGroup(unique_lock<mutex>& guard) {
+        vector<pair<string, uint64_t>> jobs;
+        set<string> directories;
+        jobs.swap(unsynced);
+        directories.swap(unsyncedDirectories);
+        guard.unlock();
+
+        vector<PersistError> failures;
+        {
+            TRACE_SPAN("persistCommitGroup");
+            for (const string& directory : directories) {
+                if (syncDirectory(directory)) {
+                    if (DIRECTORY_SYNC) METRIC_ADD(COUNTER_DIR_SYNCS, 1);
+                    continue;
+                }
+                for (const auto& job : jobs) failures.push_back({job.first, "Could not sync directory " + directory});
+            }
+        }
+
+        guard.lock();
+        for (const auto& job : jobs) inFlight.erase(find(inFlight.begin(), inFlight.end(), job));
+        updateCompleted();
+        writtenCount += jobs.size();
+        errors.insert(errors.end(), failures.begin(), failures.end());
+        progress.notify_all();
+        wake.notify_all();  // jobs held back behind these partitions can run now
+    }
+
+    bool recordBackup(const PersistFile& file, string& error) {
+        METRIC_STAGE(STAGE_BACKUP);
+        TRACE_SPAN("persistBackup");
+        if (!backups->backup(file.path, file.content, (int64_t)time(nullptr), error)) return false;
+        METRIC_ADD(COUNTER_BACKUPS, 1);
+        return true;
+    }
+
+    void run() {
+        unique_lock<mutex> guard(lock);
+        while (true) {
+            wake.wait(guard, [this] { return (stopping && queue.empty()) || nextRunnable() != queue.end(); });
+            if (queue.empty()) return;  // stopping with nothing left
+
+            auto next = nextRunnable();
+            PersistJob job = move(*next);
+            queue.erase(next);
+            inFlight.push_back({job.key, job.sequence});
+            progress.notify_all();
+            guard.unlock();
+
+            vector<PersistError> failures;
+            set<string> directories;
+            {
+                TRACE_SPAN_DETAIL("persistPartition", job.key);
+                for (const PersistFile& file : job.files) {
+                    directories.insert(filesystem::path(file.path).parent_path().string());
+                    string error;
+                    if (!writeAtomically(file, error)) {
+                        failures.push_back({job.key, error});
+                        continue;
+                    }
+                    METRIC_ADD(COUNTER_FILES_SAVED, 1);
+                    if (file.backup && backups && !recordBackup(file, error)) failures.push_back({job.key, error});
+                }
+            }
+
+            guard.lock();
+            errors.insert(errors.end(), failures.begin(), failures.end());
+            unsynced.push_back({job.key, job.sequence});
+            unsyncedDirectories.insert(directories.begin(), directories.end());
+            // Keep the group open while other work can still join it
+            if ((openGroups == 0 && nextRunnable() == queue.end()) || unsynced.size() >= GROUP_COMMIT_JOBS) {
+                commitGroup(guard);
+            }
+        }
+    }
+
+public:
+    explicit PersistenceWorker(BackupStore* backupStore = nullptr, size_t queueCapacity = DEFAULT_CAPACITY,
+                               size_t writerCount = DEFAULT_WRITERS)
+        : capacity(max<size_t>(1, queueCapacity)), backups(backupStore) {
+        for (size_t i = 0; i < max<size_t>(1, writerCount); i++) writers.emplace_back(&PersistenceWorker::run, this);
+    }
+
+    PersistenceWorker(const PersistenceWorker&) = delete;
+    PersistenceWorker& operator=(const PersistenceWorker&) = delete;
+
+    ~PersistenceWorker() {
+        {
+            lock_guard<mutex> guard(lock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (thread& writer : writers) writer.join();  // drains the queue first
+    }
+
+    // Queues a partition's files. Replaces the pending snapshot of the same
+    // partition if no writer has started it; otherwise waits for room.
+    void enqueue(const string& key, vector<PersistFile> files) {
+        unique_lock<mutex> guard(lock);
+        for (PersistJob& pending : queue) {
+            if (pending.key == key) {
+                pending.files = move(files);
+                coalescedCount++;
+                return;
+            }
+        }
+        progress.wait(guard, [this] { return queue.size() < capacity; });
+        queue.push_back({key, move(files), nextSequence++});
+        wake.notify_one();
+    }
+
+    // Holds the commit group open until the matching endGroup()
+    void beginGroup() {
+        lock_guard<mutex> guard(lock);
+        openGroups++;
+    }
+
+    // Closes a group; commits it here when the writers have already finished its jobs
+    void endGroup() {
+        unique_lock<mutex> guard(lock);
+        if (openGroups > 0) openGroups--;
+        if (openGroups == 0 && !unsynced.empty() && unsynced.size() == inFlight.size() &&
+            nextRunnable() == queue.end()) {
+            commitGroup(guard);
+        }
+    }
+
+    // Barrier: returns once every job queued before the call is durable
+    void flush() {
+        unique_lock<mutex> guard(lock);
+        uint64_t target = nextSequence - 1;
+        progress.wait(guard, [&] { return completedSequence >= target; });
+    }
+
+    // Waits until nothing is pending or being written for one partition, so
+    // its file can be read back
+    void waitFor(const string& key) {
+        unique_lock<mutex> guard(lock);
+        progress.wait(guard, [&] {
+            if (isInFlight(key)) return false;
+            for (const PersistJob& pending : queue) {
+                if (pending.key == key) return false;
+            }
+            return true;
+        });
+    }
+
+    // Write failures since the last call, for the UI thread to report
+    vector<PersistError> takeErrors() {
+        lock_guard<mutex> guard(lock);
+        vector<PersistError> taken;
+        taken.swap(errors);
+        return taken;
+    }
+
+    size_t pending() const {
+        lock_guard<mutex> guard(lock);
+        return queue.size() + inFlight.size();
+    }
+
+    size_t coalesced() const {
+        lock_guard<mutex> guard(lock);
+        return coalescedCount;
+    }
+
+    size_t written() const {
+        lock_guard<mutex> guard(lock);
+        return writtenCount;
+    }
+};
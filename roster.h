@@ -0,0 +1,243 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include "arena.h"
+#include "date_utils.h"
+
+// Hot attendance columns for every loaded student, one row per entry of
+// AttendanceSystem::students and in the same order. Dashboard aggregates scan
+// these parallel arrays instead of striding over whole Student objects, which
+// stay behind as the cold profile table.
+//
+// Rows are appended when a student is loaded, compacted when a section is
+// evicted, and updated in place by every attendance mark.
+
+const size_t ROSTER_SCAN_BLOCK = 256;  // percentages computed per pass
+
+// The derived columns of one row, captured before and after a mark so an
+// undo can put them back without rescanning the record
+struct RosterCounters {
+    uint32_t present = 0;
+    uint32_t recorded = 0;
+    uint32_t currentRun = 0;
+    uint32_t longestRun = 0;
+    int32_t lastDay = INT32_MIN;
+    uint8_t flags = 0;
+
+    bool operator==(const RosterCounters&) const = default;
+};
+
+class AttendanceRoster {
+public:
+    static const uint32_t NO_SLOT = UINT32_MAX;
+    static const uint8_t LAST_PRESENT = 1;  // the most recent record is a present mark
+
+private:
+    // Hot columns, indexed by row
+    vector<uint32_t> classSlots;     // index into classNames
+    vector<uint32_t> sectionSlots;   // index into sections
+    vector<uint32_t> presentCounts;
+    vector<uint32_t> recordedCounts;
+    vector<uint32_t> currentRuns;    // present marks since the last absence
+    vector<uint32_t> longestRuns;
+    vector<int32_t> lastDays;        // day number of the most recent record
+    vector<uint8_t> flags;
+
+    vector<uint32_t> classNames;                 // pooled class name per class slot
+    vector<pair<uint32_t, uint32_t>> sections;   // pooled (class, section) per section slot
+
+    // Malformed dates sort with the future so date queries re-check those rows
+    static int32_t dayKey(const string& date) {
+        int day = dayNumberFromDate(date);
+        return day == INVALID_DAY ? INT32_MAX : day;
+    }
+
+    uint32_t classSlotFor(uint32_t classId) {
+        auto it = find(classNames.begin(), classNames.end(), classId);
+        if (it != classNames.end()) return (uint32_t)(it - classNames.begin());
+        classNames.push_back(classId);
+        return (uint32_t)classNames.size() - 1;
+    }
+
+    uint32_t sectionSlotFor(uint32_t classId, uint32_t sectionId) {
+        uint32_t slot = findSection(classId, sectionId);
+        if (slot != NO_SLOT) return slot;
+        sections.push_back({classId, sectionId});
+        return (uint32_t)sections.size() - 1;
+    }
+
+public:
+    size_t size() const { return presentCounts.size(); }
+    size_t classCount() const { return classNames.size(); }
+    const string& className(uint32_t slot) const { return stringPool().get(classNames[slot]); }
+
+    uint32_t classSlot(size_t row) const { return classSlots[row]; }
+    uint32_t sectionSlot(size_t row) const { return sectionSlots[row]; }
+    uint32_t longestRun(size_t row) const { return longestRuns[row]; }
+    int32_t lastDay(size_t row) const { return lastDays[row]; }
+
+    uint32_t findSection(uint32_t classId, uint32_t sectionId) const {
+        for (size_t slot = 0; slot < sections.size(); slot++) {
+            if (sections[slot].first == classId && sections[slot].second == sectionId) return (uint32_t)slot;
+        }
+        return NO_SLOT;
+    }
+
+    // Looks the names up without interning them; NO_SLOT when no such section was ever loaded
+    uint32_t findSection(const string& className, const string& section) const {
+        uint32_t classId, sectionId;
+        if (!stringPool().lookup(className, classId) || !stringPool().lookup(section, sectionId)) return NO_SLOT;
+        return findSection(classId, sectionId);
+    }
+
+    void append(uint32_t classId, uint32_t sectionId, const FlatDateMap<bool>& record) {
+        classSlots.push_back(classSlotFor(classId));
+        sectionSlots.push_back(sectionSlotFor(classId, sectionId));
+        presentCounts.push_back(0);
+        recordedCounts.push_back(0);
+        currentRuns.push_back(0);
+        longestRuns.push_back(0);
+        lastDays.push_back(INT32_MIN);
+        flags.push_back(0);
+        refresh(size() - 1, record);
+    }
+
+    // Recomputes a row from the full record, e.g. after a past date was corrected
+    void refresh(size_t row, const FlatDateMap<bool>& record) {
+        uint32_t present = 0, run = 0, longest = 0;
+        for (const auto& entry : record.raw()) {
+            if (entry.value) {
+                present++;
+                run++;
+            } else {
+                run = 0;
+            }
+            longest = max(longest, run);
+        }
+        presentCounts[row] = present;
+        recordedCounts[row] = (uint32_t)record.size();
+        currentRuns[row] = run;
+        longestRuns[row] = longest;
+        lastDays[row] = record.empty() ? INT32_MIN : dayKey(record.raw().back().key.str());
+        flags[row] = (!record.empty() && record.raw().back().value) ? LAST_PRESENT : 0;
+    }
+
+    // A mark for a date later than every recorded one
+    void recordNewest(size_t row, const string& date, bool present) {
+        recordedCounts[row]++;
+        presentCounts[row] += present;
+        currentRuns[row] = present ? currentRuns[row] + 1 : 0;
+        longestRuns[row] = max(longestRuns[row], currentRuns[row]);
+        lastDays[row] = dayKey(date);
+        flags[row] = present ? LAST_PRESENT : 0;
+    }
+
+    RosterCounters counters(size_t row) const {
+        return {presentCounts[row], recordedCounts[row], currentRuns[row], longestRuns[row], lastDays[row], flags[row]};
+    }
+
+    void restore(size_t row, const RosterCounters& counters) {
+        presentCounts[row] = counters.present;
+        recordedCounts[row] = counters.recorded;
+        currentRuns[row] = counters.currentRun;
+        longestRuns[row] = counters.longestRun;
+        lastDays[row] = counters.lastDay;
+        flags[row] = counters.flags;
+    }
+
+    // Drops the rows of one section, keeping the order of the rest
+    void removeSection(uint32_t slot) {
+        size_t kept = 0;
+        for (size_t row = 0; row < size(); row++) {
+            if (sectionSlots[row] == slot) continue;
+            classSlots[kept] = classSlots[row];
+            sectionSlots[kept] = sectionSlots[row];
+            presentCounts[kept] = presentCounts[row];
+            recordedCounts[kept] = recordedCounts[row];
+            currentRuns[kept] = currentRuns[row];
+            longestRuns[kept] = longestRuns[row];
+            lastDays[kept] = lastDays[row];
+            flags[kept] = flags[row];
+            kept++;
+        }
+        classSlots.resize(kept);
+        sectionSlots.resize(kept);
+        presentCounts.resize(kept);
+        recordedCounts.resize(kept);
+        currentRuns.resize(kept);
+        longestRuns.resize(kept);
+        lastDays.resize(kept);
+        flags.resize(kept);
+    }
+
+    void clear() {
+        classSlots.clear();
+        sectionSlots.clear();
+        presentCounts.clear();
+        recordedCounts.clear();
+        currentRuns.clear();
+        longestRuns.clear();
+        lastDays.clear();
+        flags.clear();
+    }
+
+    float percentage(size_t row) const {
+        if (recordedCounts[row] == 0) return 0.0f;
+        return (float)presentCounts[row] / recordedCounts[row] * 100;
+    }
+
+    // Calls visit(row, percentage) for every row in order. Percentages are
+    // computed a block at a time in a branch-free loop the compiler can
+    // vectorize; the caller's accumulation stays in row order so float sums
+    // match a per-student loop exactly.
+    template <typename Visit>
+    void scanPercentages(Visit&& visit) const {
+        float block[ROSTER_SCAN_BLOCK];
+        const uint32_t* present = presentCounts.data();
+        const uint32_t* recorded = recordedCounts.data();
+        for (size_t begin = 0; begin < size(); begin += ROSTER_SCAN_BLOCK) {
+            size_t n = min(ROSTER_SCAN_BLOCK, size() - begin);
+            for (size_t i = 0; i < n; i++) {
+                float total = (float)recorded[begin + i];
+                float ratio = (float)present[begin + i] / (total > 0 ? total : 1.0f) * 100;
+                block[i] = total > 0 ? ratio : 0.0f;
+            }
+            for (size_t i = 0; i < n; i++) visit(begin + i, block[i]);
+        }
+    }
+
+    // Same as scanPercentages, restricted to one section slot
+    template <typename Visit>
+    void scanSection(uint32_t slot, Visit&& visit) const {
+        for (size_t row = 0; row < size(); row++) {
+            if (sectionSlots[row] == slot) visit(row, percentage(row));
+        }
+    }
+
+    // Rows whose most recent record is a present mark on this day. Rows with a
+    // record after the day (or a malformed date) cannot be answered from the
+    // roster and are counted in `unresolved` for the caller to check.
+    size_t countPresentOn(int day, size_t& unresolved) const {
+        size_t present = 0, later = 0;
+        const int32_t* last = lastDays.data();
+        const uint8_t* flag = flags.data();
+        for (size_t row = 0; row < size(); row++) {
+            present += (last[row] == day) & (flag[row] & LAST_PRESENT);
+            later += last[row] > day;
+        }
+        unresolved = later;
+        return present;
+    }
+
+    // Heap held by the columns and slot tables
+    size_t memoryBytes() const {
+        return classSlots.capacity() * sizeof(uint32_t) + sectionSlots.capacity() * sizeof(uint32_t) +
+               presentCounts.capacity() * sizeof(uint32_t) + recordedCounts.capacity() * sizeof(uint32_t) +
+               currentRuns.capacity() * sizeof(uint32_t) + longestRuns.capacity() * sizeof(uint32_t) +
+               lastDays.capacity() * sizeof(int32_t) + flags.capacity() * sizeof(uint8_t) +
+               classNames.capacity() * sizeof(uint32_t) + sections.capacity() * sizeof(pair<uint32_t, uint32_t>);
+    }
+};
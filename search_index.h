@@ -0,0 +1,424 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+
+// School-wide student lookup: a trigram inverted index over names, parent
+// names, contact numbers and roll numbers. A query is split into words and
+// every word is matched against the start of a field word, allowing a few
+// typos (insertions, deletions, substitutions, swapped neighbours) that grows
+// with the word length. Trigram hit counts pick the candidates; a banded edit
+// distance confirms them and gives the rank. Candidates are verified most hits
+// first, at most SEARCH_MAX_VERIFIED of them, and the search stops once limit
+// students match without typos. One- and two-character queries have no typo
+// budget and are read straight off the posting list of their leading trigram.
+//
+// Postings point at distinct field texts rather than students, so a name
+// shared by a hundred students is counted and verified once. Documents are
+// never erased: retiring a student (their section was evicted) hides the
+// document until the same student is added again, and re-adding a student
+// with changed fields retires the old document for a new one.
+// search() reuses scratch buffers, so one index must not be searched from two
+// threads at once.
+
+enum SearchField { FIELD_NAME, FIELD_ROLL, FIELD_PARENT, FIELD_CONTACT, SEARCH_FIELD_COUNT };
+
+const char* const SEARCH_FIELD_NAMES[SEARCH_FIELD_COUNT] = {"name", "roll no", "parent", "contact"};
+const size_t SEARCH_MAX_WORD = 32;  // longer words are compared on their first 32 characters
+const size_t SEARCH_MAX_VERIFIED = 1024;  // edit-distance checks per search, most trigram hits first
+const size_t SEARCH_SHORT_QUERY = 2;      // queries this short are answered from one posting list
+
+struct SearchDocument {
+    string uniqueId;
+    string className;
+    string section;
+    string rollNo;
+    string name;
+    uint32_t texts[SEARCH_FIELD_COUNT];  // field text ids
+    bool live = true;
+};
+
+struct SearchHit {
+    uint32_t doc;
+    SearchField field;
+    int distance;   // total typos across the query words
+    int score;      // lower ranks first
+};
+
+class StudentSearchIndex {
+private:
+    struct FieldText {
+        SearchField field;
+        string text;             // normalized
+        vector<uint32_t> docs;   // documents using this text, ascending
+        uint32_t liveDocs = 0;   // how many of them are live
+    };
+
+    vector<SearchDocument> docs;
+    unordered_map<string, uint32_t> byUniqueId;
+    vector<FieldText> texts;
+    unordered_map<string, uint32_t> textIds[SEARCH_FIELD_COUNT];
+    unordered_map<uint32_t, vector<uint32_t>> postings;  // trigram -> ascending text ids
+    size_t liveDocs = 0;
+
+    vector<uint16_t> hitCounts;   // per text id, zero between searches
+    vector<uint32_t> touched;
+
+    static uint32_t trigramKey(unsigned char a, unsigned char b, unsigned char c) {
+        return (uint32_t)a << 16 | (uint32_t)b << 8 | c;
+    }
+
+    // Words are padded with two leading spaces so prefixes have trigrams of
+    // their own; a trailing space marks a complete word
+    static void addTrigrams(string_view word, bool complete, vector<uint32_t>& out) {
+        string padded = "  " + string(word.substr(0, SEARCH_MAX_WORD)) + (complete ? " " : "");
+        for (size_t i = 0; i + 3 <= padded.size(); i++) {
+            out.push_back(trigramKey(padded[i], padded[i + 1], padded[i + 2]));
+        }
+    }
+
+    static int typoBudget(size_t length) {
+        if (length <= 3) return 0;
+        if (length <= 6) return 1;
+        return 2;
+    }
+
+    // Fewest edits turning `query` into some prefix of `word` (optimal string
+    // alignment), or limit + 1 once it must exceed limit
+    static int prefixDistance(string_view query, string_view word, int limit) {
+        const int INF = limit + 1;
+        int m = (int)min(query.size(), SEARCH_MAX_WORD);
+        int n = (int)min(word.size(), SEARCH_MAX_WORD);
+        if (n < m - limit) return INF;
+
+        int rows[3][SEARCH_MAX_WORD + 1];
+        int* before = rows[0];
+        int* previous = rows[1];
+        int* current = rows[2];
+        for (int j = 0; j <= n; j++) previous[j] = j <= limit ? j : INF;
+
+        for (int i = 1; i <= m; i++) {
+            int low = max(1, i - limit), high = min(n, i + limit);
+            int rowMin = INF;
+            current[0] = i <= limit ? i : INF;
+            for (int j = 1; j < low; j++) current[j] = INF;
+            for (int j = low; j <= high; j++) {
+                int cost = query[i - 1] == word[j - 1] ? 0 : 1;
+                int best = min({previous[j - 1] + cost, previous[j] + 1, current[j - 1] + 1});
+                if (i > 1 && j > 1 && query[i - 1] == word[j - 2] && query[i - 2] == word[j - 1]) {
+                    best = min(best, before[j - 2] + 1);
+                }
+                current[j] = min(best, INF);
+                rowMin = min(rowMin, current[j]);
+            }
+            for (int j = high + 1; j <= n; j++) current[j] = INF;
+            if (rowMin > limit && current[0] > limit) return INF;
+            int* recycled = before;
+            before = previous;
+            previous = current;
+            current = recycled;
+        }
+
+        int best = INF;
+        for (int j = max(0, m - limit); j <= min(n, m + limit); j++) best = min(best, previous[j]);
+        return best;
+    }
+
+    // Typos needed to match every query word against this field, or -1
+    static int matchField(const vector<string_view>& queryWords, const vector<int>& budgets,
+                          const string& fieldText, int& wholeWords) {
+        vector<string_view> fieldWords = splitWords(fieldText);
+        int total = 0;
+        wholeWords = 0;
+        for (size_t i = 0; i < queryWords.size(); i++) {
+            int best = budgets[i] + 1;
+            bool whole = false;
+            for (string_view word : fieldWords) {
+                int distance = prefixDistance(queryWords[i], word, budgets[i]);
+                bool exact = distance == 0 && word.size() == queryWords[i].size();
+                if (distance < best || (distance == best && exact && !whole)) {
+                    best = distance;
+                    whole = exact;
+                }
+            }
+            if (best > budgets[i]) return -1;
+            total += best;
+            if (whole) wholeWords++;
+        }
+        return total;
+    }
+
+    uint32_t textFor(SearchField field, const string& text) {
+        auto found = textIds[field].find(text);
+        if (found != textIds[field].end()) return found->second;
+
+        uint32_t id = (uint32_t)texts.size();
+        texts.push_back({field, text, {}, 0});
+        textIds[field].emplace(text, id);
+        hitCounts.push_back(0);
+
+        vector<uint32_t> keys;
+        for (string_view word : splitWords(text)) addTrigrams(word, true, keys);
+        sort(keys.begin(), keys.end());
+        keys.erase(unique(keys.begin(), keys.end()), keys.end());
+        for (uint32_t key : keys) postings[key].push_back(id);
+        return id;
+    }
+
+    // Texts with a word starting with a one- or two-character query: whole
+    // words first, then by field, then in index order. Roll numbers must
+    // match whole; no edit distance is computed.
+    vector<SearchHit> searchShort(const string& text, size_t limit) {
+        // The last trigram of the padded word marks a word start; with a
+        // trailing space it marks a word end, so a text in both lists
+        // probably holds the whole word
+        vector<uint32_t> keys;
+        addTrigrams(text, true, keys);
+        auto found = postings.find(keys[keys.size() - 2]);
+        if (found == postings.end()) return {};
+        static const vector<uint32_t> none;
+        auto ending = postings.find(keys.back());
+        const vector<uint32_t>& ends = ending == postings.end() ? none : ending->second;
+
+        vector<uint32_t> ranked[2][SEARCH_FIELD_COUNT];  // [prefix only][field]
+        size_t next = 0;
+        for (uint32_t id : found->second) {
+            while (next < ends.size() && ends[next] < id) next++;
+            bool whole = false;
+            if (next < ends.size() && ends[next] == id) {
+                vector<string_view> words = splitWords(texts[id].text);
+                whole = find(words.begin(), words.end(), string_view(text)) != words.end();
+            }
+            if (texts[id].field == FIELD_ROLL && !whole) continue;
+            ranked[!whole][texts[id].field].push_back(id);
+        }
+
+        vector<SearchHit> hits;
+        for (int prefix = 0; prefix < 2; prefix++) {
+            for (int field = 0; field < SEARCH_FIELD_COUNT; field++) {
+                vector<uint32_t>& ids = ranked[prefix][field];
+                if (!prefix) {
+                    sort(ids.begin(), ids.end(), [this](uint32_t a, uint32_t b) { return texts[a].text < texts[b].text; });
+                }
+                for (uint32_t id : ids) {
+                    if (hits.size() == limit) return hits;
+                    appendDocs(id, 0, prefix * 10 + field, limit, hits);
+                }
+            }
+        }
+        return hits;
+    }
+
+    void setLive(SearchDocument& doc, bool live) {
+        if (doc.live == live) return;
+        doc.live = live;
+        for (uint32_t text : doc.texts) live ? texts[text].liveDocs++ : texts[text].liveDocs--;
+        live ? liveDocs++ : liveDocs--;
+    }
+
+    // Adds the live students of one matched text, by unique id, skipping
+    // students already hit; returns how many were added
+    size_t appendDocs(uint32_t text, int distance, int score, size_t limit, vector<SearchHit>& hits) {
+        vector<uint32_t> group;
+        for (uint32_t doc : texts[text].docs) {
+            if (!docs[doc].live) continue;
+            if (any_of(hits.begin(), hits.end(), [doc](const SearchHit& hit) { return hit.doc == doc; })) continue;
+            group.push_back(doc);
+        }
+        size_t take = min(limit - hits.size(), group.size());
+        partial_sort(group.begin(), group.begin() + take, group.end(), [this](uint32_t a, uint32_t b) {
+            return docs[a].uniqueId < docs[b].uniqueId;
+        });
+        for (size_t i = 0; i < take; i++) {
+            hits.push_back({group[i], texts[text].field, distance, score});
+        }
+        return take;
+    }
+
+public:
+    // Lower-cases letters and digits and turns everything else into single spaces
+    static string normalize(string_view text) {
+        string result;
+        result.reserve(text.size());
+        for (char c : text) {
+            if (isalnum((unsigned char)c)) result += (char)tolower((unsigned char)c);
+            else if (!result.empty() && result.back() != ' ') result += ' ';
+        }
+        if (!result.empty() && result.back() == ' ') result.pop_back();
+        return result;
+    }
+
+    static vector<string_view> splitWords(string_view text) {
+        vector<string_view> words;
+        size_t start = 0;
+        while (start < text.size()) {
+            size_t end = text.find(' ', start);
+            if (end == string_view::npos) end = text.size();
+            if (end > start) words.push_back(text.substr(start, end - start));
+            start = end + 1;
+        }
+        return words;
+    }
+
+    // Adds a student, or replaces the document of a student already indexed
+    void add(const string& uniqueId, const string& className, const string& section, const string& rollNo,
+             const string& name, const string& parentName, const string& contact) {
+        uint32_t ids[SEARCH_FIELD_COUNT];
+        ids[FIELD_NAME] = textFor(FIELD_NAME, normalize(name));
+        ids[FIELD_ROLL] = textFor(FIELD_ROLL, normalize(rollNo));
+        ids[FIELD_PARENT] = textFor(FIELD_PARENT, normalize(parentName));
+        ids[FIELD_CONTACT] = textFor(FIELD_CONTACT, normalize(contact));
+
+        auto existing = byUniqueId.find(uniqueId);
+        if (existing != byUniqueId.end()) {
+            SearchDocument& current = docs[existing->second];
+            bool unchanged = equal(begin(ids), end(ids), begin(current.texts)) && current.name == name;
+            setLive(current, unchanged);
+            if (unchanged) return;
+        }
+
+        uint32_t id = (uint32_t)docs.size();
+        SearchDocument doc;
+        doc.uniqueId = uniqueId;
+        doc.className = className;
+        doc.section = section;
+        doc.rollNo = rollNo;
+        doc.name = name;
+        copy(begin(ids), end(ids), begin(doc.texts));
+        doc.live = false;
+        docs.push_back(move(doc));
+        byUniqueId[uniqueId] = id;
+        for (uint32_t text : ids) texts[text].docs.push_back(id);
+        setLive(docs.back(), true);
+    }
+
+    // Hides a student from search until they are added again
+    void retire(const string& uniqueId) {
+        auto existing = byUniqueId.find(uniqueId);
+        if (existing != byUniqueId.end()) setLive(docs[existing->second], false);
+    }
+
+    // Ranked matches: fewest typos first, then whole-word matches, then by
+    // field (name, roll no, parent, contact), matched text and unique id
+    vector<SearchHit> search(const string& query, size_t limit = 10) {
+        string text = normalize(query);
+        vector<string_view> queryWords = splitWords(text);
+        if (queryWords.empty() || limit == 0) return {};
+        if (text.size() <= SEARCH_SHORT_QUERY) return searchShort(text, limit);
+
+        vector<int> budgets;
+        vector<uint32_t> keys;
+        int totalBudget = 0;
+        for (size_t i = 0; i < queryWords.size(); i++) {
+            budgets.push_back(typoBudget(queryWords[i].size()));
+            totalBudget += budgets.back();
+            addTrigrams(queryWords[i], i + 1 < queryWords.size(), keys);  // the last word may be unfinished
+        }
+        sort(keys.begin(), keys.end());
+        keys.erase(unique(keys.begin(), keys.end()), keys.end());
+
+        // Each typo breaks at most three trigrams, but a text sharing only one
+        // trigram (usually the first letter) is never worth an edit distance.
+        // A run of digits is looked for anywhere in a contact number, so it
+        // needs all its inner trigrams.
+        bool digits = all_of(text.begin(), text.end(), [](char c) { return isdigit((unsigned char)c); });
+        int maxHits = (int)keys.size();
+        int threshold = max({1, maxHits - 3 * totalBudget, min(maxHits, 2)});
+        int digitThreshold = max(1, (int)text.size() - 2);
+
+        for (uint32_t key : keys) {
+            auto found = postings.find(key);
+            if (found == postings.end()) continue;
+            for (uint32_t id : found->second) {
+                if (hitCounts[id]++ == 0) touched.push_back(id);
+            }
+        }
+
+        // Counting sort by hit count, most hits first, keeping id order within
+        // a count; only texts that can pass some check are kept
+        int lowest = min(threshold, digits ? digitThreshold : threshold);
+        vector<uint32_t> bucketStart(maxHits + 2, 0);
+        for (uint32_t id : touched) {
+            if (hitCounts[id] >= lowest || texts[id].field == FIELD_ROLL) bucketStart[maxHits - hitCounts[id] + 1]++;
+        }
+        for (int i = 1; i <= maxHits + 1; i++) bucketStart[i] += bucketStart[i - 1];
+        vector<uint32_t> ordered(bucketStart[maxHits + 1]);
+        vector<int> orderedHits(ordered.size());
+        for (uint32_t id : touched) {
+            int hits = hitCounts[id];
+            hitCounts[id] = 0;
+            if (hits < lowest && texts[id].field != FIELD_ROLL) continue;
+            size_t slot = bucketStart[maxHits - hits]++;
+            ordered[slot] = id;
+            orderedHits[slot] = hits;
+        }
+        touched.clear();
+
+        struct TextMatch {
+            uint32_t text;
+            int distance;
+            int score;
+        };
+        vector<TextMatch> matches;
+        size_t verified = 0, exactDocs = 0;
+        for (size_t i = 0; i < ordered.size(); i++) {
+            int hits = orderedHits[i];
+            // Stop between hit counts once enough students match without typos
+            if (i > 0 && hits != orderedHits[i - 1] && exactDocs >= limit) break;
+
+            const FieldText& candidate = texts[ordered[i]];
+            if (candidate.liveDocs == 0) continue;
+            int distance = -1, wholeWords = 0;
+            if (candidate.field == FIELD_ROLL) {
+                if (candidate.text == text) distance = 0;
+                wholeWords = (int)queryWords.size();
+            } else if (candidate.field == FIELD_CONTACT && digits) {
+                // any run of digits, e.g. the last four of a phone number
+                if (hits >= digitThreshold && candidate.text.find(text) != string::npos) distance = 0;
+            } else if (hits >= threshold && verified < SEARCH_MAX_VERIFIED) {
+                verified++;
+                distance = matchField(queryWords, budgets, candidate.text, wholeWords);
+            }
+            if (distance < 0) continue;
+            int score = distance * 100 + ((int)queryWords.size() - wholeWords) * 10 + candidate.field;
+            matches.push_back({ordered[i], distance, score});
+            if (distance == 0) exactDocs += candidate.liveDocs;
+        }
+
+        sort(matches.begin(), matches.end(), [this](const TextMatch& a, const TextMatch& b) {
+            if (a.score != b.score) return a.score < b.score;
+            return texts[a.text].text < texts[b.text].text;
+        });
+
+        // Walk texts best first; a student matching several fields keeps its best
+        vector<SearchHit> hits;
+        for (const TextMatch& match : matches) {
+            if (hits.size() == limit) break;
+            appendDocs(match.text, match.distance, match.score, limit, hits);
+        }
+        return hits;
+    }
+
+    const SearchDocument& document(uint32_t id) const { return docs[id]; }
+    size_t size() const { return liveDocs; }  // live students
+
+    // Approximate heap held by documents, field texts, postings and scratch
+    size_t memoryBytes() const {
+        auto heapText = [](const string& text) { return text.capacity() >= sizeof(string) ? text.capacity() + 1 : 0; };
+        size_t bytes = docs.capacity() * sizeof(SearchDocument) + texts.capacity() * sizeof(FieldText) +
+                       hitCounts.capacity() * sizeof(uint16_t) + touched.capacity() * sizeof(uint32_t);
+        for (const auto& doc : docs) {
+            for (const string* text : {&doc.uniqueId, &doc.className, &doc.section, &doc.rollNo, &doc.name}) {
+                bytes += heapText(*text);
+            }
+        }
+        for (const auto& text : texts) bytes += heapText(text.text) + text.docs.capacity() * sizeof(uint32_t);
+        for (const auto& list : postings) bytes += list.second.capacity() * sizeof(uint32_t) + 32;
+        bytes += (byUniqueId.size() + texts.size()) * (sizeof(string) + 32);
+        return bytes;
+    }
+};
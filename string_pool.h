@@ -0,0 +1,78 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+
+// Process-wide string interning. Values that repeat across students (class,
+// section, gender, bus route, attendance remarks, subject names) are stored
+// once and referenced by a 32-bit id. Ids are never reused, and get() takes
+// no lock, so parallel report workers can resolve ids while the UI thread
+// interns new values.
+
+class StringPool {
+private:
+    static const uint32_t CHUNK_BITS = 10;
+    static const uint32_t CHUNK_SIZE = 1u << CHUNK_BITS;
+    static const uint32_t MAX_CHUNKS = 4096;     // 4M distinct strings
+
+    unique_ptr<string[]> chunks[MAX_CHUNKS];     // stable storage; a chunk never moves once published
+    atomic<uint32_t> count{0};
+    unordered_map<string_view, uint32_t> index; // views point into chunks
+    mutable mutex lock;
+    size_t textBytes = 0;
+
+public:
+    static constexpr uint32_t EMPTY_ID = 0;
+
+    StringPool() { intern(""); }
+
+    uint32_t intern(string_view value) {
+        lock_guard<mutex> guard(lock);
+        auto found = index.find(value);
+        if (found != index.end()) return found->second;
+
+        uint32_t id = count.load(memory_order_relaxed);
+        if (id >= MAX_CHUNKS * CHUNK_SIZE) throw length_error("string pool is full");
+        unique_ptr<string[]>& chunk = chunks[id >> CHUNK_BITS];
+        if (!chunk) chunk = make_unique<string[]>(CHUNK_SIZE);
+        string& slot = chunk[id & (CHUNK_SIZE - 1)];
+        slot.assign(value.data(), value.size());
+        index.emplace(string_view(slot), id);
+        if (slot.capacity() >= sizeof(string)) textBytes += slot.capacity() + 1;  // beyond the inline buffer
+        count.store(id + 1, memory_order_release);
+        return id;
+    }
+
+    const string& get(uint32_t id) const {
+        return chunks[id >> CHUNK_BITS][id & (CHUNK_SIZE - 1)];
+    }
+
+    // Returns false and leaves id untouched when the value was never interned
+    bool lookup(string_view value, uint32_t& id) const {
+        lock_guard<mutex> guard(lock);
+        auto found = index.find(value);
+        if (found == index.end()) return false;
+        id = found->second;
+        return true;
+    }
+
+    size_t size() const { return count.load(memory_order_acquire); }
+
+    // Bytes held by the pool: slots, string text and the hash index
+    size_t memoryBytes() const {
+        lock_guard<mutex> guard(lock);
+        size_t chunkCount = (count.load(memory_order_relaxed) + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        return chunkCount * CHUNK_SIZE * sizeof(string) + textBytes +
+               index.size() * (sizeof(void*) + sizeof(pair<string_view, uint32_t>)) +
+               index.bucket_count() * sizeof(void*);
+    }
+};
+
+inline StringPool& stringPool() {
+    static StringPool pool;
+    return pool;
+}
@@ -0,0 +1,222 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <cstdint>
+
+// Scoped trace spans written as Chrome Trace Event JSON (chrome://tracing,
+// Perfetto). Recording is off unless the ATTENDANCE_TRACE environment
+// variable is set, either to an output path or to "1" for
+// attendance_trace.json. The file is written at exit or by traceFlush().
+//
+// Each thread appends complete ("X") events to its own chain of fixed-size
+// blocks and publishes the count with a release store. Writers never take a
+// lock after their first span; nesting is recovered by the viewer from the
+// timestamps on each thread.
+
+const size_t TRACE_BLOCK_EVENTS = 4096;
+const size_t TRACE_MAX_BLOCKS_PER_THREAD = 256;  // ~1M spans per thread, then spans are dropped
+const size_t TRACE_DETAIL_LENGTH = 23;
+
+struct TraceEvent {
+    const char* name;                       // must be a string literal
+    uint64_t startNs;
+    uint64_t durationNs;
+    char detail[TRACE_DETAIL_LENGTH + 1];
+};
+
+// Copies at most TRACE_DETAIL_LENGTH bytes of text and terminates it
+inline void copyTraceDetail(char* to, const char* text, size_t length) {
+    length = std::min(length, TRACE_DETAIL_LENGTH);
+    memcpy(to, text, length);
+    to[length] = '\0';
+}
+
+struct TraceBlock {
+    TraceEvent events[TRACE_BLOCK_EVENTS];
+    std::atomic<size_t> count{0};
+    std::atomic<TraceBlock*> next{nullptr};
+};
+
+struct ThreadTrace {
+    int tid = 0;
+    std::string name;
+    TraceBlock* head = nullptr;
+    TraceBlock* tail = nullptr;             // only touched by the owning thread
+    size_t blocks = 0;
+    std::atomic<uint64_t> dropped{0};
+};
+
+class TraceRecorder {
+private:
+    std::mutex lock;
+    std::vector<std::unique_ptr<ThreadTrace>> threads;
+    std::vector<std::unique_ptr<TraceBlock>> blocks;
+    std::string outputPath;
+    std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    std::thread::id mainThread = std::this_thread::get_id();  // the recorder is created on first use
+
+    TraceBlock* allocateBlock() {
+        std::lock_guard<std::mutex> guard(lock);
+        blocks.push_back(std::make_unique<TraceBlock>());
+        return blocks.back().get();
+    }
+
+    static void writeEscaped(std::ofstream& out, const char* text) {
+        for (; *text; text++) {
+            char c = *text;
+            if (c == '"' || c == '\\') out << '\\' << c;
+            else if ((unsigned char)c >= 0x20) out << c;
+        }
+    }
+
+public:
+    const bool enabled;
+
+    TraceRecorder() : enabled(getenv("ATTENDANCE_TRACE") != nullptr) {
+        if (enabled) {
+            std::string value = getenv("ATTENDANCE_TRACE");
+            outputPath = (value.empty() || value == "1") ? "attendance_trace.json" : value;
+        }
+    }
+
+    ~TraceRecorder() {
+        if (enabled) flush();
+    }
+
+    uint64_t now() const {
+        auto elapsed = std::chrono::steady_clock::now() - epoch;
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    }
+
+    ThreadTrace& local() {
+        thread_local ThreadTrace* mine = nullptr;
+        if (!mine) {
+            std::lock_guard<std::mutex> guard(lock);
+            threads.push_back(std::make_unique<ThreadTrace>());
+            mine = threads.back().get();
+            mine->tid = (int)threads.size();
+            mine->name = std::this_thread::get_id() == mainThread ? "main" : "worker " + std::to_string(mine->tid);
+        }
+        return *mine;
+    }
+
+    void record(const char* name, uint64_t startNs, uint64_t endNs, const char* detail) {
+        ThreadTrace& thread = local();
+        TraceBlock* block = thread.tail;
+        if (!block || block->count.load(std::memory_order_relaxed) == TRACE_BLOCK_EVENTS) {
+            if (thread.blocks == TRACE_MAX_BLOCKS_PER_THREAD) {
+                thread.dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            TraceBlock* fresh = allocateBlock();
+            thread.blocks++;
+            if (block) block->next.store(fresh, std::memory_order_release);
+            else {
+                std::lock_guard<std::mutex> guard(lock);  // head is read by flush()
+                thread.head = fresh;
+            }
+            thread.tail = block = fresh;
+        }
+        size_t index = block->count.load(std::memory_order_relaxed);
+        TraceEvent& event = block->events[index];
+        event.name = name;
+        event.startNs = startNs;
+        event.durationNs = endNs - startNs;
+        copyTraceDetail(event.detail, detail, strlen(detail));
+        block->count.store(index + 1, std::memory_order_release);
+    }
+
+    // Writes every span published so far; safe to call while threads are recording
+    bool flush() {
+        if (!enabled) return false;
+        std::string temp = outputPath + ".tmp";
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) return false;
+
+        std::lock_guard<std::mutex> guard(lock);
+        out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n"
+            << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"args\": {\"name\": \"attendance_system\"}}";
+        char timing[64];
+        for (const auto& thread : threads) {
+            out << ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << thread->tid
+                << ", \"args\": {\"name\": \"" << thread->name << "\"}}";
+            for (TraceBlock* block = thread->head; block; block = block->next.load(std::memory_order_acquire)) {
+                size_t count = block->count.load(std::memory_order_acquire);
+                for (size_t i = 0; i < count; i++) {
+                    const TraceEvent& event = block->events[i];
+                    snprintf(timing, sizeof(timing), "%.3f, \"dur\": %.3f",
+                             event.startNs / 1000.0, event.durationNs / 1000.0);
+                    out << ",\n{\"name\": \"";
+                    writeEscaped(out, event.name);
+                    out << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << thread->tid << ", \"ts\": " << timing;
+                    if (event.detail[0]) {
+                        out << ", \"args\": {\"detail\": \"";
+                        writeEscaped(out, event.detail);
+                        out << "\"}";
+                    }
+                    out << "}";
+                }
+            }
+            uint64_t dropped = thread->dropped.load(std::memory_order_relaxed);
+            if (dropped) {
+                out << ",\n{\"name\": \"spans_dropped\", \"ph\": \"C\", \"pid\": 1, \"tid\": " << thread->tid
+                    << ", \"ts\": 0, \"args\": {\"count\": " << dropped << "}}";
+            }
+        }
+        out << "\n]}\n";
+        out.close();
+        return rename(temp.c_str(), outputPath.c_str()) == 0 ||
+               (remove(outputPath.c_str()) == 0 && rename(temp.c_str(), outputPath.c_str()) == 0);
+    }
+};
+
+inline TraceRecorder& traceRecorder() {
+    static TraceRecorder recorder;
+    return recorder;
+}
+
+inline bool traceFlush() { return traceRecorder().flush(); }
+
+class TraceSpan {
+private:
+    const char* name;
+    uint64_t start = 0;
+    char detail[TRACE_DETAIL_LENGTH + 1] = "";
+    bool active;
+
+public:
+    explicit TraceSpan(const char* spanName) : name(spanName), active(traceRecorder().enabled) {
+        if (active) start = traceRecorder().now();
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+    bool isActive() const { return active; }
+
+    void setDetail(const std::string& text) {
+        copyTraceDetail(detail, text.data(), text.size());
+    }
+
+    ~TraceSpan() {
+        if (active) traceRecorder().record(name, start, traceRecorder().now(), detail);
+    }
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SPAN(name) TraceSpan TRACE_CONCAT(traceSpan_, __LINE__)(name)
+// The detail expression is only evaluated while tracing is on
+#define TRACE_SPAN_DETAIL(name, detailExpr) \
+    TraceSpan TRACE_CONCAT(traceSpan_, __LINE__)(name); \
+    if (TRACE_CONCAT(traceSpan_, __LINE__).isActive()) TRACE_CONCAT(traceSpan_, __LINE__).setDetail(detailExpr)
@@ -0,0 +1,74 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+
+// LEB128 varints and little-endian fixed-width helpers shared by the
+// binary file formats (columnar export, archive segments, indexes).
+
+inline void putVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back((char)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((char)value);
+}
+
+inline void putSignedVarint(std::string& out, int64_t value) {
+    putVarint(out, ((uint64_t)value << 1) ^ (uint64_t)(value >> 63));  // zigzag
+}
+
+inline bool getVarint(const char*& pos, const char* end, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; pos < end && shift < 64; shift += 7) {
+        uint8_t byte = (uint8_t)*pos++;
+        value |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+inline bool getSignedVarint(const char*& pos, const char* end, int64_t& value) {
+    uint64_t raw;
+    if (!getVarint(pos, end, raw)) return false;
+    value = (int64_t)(raw >> 1) ^ -(int64_t)(raw & 1);
+    return true;
+}
+
+inline void putFixed32(std::string& out, uint32_t value) {
+    char buffer[4];
+    for (int i = 0; i < 4; i++) buffer[i] = (char)(value >> (8 * i));
+    out.append(buffer, 4);
+}
+
+inline void putFixed64(std::string& out, uint64_t value) {
+    char buffer[8];
+    for (int i = 0; i < 8; i++) buffer[i] = (char)(value >> (8 * i));
+    out.append(buffer, 8);
+}
+
+inline uint32_t getFixed32(const char* pos) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++) value |= (uint32_t)(uint8_t)pos[i] << (8 * i);
+    return value;
+}
+
+inline uint64_t getFixed64(const char* pos) {
+    uint64_t value = 0;
+    for (int i = 0; i < 8; i++) value |= (uint64_t)(uint8_t)pos[i] << (8 * i);
+    return value;
+}
+
+inline void putLengthPrefixed(std::string& out, const std::string& value) {
+    putVarint(out, value.size());
+    out += value;
+}
+
+inline bool getLengthPrefixed(const char*& pos, const char* end, std::string& value) {
+    uint64_t length;
+    if (!getVarint(pos, end, length) || (uint64_t)(end - pos) < length) return false;
+    value.assign(pos, (size_t)length);
+    pos += length;
+    return true;
+}